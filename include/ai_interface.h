@@ -1,5 +1,6 @@
 #pragma once
 
+#include "decision_deadline.h"
 #include "game_types.h"
 #include "visible_area.h"
 
@@ -15,4 +16,11 @@ class AIInterface {
     // visibleArea: 当前可见区域（以角色为中心的7x7网格）
     // 返回：Action对象，包含移动方向
     virtual Action getAction(const VisibleArea &visibleArea) = 0;
+
+    // 带截止时间的决策：回合循环启用思考时间预算时调用此方法，默认直接调用 getAction
+    // 需要长时间思考的 AI 可以重写它，定期检查 deadline.expired() 并在到期前返回；超时的决策按 STAY 处理
+    virtual Action getActionWithDeadline(const VisibleArea &visibleArea, const DecisionDeadline &deadline) {
+        (void)deadline;
+        return getAction(visibleArea);
+    }
 };
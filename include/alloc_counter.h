@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstdint>
+
+// 堆分配计数
+// 由 src/tools/alloc_hook.cpp 替换全局 operator new/delete 实现，
+// 只链接进基准测试和模拟器等工具程序，游戏本体和核心库不受影响
+namespace AllocCounter {
+// 进程启动以来的 operator new 调用次数（所有线程合计）
+uint64_t allocationCount();
+
+// 进程启动以来通过 operator new 申请的总字节数
+uint64_t allocatedBytes();
+} // namespace AllocCounter
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+// 二进制读写工具：所有多字节整数一律按小端序存放，与运行平台的字节序无关
+// 回放文件和二进制存档共用
+
+class ByteWriter {
+  private:
+    std::vector<uint8_t> buffer;
+
+  public:
+    void writeU8(uint8_t value) { buffer.push_back(value); }
+    void writeU16(uint16_t value);
+    void writeU32(uint32_t value);
+    void writeU64(uint64_t value);
+    void writeI32(int32_t value) { writeU32(static_cast<uint32_t>(value)); }
+    void writeBytes(const void *data, size_t size);
+
+    // 回填：覆盖 offset 处已经写入的 4 字节
+    void patchU32(size_t offset, uint32_t value);
+
+    size_t size() const { return buffer.size(); }
+    const std::vector<uint8_t> &data() const { return buffer; }
+    std::vector<uint8_t> release() { return std::move(buffer); }
+};
+
+// 从一段只读内存中顺序读取；越界时读取失败并保持失败状态，调用者在一组读取后检查 ok()
+class ByteReader {
+  private:
+    const uint8_t *begin;
+    size_t length;
+    size_t position;
+    bool valid;
+
+    bool require(size_t count);
+
+  public:
+    ByteReader(const void *data, size_t size);
+
+    uint8_t readU8();
+    uint16_t readU16();
+    uint32_t readU32();
+    uint64_t readU64();
+    int32_t readI32() { return static_cast<int32_t>(readU32()); }
+
+    // 返回指向内部数据的指针（不拷贝），越界时返回 nullptr
+    const uint8_t *readBytes(size_t count);
+    bool skip(size_t count) { return readBytes(count) != nullptr || count == 0; }
+
+    bool ok() const { return valid; }
+    size_t tell() const { return position; }
+    size_t remaining() const { return length - position; }
+    bool seek(size_t offset);
+};
+
+// CRC-32（IEEE 802.3 多项式，与 zlib 相同），按 8 字节一组查表；crc 传入上一段的结果可分段计算
+uint32_t crc32(const void *data, size_t size, uint32_t crc = 0);
+
+// 读写整个文件
+bool writeFileBytes(const std::string &filename, const std::vector<uint8_t> &bytes);
+bool readFileBytes(const std::string &filename, std::vector<uint8_t> &bytes);
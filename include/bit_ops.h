@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// 位平面（每个单元格一位、按 64 位字打包）上的批量运算
+// 在支持 AVX2 的 x86-64 CPU 上运行时自动选择 AVX2 实现，否则使用可移植实现
+namespace BitOps {
+
+// 统计 words[0..count) 中置位的总数（按运行时检测结果分派）
+uint64_t popcount(const uint64_t *words, size_t count);
+
+// 可移植实现，任何平台可用
+uint64_t popcountPortable(const uint64_t *words, size_t count);
+
+// AVX2 实现；hasAvx2() 为 false 时不可调用
+uint64_t popcountAvx2(const uint64_t *words, size_t count);
+
+// 当前 CPU 和编译器是否支持 AVX2 路径
+bool hasAvx2();
+
+// popcount() 实际使用的实现名称："avx2" 或 "portable"
+const char *activeImplementation();
+
+// 单个字的置位数
+inline int popcount64(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(word);
+#else
+    word = word - ((word >> 1) & 0x5555555555555555ULL);
+    word = (word & 0x3333333333333333ULL) + ((word >> 2) & 0x3333333333333333ULL);
+    word = (word + (word >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    return static_cast<int>((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// 最低置位的下标，word 不能为 0
+inline int lowestSetBit(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(word);
+#else
+    return popcount64((word & (0 - word)) - 1);
+#endif
+}
+
+// 最高置位的下标，word 不能为 0
+inline int highestSetBit(uint64_t word) {
+#if defined(__GNUC__) || defined(__clang__)
+    return 63 - __builtin_clzll(word);
+#else
+    int index = 0;
+    for (int shift = 32; shift > 0; shift >>= 1) {
+        if (word >> shift) {
+            word >>= shift;
+            index += shift;
+        }
+    }
+    return index;
+#endif
+}
+
+// 按小端序装入 data 起的 8 个字节（第 i 个字节在第 8i 位），与主机字节序无关。
+// 编译期已知主机是小端时直接 memcpy；否则逐字节拼接
+inline uint64_t loadLittleEndian64(const void *data) {
+#if defined(_MSC_VER) || (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+    uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return value;
+#else
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) value |= static_cast<uint64_t>(bytes[i]) << (8 * i);
+    return value;
+#endif
+}
+
+// 把 8 个取值为 0 或 1 的字节（按小端序装入 bytes）收集成 8 位掩码，第 i 个字节对应第 i 位
+inline uint32_t gatherByteBits(uint64_t bytes) { return static_cast<uint32_t>((bytes * 0x0102040810204080ULL) >> 56); }
+
+// 低 count 位全为 1 的掩码（count 取 0..64）
+inline uint64_t lowMask(int count) { return count >= 64 ? ~0ULL : ((1ULL << count) - 1); }
+
+} // namespace BitOps
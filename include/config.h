@@ -10,6 +10,9 @@ constexpr int MAP_HEIGHT = 15;
 // 可视范围配置
 constexpr int PACMAN_VISIBILITY_RADIUS = 4;  // 吃豆人视野半径
 constexpr int MONSTER_VISIBILITY_RADIUS = 3; // 怪物视野半径
+constexpr int MAX_VISIBILITY_RADIUS = 31;    // 视野半径上限（视野每行墙壁位放入一个 64 位字）
+static_assert(PACMAN_VISIBILITY_RADIUS <= MAX_VISIBILITY_RADIUS && MONSTER_VISIBILITY_RADIUS <= MAX_VISIBILITY_RADIUS,
+              "视野半径超过 MAX_VISIBILITY_RADIUS");
 
 // 游戏角色配置
 constexpr int PACMAN_COUNT = 1;
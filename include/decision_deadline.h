@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+
+// AI 单次决策的截止时间（协作式）
+// 回合循环启用思考时间预算时，把它随视野一起交给 AI；做长时间搜索的 AI 应定期检查 expired()，
+// 到期后尽快返回目前最好的行动。到期仍未返回的决策由回合循环的看门狗替换为 STAY，
+// 同时调用 cancel() 让仍在运行的搜索尽早结束
+class DecisionDeadline {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+  private:
+    Clock::time_point deadline;
+    std::atomic<bool> cancelled;
+
+  public:
+    DecisionDeadline() : deadline(Clock::time_point::max()), cancelled(false) {}
+
+    DecisionDeadline(const DecisionDeadline &) = delete;
+    DecisionDeadline &operator=(const DecisionDeadline &) = delete;
+
+    // 开始新的一次决策，只能在没有 AI 正在使用本对象时调用
+    void reset(Clock::time_point until) {
+        deadline = until;
+        cancelled.store(false, std::memory_order_relaxed);
+    }
+
+    // 看门狗已放弃本次决策
+    void cancel() { cancelled.store(true, std::memory_order_relaxed); }
+
+    bool expired() const { return cancelled.load(std::memory_order_relaxed) || Clock::now() >= deadline; }
+
+    // 距截止时间的剩余时间，已到期时为 0
+    Clock::duration remaining() const {
+        if (cancelled.load(std::memory_order_relaxed)) {
+            return Clock::duration::zero();
+        }
+        Clock::time_point now = Clock::now();
+        return now >= deadline ? Clock::duration::zero() : deadline - now;
+    }
+
+    Clock::time_point getDeadline() const { return deadline; }
+};
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "game_state_manager.h"
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -15,15 +16,101 @@ class GameControlSystem {
     };
 
   private:
+    // 历史记录按段存放：每段以一个完整关键帧开头，后面跟若干回合的增量
+    // （移动的角色、变化的格子、分数等），需要某一回合时从所在段的关键帧向后重放增量。
+    // 这样历史占用只与每回合的变化量成正比，而不是与地图面积成正比
+    struct TurnDelta {
+        int32_t pacmanScore; // 该回合结束时的绝对值
+        int32_t monsterScore;
+        int32_t remainingDots;
+        int32_t turnCount;
+        uint16_t characterCount; // 本回合在 characterDeltas 中的条目数
+        uint16_t cellCount;      // 本回合在 cellDeltas 中的条目数
+    };
+    // 角色每回合最多移动一格，位移用 8 位足够；超出范围或角色列表变化时改记关键帧
+    struct CharacterDelta {
+        uint16_t indexAndAlive; // 低 15 位为角色下标，最高位为存活标志
+        int8_t dx;
+        int8_t dy;
+    };
+    struct CellDelta {
+        uint32_t cell; // 行优先的格子下标
+        CellType type;
+    };
+    // 段的存储在环形缓冲区中原地复用：淘汰最早的记录只把起始偏移后移，不移动数据，
+    // 槽位再次启用时清空向量但保留容量，预热之后记录一回合不再分配内存
+    struct HistorySegment {
+        long long firstSerial; // 关键帧的记录序号
+        GameState keyframe;
+        std::vector<TurnDelta> turns;
+        std::vector<CharacterDelta> characterDeltas;
+        std::vector<CellDelta> cellDeltas;
+        size_t turnBegin; // 已并入关键帧的增量之后的第一个有效位置
+        size_t characterBegin;
+        size_t cellBegin;
+
+        HistorySegment() : firstSerial(0), turnBegin(0), characterBegin(0), cellBegin(0) {}
+
+        int entryCount() const { return 1 + static_cast<int>(turns.size() - turnBegin); }
+    };
+
+    // 最近一次记录的状态。地图是与当时的状态共享分块的副本，之后仍然共享的分块一定没有变化，
+    // 计算增量时只需比较被写时复制过的分块
+    struct RecordedFrame {
+        GameMap map;
+        std::vector<Character> characters;
+        int pacmanScore;
+        int monsterScore;
+        int remainingDots;
+        int turnCount;
+
+        RecordedFrame() : map(0, 0), pacmanScore(0), monsterScore(0), remainingDots(0), turnCount(0) {}
+    };
+
     bool isPaused;
     PlaybackStatus playbackStatus;
-    std::vector<GameStateManager> stateHistory; // 状态历史记录
+    std::vector<HistorySegment> segmentSlots; // 环形缓冲区，第 i 个段位于 (segmentHead + i) % 容量
+    size_t segmentHead;
+    size_t segmentCount;
+    int historySize; // 所有段中的记录总数
     int currentHistoryIndex;
-    int maxHistorySize;
+    int maxHistorySize; // <= 0 表示不限
+    int keyframeInterval;
+    RecordedFrame lastFrame;
+
+    // 重放游标：最近一次重建的状态，顺序前进时只需再应用一个增量
+    mutable GameState cursorState;
+    mutable long long cursorSerial;
+    mutable size_t cursorTurn;
+    mutable size_t cursorCharacterOffset;
+    mutable size_t cursorCellOffset;
+
+    void captureFrame(const GameStateManager &gameState);
+    bool appendDelta(HistorySegment &segment, const GameStateManager &gameState);
+    void startSegment(const GameStateManager &gameState);
+    bool needsKeyframe(const HistorySegment &segment) const;
+    static size_t keyframeBytes(const GameState &keyframe);
+    static size_t deltaBytes(const HistorySegment &segment);
+    void evictOldest();
+    void truncateAfter(int index);
+    HistorySegment &segmentAt(size_t i) { return segmentSlots[(segmentHead + i) % segmentSlots.size()]; }
+    const HistorySegment &segmentAt(size_t i) const { return segmentSlots[(segmentHead + i) % segmentSlots.size()]; }
+    HistorySegment &acquireSegment();
+    int findSegment(long long serial) const;
+    long long serialOf(int index) const { return segmentAt(0).firstSerial + index; }
+    GameStateManager stateAt(int index) const;
+    static void applyDelta(GameState &state, const TurnDelta &turn, const CharacterDelta *characterDeltas,
+                           const CellDelta *cellDeltas);
 
   public:
+    static constexpr int DEFAULT_KEYFRAME_INTERVAL = 64;
+    static constexpr int KEYFRAME_DELTA_RATIO = 2;
+
     GameControlSystem();
-    explicit GameControlSystem(int maxHistory);
+    // maxHistory <= 0 时保留完整历史
+    // 相邻关键帧之间至少间隔 keyframeInterval 条记录，并且要等段内增量的总大小达到关键帧大小的
+    // KEYFRAME_DELTA_RATIO 倍才开始新关键帧：大地图上关键帧很贵，间隔会自动拉长，历史总占用约为增量的 1.5 倍
+    explicit GameControlSystem(int maxHistory, int keyframeInterval = DEFAULT_KEYFRAME_INTERVAL);
 
     // 暂停/恢复控制
     void pause();
@@ -33,6 +120,9 @@ class GameControlSystem {
     PlaybackStatus getPlaybackStatus() const { return playbackStatus; }
 
     // 状态保存/加载
+    // 存档为带版本号和分节校验的二进制格式（见 StateCodec），加载时映射文件后一遍解码；
+    // 旧版存档（文本地图 + 结构体转储）仍可加载，任何校验失败都返回 false 且不修改 gameState
+    // 地图超出 StateCodec::MAX_MAP_DIMENSION 时 saveGame 返回 false，不写文件
     bool saveGame(const GameStateManager &gameState, const std::string &filename) const;
     bool loadGame(GameStateManager &gameState, const std::string &filename) const;
 
@@ -52,6 +142,12 @@ class GameControlSystem {
     GameStateManager restartFromBeginning(); // 从第一回合重新开始
     bool hasHistory() const;                 // 是否有历史记录
 
+    // 历史查询
+    int getHistorySize() const { return historySize; }
+    int getCurrentHistoryIndex() const { return currentHistoryIndex; }
+    GameStateManager getHistoryState(int index) const; // 重建第 index 条记录（0 为最早）
+    size_t getHistoryMemoryBytes() const;               // 历史记录占用的近似字节数
+
     // 游戏重启
     void reset();
 };
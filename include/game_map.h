@@ -2,20 +2,95 @@
 
 #include "config.h"
 #include "game_types.h"
+#include <atomic>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 
+class VisibilityCache;
+
+// 地图按行切成若干横条（分块），每块按行优先存放该块的单元格（每格一个字节），
+// 并维护墙壁和豆子两个位平面（每格一位，每行按 64 位字对齐），统计和墙壁检测可以按字批量完成。
+// 分块通过引用计数在地图副本之间共享，写入时才复制被写的那一块（写时复制）：
+// 历史快照、撤销结果等副本只为本回合实际改动过的分块付出内存和拷贝开销。
+// 同一张地图及其所有副本共用一个空闲分块池：历史淘汰释放的分块回到池中，下次写时复制直接取用，
+// 稳定运行后改动单元格不再分配内存；池中最多保留与地图分块数相同的空闲分块
 class GameMap {
+  public:
+    static constexpr int TILE_ROWS = 16; // 每个分块的行数
+
   private:
-    std::vector<std::vector<CellType>> grid;
+    struct TilePool;
+
+    // 分块头部之后依次是单元格（按 8 字节补齐）、墙壁位平面和豆子位平面，整块一次分配。
+    // 每块都按 TILE_ROWS 行的容量分配（最后一块可能只用其中几行），同一个池里的分块大小相同，可以互相替换
+    struct MapTile {
+        std::atomic<int> refs;
+        TilePool *pool; // 分块只被使用同一个池的地图引用，池比它的所有分块活得久
+        int rows;
+        CellType *cells;    // rows 行，每行 width 格
+        uint64_t *wallBits; // 每行 wordsPerRow 个字
+        uint64_t *dotBits;
+    };
+
+    // 分块的引用计数句柄：共享语义与 shared_ptr 相同，但计数放在分块内，复制和释放都不分配内存；
+    // 最后一个引用释放时分块回到所属的池
+    class TileRef {
+        MapTile *tile;
+
+      public:
+        TileRef() : tile(nullptr) {}
+        explicit TileRef(MapTile *adopted) : tile(adopted) {} // 接管 adopted 已有的一个引用
+        TileRef(const TileRef &other) : tile(other.tile) {
+            if (tile != nullptr) tile->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+        TileRef(TileRef &&other) noexcept : tile(other.tile) { other.tile = nullptr; }
+        TileRef &operator=(TileRef other) noexcept {
+            std::swap(tile, other.tile);
+            return *this;
+        }
+        ~TileRef() {
+            if (tile != nullptr && tile->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) releaseTile(tile);
+        }
+
+        MapTile *get() const { return tile; }
+        MapTile *operator->() const { return tile; }
+        bool isShared() const { return tile->refs.load(std::memory_order_acquire) > 1; }
+    };
+
+    // 池必须声明在 tiles 之前：析构时先释放分块，再释放池
+    std::shared_ptr<TilePool> tilePool;
+    std::vector<TileRef> tiles;
     int width;
     int height;
+    int wordsPerRow;
     int totalDots;
 
+    // 按视野半径预计算的可见掩码，只依赖墙壁布局；地图复制时共享，墙壁变化时丢弃
+    std::vector<std::shared_ptr<const VisibilityCache>> visibilityCaches;
+
+    // 从池中取一个分块（池空时新分配），引用计数为 1，内容未初始化
+    MapTile *acquireTile(int rows) const;
+    static void releaseTile(MapTile *tile);
+    TileRef makeWallTile(int rows) const;
+
+    // 取得可写的分块：与其他副本共享时先复制一份（优先复用池中的空闲分块）
+    MapTile &mutableTile(int tileIndex);
+
+    // 写入单元格并同步位平面，调用者保证坐标在地图内
+    void writeCell(int x, int y, CellType type);
+
   public:
     // 构造函数
     GameMap();
-    GameMap(int width, int height);
+    GameMap(int width, int height); // 负的宽高按 0 处理；宽为 0 时仍保留 height 个空行
+    GameMap(const GameMap &other) = default;
+    GameMap(GameMap &&other) noexcept = default;
+    // 赋值时先替换分块再替换池，旧分块回到旧池
+    GameMap &operator=(const GameMap &other);
+    GameMap &operator=(GameMap &&other) noexcept;
 
     // 初始化
     void initialize();
@@ -26,6 +101,43 @@ class GameMap {
     CellType getCell(const Position &pos) const;
     void setCell(int x, int y, CellType type);
     void setCell(const Position &pos, CellType type);
+    // 整行写入：用 rowCells 的 getWidth() 个单元格覆盖第 y 行并重建该行位平面，用于批量加载
+    // 调用者需保证 0 <= y < getHeight()；内容不变时不触发写时复制
+    void setRow(int y, const CellType *rowCells);
+
+    // 解码器直接填充一行：返回第 y 行单元格（getWidth() 个）和两个位平面（各 getWordsPerRow() 个字）的可写指针，
+    // 调用者必须把三者全部写满并保持一致（行尾多余的位为 0）。不经过中间缓冲，用于从二进制格式加载新建的地图
+    // 调用者需保证 0 <= y < getHeight()；会丢弃视野缓存
+    struct RowWriter {
+        CellType *cells;
+        uint64_t *wallBits;
+        uint64_t *dotBits;
+    };
+    RowWriter writeRow(int y);
+
+    // 原始行访问：返回第 y 行首个单元格的指针，该行共 getWidth() 个单元格
+    // 调用者需保证 0 <= y < getHeight()
+    // 不同分块的行不连续，跨行访问要逐行取指针
+    const CellType *getRow(int y) const {
+        return tiles[y / TILE_ROWS]->cells + static_cast<size_t>(y % TILE_ROWS) * width;
+    }
+
+    // 位平面访问：第 y 行的 getWordsPerRow() 个字，第 x 列对应第 x / 64 个字的第 x % 64 位
+    int getWordsPerRow() const { return wordsPerRow; }
+    const uint64_t *getWallBitsRow(int y) const {
+        return tiles[y / TILE_ROWS]->wallBits + static_cast<size_t>(y % TILE_ROWS) * wordsPerRow;
+    }
+    const uint64_t *getDotBitsRow(int y) const {
+        return tiles[y / TILE_ROWS]->dotBits + static_cast<size_t>(y % TILE_ROWS) * wordsPerRow;
+    }
+
+    // 分块查询：两张地图的第 tileIndex 块是否为同一份存储（共享则内容必然相同）
+    int getTileCount() const { return static_cast<int>(tiles.size()); }
+    bool sharesTile(const GameMap &other, int tileIndex) const;
+
+    // 取出第 y 行从 x0 开始连续 count 列（count <= 64）的墙壁位，第 i 位对应 x0 + i 列
+    // 超出地图范围的部分视为墙，与 getCell 的约定一致
+    uint64_t extractWallBits(int x0, int y, int count) const;
 
     // 地图查询
     int getWidth() const { return width; }
@@ -42,13 +154,20 @@ class GameMap {
     int getTotalDots() const { return totalDots; }
     void setTotalDots(int dots) { totalDots = dots; }
 
-    // 地图加载与保存
+    // 地图加载与保存（文本格式见 MapText，需要出错位置时直接调用 MapText::parse）
+    // 输入格式错误时返回 false，地图保持不变
     bool loadFromFile(const std::string &filename);
     bool saveToFile(const std::string &filename) const;
-    bool loadFromString(const std::string &mapData);
+    bool loadFromString(std::string_view mapData);
     std::string saveToString() const;
 
-    // 地图验证
+    // 视野缓存：挂上后由 VisibilitySystem 查询，同一半径只保留最新的一份
+    // 任何改变墙壁的写入（setCell、加载、重新初始化）都会丢弃全部缓存
+    void attachVisibilityCache(std::shared_ptr<const VisibilityCache> cache);
+    const VisibilityCache *findVisibilityCache(int radius) const;
+    void dropVisibilityCaches() { visibilityCaches.clear(); }
+
+    // 地图验证：四周是墙、空地足够放下所有角色、所有豆子都在最大的连通区域内（见 MapConnectivity）
     bool validate() const;
 
     // 地图复制
@@ -2,6 +2,7 @@
 
 #include "game_map.h"
 #include "game_types.h"
+#include "occupancy_grid.h"
 #include <vector>
 
 // GameState 结构体 - 用于保存/加载
@@ -24,6 +25,7 @@ class GameStateManager {
     int monsterScore;
     int remainingDots;
     int turnCount;
+    OccupancyGrid occupancy; // 与 characters 保持同步的占用索引
 
   public:
     // 构造函数
@@ -43,6 +45,7 @@ class GameStateManager {
     int getMonsterScore() const { return monsterScore; }
     int getRemainingDots() const { return remainingDots; }
     int getTurnCount() const { return turnCount; }
+    const OccupancyGrid &getOccupancy() const { return occupancy; }
 
     // 状态更新方法
     void updateCharacterPosition(int index, const Position &newPos);
@@ -62,6 +65,9 @@ class GameStateManager {
     bool hasDot(const Position &pos) const;
     bool isGameOver() const;
 
+    // 站在 pos 上的存活角色中下标最小的一个，没有时返回 -1（O(1)，查占用索引）
+    int findCharacterAt(const Position &pos) const;
+
     // 状态保存与恢复
     GameState getCurrentState() const;
     void restoreState(const GameState &state);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cmath>
+#include <cstdint>
 
 // Position 结构体
 struct Position {
@@ -56,8 +57,8 @@ inline const char *directionToString(Direction dir) {
     }
 }
 
-// CellType 枚举
-enum class CellType { EMPTY, WALL, DOT };
+// CellType 枚举（单字节存储，地图按行连续排列）
+enum class CellType : uint8_t { EMPTY, WALL, DOT };
 
 inline const char *cellTypeToString(CellType type) {
     switch (type) {
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// 延迟直方图（HDR 风格的对数-线性分桶）
+// 小于 64 ns 的样本每纳秒一个桶；更大的值按 2 的幂分段，每段再等分为 32 个子桶，
+// 相对误差不超过 1/32（约 3%）。记录一个样本只需一次求最高位和一次加法，不分配内存；
+// 分桶固定，不同直方图可以直接合并
+class LatencyHistogram {
+  public:
+    static constexpr int SUB_BUCKET_BITS = 5;
+    static constexpr int SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    static constexpr int MAX_VALUE_BITS = 40; // 超过 2^40 ns（约 18 分钟）的样本按上限计
+    static constexpr int BUCKET_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+  private:
+    std::vector<uint64_t> counts;
+    uint64_t totalCount;
+    uint64_t minValue;
+    uint64_t maxValue;
+    double sum;
+
+  public:
+    LatencyHistogram();
+
+    static int bucketIndex(uint64_t value);
+    static uint64_t bucketLowerBound(int index);
+    static uint64_t bucketUpperBound(int index); // 桶内的最大值
+
+    void record(uint64_t nanos);
+    void merge(const LatencyHistogram &other);
+    void reset();
+
+    uint64_t getCount() const { return totalCount; }
+    uint64_t getMin() const { return totalCount > 0 ? minValue : 0; }
+    uint64_t getMax() const { return maxValue; }
+    double getMean() const { return totalCount > 0 ? sum / static_cast<double>(totalCount) : 0.0; }
+
+    // 第 quantile（0..1）分位数：不小于该比例样本的最小桶的上界（不超过实际最大值），没有样本时为 0
+    uint64_t percentile(double quantile) const;
+};
@@ -22,4 +22,11 @@ class ManagementInterface {
 
     // 辅助方法：根据方向获取新位置
     Position getNewPosition(const Position &currentPos, Direction dir) const;
+
+    // 辅助方法：碰撞检测，返回站在 pos 上的存活角色下标（多个时取最小），没有时返回 -1
+    // 通过游戏状态的占用索引查询，耗时与角色数量无关
+    int findCharacterAt(const GameStateManager &gameState, const Position &pos) const;
+
+    // 辅助方法：pos 上是否有 type 类型的存活角色
+    bool hasCharacterOfType(const GameStateManager &gameState, const Position &pos, CharacterType type) const;
 };
@@ -1,10 +1,14 @@
 #pragma once
 
 #include "management_interface.h"
+#include <vector>
 
 // 简单的管理系统实现 - 基础示例
 // 这是给学生C的参考实现，学生需要在此基础上扩展功能
 class ManagementSystem : public ManagementInterface {
+  private:
+    std::vector<Character> characters; // 本回合移动后的角色，跨回合复用
+
   public:
     ManagementSystem() = default;
 
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "config.h"
+#include "game_map.h"
+#include "map_connectivity.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+
+// 批量生成配置：对局种子 baseSeed .. baseSeed + seedCount - 1 各生成一张地图
+// 每张地图与同种子对局（generateMatchMap）生成的地图完全相同，写出的地图包可直接用于 --map-pack
+struct MapBatchConfig {
+    int width;
+    int height;
+    int monsterCount; // 出生点检查按 1 个吃豆人 + monsterCount 个怪物
+    uint64_t baseSeed;
+    long long seedCount;
+    int threadCount;  // <= 0 表示使用全部硬件线程
+    bool deduplicate; // 丢弃与之前某张地图内容相同的地图
+
+    MapBatchConfig()
+        : width(GameConfig::MAP_WIDTH), height(GameConfig::MAP_HEIGHT), monsterCount(GameConfig::MONSTER_COUNT),
+          baseSeed(1), seedCount(1000), threadCount(0), deduplicate(true) {}
+};
+
+// 批量生成统计
+struct MapBatchStats {
+    long long generated;
+    long long accepted;
+    long long unreachableDots;   // 有豆子与出生点不连通
+    long long unreachableSpawns; // 有角色的出生点与吃豆人不连通
+    long long noSpawn;           // 空地不足，无法放下所有角色
+    long long duplicates;
+    int threadCount;
+    double elapsedSeconds;
+
+    MapBatchStats()
+        : generated(0), accepted(0), unreachableDots(0), unreachableSpawns(0), noSpawn(0), duplicates(0),
+          threadCount(0), elapsedSeconds(0.0) {}
+
+    double mapsPerSecond() const { return elapsedSeconds > 0.0 ? generated / elapsedSeconds : 0.0; }
+};
+
+// 单张地图的质量检查结果
+enum class MapRejection { NONE, UNREACHABLE_DOTS, UNREACHABLE_SPAWN, NO_SPAWN };
+
+// 检查一张地图：按 spawnSeed 放置角色必须成功，所有出生点都在吃豆人所在的连通区域内（否则为 UNREACHABLE_SPAWN），
+// 且所有豆子也都在这个区域内（否则为 UNREACHABLE_DOTS）
+// connectivity 只作为分析用的缓冲区，调用后保存这张地图的分析结果
+MapRejection checkMapQuality(const GameMap &map, int monsterCount, unsigned int spawnSeed,
+                             MapConnectivity &connectivity);
+
+// 地图内容指纹（基于墙壁和豆子位平面），用于去重时快速筛选；指纹相同的地图还要逐行比较内容
+uint64_t hashMapContent(const GameMap &map);
+
+// 两张地图的尺寸和每个单元格都相同
+bool sameMapContent(const GameMap &a, const GameMap &b);
+
+// 并行批量生成器
+// 种子按块分给线程池，每个工作线程使用自己的生成器实例；一批块全部完成后按种子顺序去重并交给输出回调，
+// 因此输出顺序和去重结果与线程数无关。
+// 一批的种子数按地图面积缩小，使一批地图的格子总数不超过约 6400 万（约 80 MB），大地图时至少每个线程一张，
+// 峰值内存约为 max(80 MB, 线程数 * 单张地图大小)，与种子总数无关。
+// 去重只为每个指纹记下第一张地图的种子，指纹相同时按种子重新生成那张地图逐行比较，指纹碰撞不会误删地图
+class MapBatchGenerator {
+  public:
+    // 每张通过检查的地图按种子升序调用一次（在调用 run() 的线程上）
+    using Sink = std::function<void(uint64_t seed, const GameMap &map)>;
+
+  private:
+    MapBatchConfig config;
+
+  public:
+    explicit MapBatchGenerator(const MapBatchConfig &batchConfig) : config(batchConfig) {}
+
+    MapBatchStats run(const Sink &sink);
+
+    // 生成并写入地图包文件
+    bool writePack(const std::string &filename, MapBatchStats &stats);
+};
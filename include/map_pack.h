@@ -0,0 +1,128 @@
+#pragma once
+
+#include "game_map.h"
+#include "mapped_file.h"
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+// 地图包：把大量地图以二进制形式存进一个文件，按种子（或任意 64 位编号）建立有序索引
+// 每张地图的记录直接采用 GameMap 的内存布局（每格一字节的单元格、按行对齐的墙壁和豆子位平面），
+// 映射文件后 MapView 直接指向文件页面，查找和读取都不解析、不复制；多个进程打开同一个包时共享页面缓存
+//
+// 文件布局（整数均为小端序，记录按 8 字节对齐）：
+//   头部  "PMPK"、版本(u16)、保留(u16)、地图数(u32)、索引 CRC(u32)、索引偏移(u64)、保留(u32)、头部 CRC(u32)
+//   记录  单元格 宽*高 字节（补齐到 8 字节）、墙壁位平面 高*每行字数 个 u64、豆子位平面同样大小
+//   索引  按种子升序，每项为 种子(u64)、记录偏移(u64)、宽(u32)、高(u32)、豆子总数(u32)、记录 CRC(u32)
+namespace MapPackFormat {
+constexpr uint32_t MAGIC = 0x4B504D50; // "PMPK"
+constexpr uint16_t VERSION = 1;
+constexpr size_t HEADER_BYTES = 32;
+constexpr size_t INDEX_ENTRY_BYTES = 32;
+} // namespace MapPackFormat
+
+// 地图包中一张地图的只读视图，指针直接指向映射的文件内容，生命周期不超过所属的 MapPack
+class MapView {
+  private:
+    const CellType *cells;
+    const uint64_t *wallBits;
+    const uint64_t *dotBits;
+    int width;
+    int height;
+    int wordsPerRow;
+    int totalDots;
+
+    friend class MapPack;
+
+  public:
+    MapView()
+        : cells(nullptr), wallBits(nullptr), dotBits(nullptr), width(0), height(0), wordsPerRow(0), totalDots(0) {}
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getWordsPerRow() const { return wordsPerRow; }
+    int getTotalDots() const { return totalDots; }
+
+    // 与 GameMap 相同的访问约定：越界视为墙，行指针要求 0 <= y < getHeight()
+    CellType getCell(int x, int y) const {
+        bool inBounds = x >= 0 && x < width && y >= 0 && y < height;
+        return inBounds ? cells[static_cast<size_t>(y) * width + x] : CellType::WALL;
+    }
+    const CellType *getRow(int y) const { return cells + static_cast<size_t>(y) * width; }
+    const uint64_t *getWallBitsRow(int y) const { return wallBits + static_cast<size_t>(y) * wordsPerRow; }
+    const uint64_t *getDotBitsRow(int y) const { return dotBits + static_cast<size_t>(y) * wordsPerRow; }
+
+    // 复制成可修改的 GameMap（逐行内存拷贝，位平面按单元格重建）。视图直接指向文件内容，
+    // 单元格取值不合法（记录损坏）时返回 false 且不修改 map；豆子总数按单元格重新统计，不采用索引中的值
+    bool toGameMap(GameMap &map) const;
+};
+
+// 顺序写入地图包：记录边生成边写入文件，finish() 时在末尾写索引并回填头部
+class MapPackWriter {
+  private:
+    struct Entry {
+        uint64_t seed;
+        uint64_t offset;
+        uint32_t width;
+        uint32_t height;
+        uint32_t totalDots;
+        uint32_t crc;
+    };
+
+    std::ofstream file;
+    std::vector<Entry> entries;
+    std::unordered_set<uint64_t> seeds;
+    std::vector<uint8_t> record; // 复用的记录缓冲区
+    uint64_t position;
+    bool failed;
+
+  public:
+    MapPackWriter() : position(0), failed(false) {}
+
+    bool open(const std::string &filename);
+
+    // 追加一张地图；同一个包内种子不能重复（重复时返回 false 且不写入）
+    // 没有单元格的地图和边长超出 StateCodec::MAX_MAP_DIMENSION 的地图（读取时会整包拒绝）同样返回 false 且不写入
+    bool add(uint64_t seed, const GameMap &map);
+
+    // 写入索引和头部并关闭文件
+    bool finish();
+
+    int getMapCount() const { return static_cast<int>(entries.size()); }
+};
+
+// 只读地图包：打开时只校验头部和索引，地图记录在第一次访问时才由操作系统按页读入，
+// 记录内容的 CRC 只在调用 verify() 时检查
+class MapPack {
+  private:
+    MappedFile file;
+    const uint8_t *indexData;
+    int mapCount;
+
+    uint64_t readIndexU64(int index, size_t field) const;
+    uint32_t readIndexU32(int index, size_t field) const;
+    size_t recordBytes(int index) const;
+
+  public:
+    MapPack() : indexData(nullptr), mapCount(0) {}
+
+    MapPack(const MapPack &) = delete;
+    MapPack &operator=(const MapPack &) = delete;
+
+    bool open(const std::string &filename);
+    void close();
+
+    int size() const { return mapCount; }
+    uint64_t seedAt(int index) const { return readIndexU64(index, 0); }
+
+    // 按种子二分查找，找不到时返回 -1
+    int find(uint64_t seed) const;
+
+    // 第 index 张地图的零拷贝视图，调用者需保证 0 <= index < size()
+    MapView view(int index) const;
+
+    // 校验第 index 张地图记录的 CRC（会读入整条记录）
+    bool verify(int index) const;
+};
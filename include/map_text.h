@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+class GameMap;
+
+// 地图文本格式的解析与序列化
+// 格式：首行 "宽 高"，随后 高 行，每行恰好 宽 个字符：'#' 墙、'.' 豆子、' ' 空地；行尾为 "\n" 或 "\r\n"，
+// 最后一行的换行可省略，地图之后只允许空白
+// 直接在内存缓冲区上工作，不经过流；字符分类按 8 字节一组比较，尾部和出错定位查表
+namespace MapText {
+
+struct ParseError {
+    int line;   // 从 1 开始
+    int column; // 从 1 开始
+    std::string message;
+
+    ParseError() : line(0), column(0) {}
+};
+
+// 解析成功时替换 map 并返回 true；失败时 map 不变，error 非空则填入出错位置
+bool parse(std::string_view text, GameMap &map, ParseError *error = nullptr);
+
+// 把地图序列化到 out（覆盖原有内容，复用其容量）
+void serialize(const GameMap &map, std::string &out);
+std::string serialize(const GameMap &map);
+
+// 错误信息格式化为 "line L, column C: message"
+std::string formatError(const ParseError &error);
+
+} // namespace MapText
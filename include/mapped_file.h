@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 只读文件映射：把整个文件映射进内存，按指针直接读取，不经过流和中间缓冲
+// 平台不支持映射或映射失败（例如空文件、特殊文件）时退回一次性读入内存，对调用者透明
+class MappedFile {
+  public:
+    // 预期的访问方式，作为预读提示交给操作系统
+    enum class Access {
+        SEQUENTIAL, // 从头到尾读一遍（存档、文本地图），积极预读
+        RANDOM      // 按索引跳着读（地图包），不预读相邻页面
+    };
+
+  private:
+    const uint8_t *mappedData;
+    size_t mappedSize;
+    std::vector<uint8_t> fallback; // 退回读入时的数据
+#ifdef _WIN32
+    void *fileHandle;
+    void *mappingHandle;
+#endif
+
+  public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    bool open(const std::string &filename, Access access = Access::SEQUENTIAL);
+    void close();
+
+    bool isOpen() const { return mappedData != nullptr || !fallback.empty(); }
+    bool isMapped() const { return mappedData != nullptr; }
+    const uint8_t *data() const { return mappedData != nullptr ? mappedData : fallback.data(); }
+    size_t size() const { return mappedData != nullptr ? mappedSize : fallback.size(); }
+};
@@ -0,0 +1,103 @@
+#pragma once
+
+#include "ai_interface.h"
+#include "config.h"
+#include "game_map.h"
+#include "game_types.h"
+#include "match_seed.h"
+#include "turn_based_game_loop.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+class MapPack;
+class ThreadPool;
+
+// 对局配置 - 无界面模拟和批量对局共用
+struct MatchConfig {
+    int mapWidth;
+    int mapHeight;
+    int monsterCount;
+    int maxTurns;         // 回合上限，达到后判为平局
+    int thinkTimeMs;      // 每回合 AI 思考时间预算（毫秒），<= 0 表示不限时；限时的对局结果取决于实际耗时
+    // 生成地图时预计算视野缓存（不影响结果，只影响速度），默认关闭。
+    // 两个视野半径的缓存合计每个可走格子约 136 字节，4096x4096 的地图约 2 GB，只在地图不大时打开
+    bool visibilityCache;
+
+    MatchConfig()
+        : mapWidth(GameConfig::MAP_WIDTH), mapHeight(GameConfig::MAP_HEIGHT), monsterCount(GameConfig::MONSTER_COUNT),
+          maxTurns(1000), thinkTimeMs(0), visibilityCache(false) {}
+};
+
+// 对局结局
+enum class MatchOutcome { PACMAN_WIN, MONSTER_WIN, DRAW };
+
+inline const char *matchOutcomeToString(MatchOutcome outcome) {
+    switch (outcome) {
+    case MatchOutcome::PACMAN_WIN:
+        return "PACMAN_WIN";
+    case MatchOutcome::MONSTER_WIN:
+        return "MONSTER_WIN";
+    case MatchOutcome::DRAW:
+        return "DRAW";
+    default:
+        return "UNKNOWN";
+    }
+}
+
+// 对局结果
+struct MatchResult {
+    MatchOutcome outcome;
+    int turns;
+    int pacmanScore;
+    int monsterScore;
+    int remainingDots;
+    uint64_t finalStateHash;  // 终局状态指纹，用于确认同一种子的对局逐位一致
+    int pacmanThinkOverruns;  // 吃豆人 AI 超出思考时间预算的回合数
+    int monsterThinkOverruns; // 所有怪物 AI 超出思考时间预算的回合数之和
+
+    MatchResult()
+        : outcome(MatchOutcome::DRAW), turns(0), pacmanScore(0), monsterScore(0), remainingDots(0), finalStateHash(0),
+          pacmanThinkOverruns(0), monsterThinkOverruns(0) {}
+};
+
+// AI 工厂：根据种子创建一个 AI 实例，用于在不同线程中独立创建参赛 AI
+using AgentFactory = std::function<std::unique_ptr<AIInterface>(unsigned int seed)>;
+
+// 内置的参考 AI（随机移动）
+AgentFactory defaultPacmanFactory();
+AgentFactory defaultMonsterFactory();
+
+// 在地图空地上随机放置 1 个吃豆人和 monsterCount 个怪物，位置只由 spawnSeed 决定
+// 空地不足时返回空列表
+std::vector<Character> createMatchCharacters(const GameMap &map, int monsterCount, unsigned int spawnSeed);
+
+// 为吃豆人和怪物的视野半径构建视野缓存并挂到地图上，pool 的用法见 VisibilitySystem::buildCache
+void buildMatchVisibilityCaches(GameMap &map, ThreadPool *pool = nullptr);
+
+// 用 seeds.mapSeed 生成本局地图；config.visibilityCache 为真时同时构建视野缓存
+GameMap generateMatchMap(const MatchConfig &config, const MatchSeeds &seeds, ThreadPool *pool = nullptr);
+
+// 先在地图包中按 seeds.matchSeed 查找尺寸相符的地图，找不到（或 pack 为空、记录 CRC 不符）时再用 generateMatchMap 生成
+// 地图包中的地图应由同样的生成参数产生，这样两条路径得到的对局完全一致
+GameMap loadMatchMap(const MatchConfig &config, const MatchSeeds &seeds, const MapPack *pack,
+                     ThreadPool *pool = nullptr);
+
+// 在给定地图上放置角色并装配指定 AI 和管理系统，返回已启动的游戏循环
+// 地图空地不足时返回 nullptr
+std::unique_ptr<TurnBasedGameLoop> createMatch(const GameMap &map, const MatchConfig &config, const MatchSeeds &seeds,
+                                               const AgentFactory &pacmanFactory, const AgentFactory &monsterFactory);
+
+// 由对局种子生成地图并装配默认 AI 和管理系统
+std::unique_ptr<TurnBasedGameLoop> createMatch(const MatchConfig &config, uint64_t matchSeed);
+
+// 计算游戏状态（地图、角色、分数、回合数）的 FNV-1a 指纹
+uint64_t hashGameState(const GameStateManager &gameState);
+
+// 每回合结束后的回调，参数为刚执行完的回合数（从 1 开始）
+using TurnCallback = std::function<void(int turn)>;
+
+// 不经过渲染和定时器，连续执行回合直到游戏结束或达到回合上限
+// onTurn 非空时在每回合之后调用（例如逐回合统计堆分配），不应修改游戏状态
+MatchResult runMatch(TurnBasedGameLoop &gameLoop, int maxTurns, const TurnCallback &onTurn = nullptr);
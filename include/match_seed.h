@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+// 对局种子 - 一局比赛的全部随机性都由一个 64 位种子决定
+// 地图、出生点和每个 AI 的子种子通过 SplitMix64 按用途分流派生，互不相关；
+// 相同的 (种子, AI 组合) 总能逐位复现同一局比赛
+struct MatchSeeds {
+    uint64_t matchSeed;
+    unsigned int mapSeed;                 // RandomMapGenerator
+    unsigned int spawnSeed;               // 角色出生点
+    std::vector<unsigned int> agentSeeds; // 按角色顺序：吃豆人在前，怪物在后
+
+    MatchSeeds() : matchSeed(0), mapSeed(0), spawnSeed(0) {}
+};
+
+// SplitMix64 混合函数
+uint64_t splitMix64(uint64_t value);
+
+// 派生第 stream 路子种子
+unsigned int deriveSubSeed(uint64_t matchSeed, uint64_t stream);
+
+// 派生一局比赛的全部子种子
+MatchSeeds deriveMatchSeeds(uint64_t matchSeed, int agentCount);
+
+// 解析命令行给出的对局种子：十进制（前导 0 仍按十进制），或 0x / 0X 开头的十六进制。
+// 不接受空白、正负号和其他字符，超出 64 位时返回 false，不会悄悄换成另一局的种子
+bool parseMatchSeed(std::string_view text, uint64_t &seed);
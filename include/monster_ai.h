@@ -2,7 +2,6 @@
 
 #include "ai_interface.h"
 #include <random>
-#include <vector>
 
 // 简单的怪物AI - 随机移动示例
 // 这是给学生B的参考实现，学生可以在此基础上改进策略
@@ -10,8 +9,10 @@ class MonsterAI : public AIInterface {
   private:
     std::mt19937 randomEngine;
 
-    // 辅助方法：获取所有有效的移动方向（不会撞墙）
-    std::vector<Direction> getValidMoves(const VisibleArea &visibleArea) const;
+    static constexpr int MAX_MOVES = 4;
+
+    // 辅助方法：把所有有效的移动方向（不会撞墙）写入 validMoves，返回个数
+    int getValidMoves(const VisibleArea &visibleArea, Direction validMoves[MAX_MOVES]) const;
 
     // 辅助方法：检查某个方向是否可以移动
     bool canMove(const VisibleArea &visibleArea, Direction dir) const;
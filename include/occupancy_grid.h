@@ -0,0 +1,62 @@
+#pragma once
+
+#include "game_types.h"
+#include <cstdint>
+#include <vector>
+
+// 角色占用索引
+// 为有角色站立的格子维护该格上的角色下标链表（按下标升序），
+// 回答“这个格子上有谁”只需 O(1)，不必每次扫描整个角色列表。
+// 格子到链表头的映射是以格子编号为键的开放寻址哈希表，容量只取决于角色数量而与地图面积无关，
+// 复制游戏状态时不会随地图变大而变贵。越界的角色不进入索引；死亡角色仍在索引中，由查询方按需跳过
+class OccupancyGrid {
+  private:
+    struct Slot {
+        int cell; // 格子编号，-1 表示空槽
+        int head; // 该格子上下标最小的角色
+    };
+
+    int width;
+    int height;
+    std::vector<Slot> slots;      // 线性探测，容量为 2 的幂且至少是角色数的 2 倍
+    std::vector<int> nextInCell;  // 同一格子上下一个角色的下标，没有为 -1
+    std::vector<int> indexedCell; // 每个角色当前登记的格子，未登记为 -1
+
+    static size_t hashCell(int cell) { return static_cast<size_t>(static_cast<uint32_t>(cell) * 2654435761u); }
+    size_t slotMask() const { return slots.size() - 1; }
+
+    int cellIndex(const Position &pos) const;
+    int findSlot(int cell) const; // 没有该格子时返回 -1
+    int acquireSlot(int cell);
+    void eraseSlot(size_t slot);
+    void insert(int index, int cell);
+    void remove(int index);
+
+  public:
+    OccupancyGrid();
+    OccupancyGrid(int width, int height);
+
+    // 重新设置地图尺寸并清空索引
+    void reset(int width, int height);
+
+    // 与角色列表同步：只改动位置发生变化的角色，角色数量变化时整体重建
+    void update(const std::vector<Character> &characters);
+
+    // 单个角色移动
+    void moveCharacter(int index, const Position &newPos);
+
+    // 格子上下标最小的角色（不论死活），没有或越界时返回 -1；配合 nextAt 遍历同格的其他角色
+    int firstAt(const Position &pos) const;
+    int firstAt(int x, int y) const {
+        if (x < 0 || x >= width || y < 0 || y >= height) {
+            return -1;
+        }
+        int slot = findSlot(y * width + x);
+        return slot >= 0 ? slots[slot].head : -1;
+    }
+    int nextAt(int index) const { return nextInCell[index]; }
+
+    // 格子上下标最小的存活角色，没有时返回 -1
+    int findAlive(const Position &pos, const std::vector<Character> &characters) const;
+    int findAlive(int x, int y, const std::vector<Character> &characters) const;
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define PACMAN_PROFILE_CLOCK_TSC 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#else
+#include <chrono>
+#endif
+
+// 性能剖析用的低开销时钟
+// x86-64 上直接读时间戳计数器（一次读数约几纳秒，现代 CPU 的计数频率恒定），第一次换算时对照 steady_clock
+// 校准频率；其他平台退回 steady_clock。读数只用于求差，不对应任何绝对时间
+namespace ProfileClock {
+
+inline uint64_t now() {
+#ifdef PACMAN_PROFILE_CLOCK_TSC
+    return __rdtsc();
+#else
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch())
+            .count());
+#endif
+}
+
+// 每个计数对应的纳秒数（第一次调用时校准，之后直接返回）
+double nanosPerTick();
+
+// 两次读数之差换算为纳秒
+inline uint64_t toNanos(uint64_t ticks) { return static_cast<uint64_t>(static_cast<double>(ticks) * nanosPerTick()); }
+
+// 计时来源："tsc" 或 "steady_clock"
+const char *source();
+
+} // namespace ProfileClock
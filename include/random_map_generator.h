@@ -11,7 +11,8 @@ class RandomMapGenerator {
     int height;
     float dotRatio;
     std::mt19937 randomEngine;
-    GameMap *currentMap;
+    GameMap *currentMap;                   // 只在 generateMap() 执行期间有效
+    std::vector<Position> candidateBuffer; // 放置豆子和角色时的候选位置，跨调用复用
 
     // 深度优先搜索生成迷宫
     void generateMaze(int startX, int startY);
@@ -23,13 +24,15 @@ class RandomMapGenerator {
     bool isInBounds(int x, int y) const;
 
   public:
-    RandomMapGenerator(int w, int h, float dotRatio);
+    // 随机性只来自 seed，相同参数和种子总是生成相同的地图
+    RandomMapGenerator(int w, int h, float dotRatio, unsigned int seed = std::mt19937::default_seed);
 
     void setSeed(unsigned int seed);
     GameMap generateMap();
-    std::vector<Position> generateCharacterPositions(int characterCount);
+    // 在 map 上随机选出最多 characterCount 个出生点：每个点周围 3x3 内至少 3 格可走，且与已选的点保持最小距离
+    // 从预先收集的候选中无放回抽取，耗时与地图面积成线性，不受地图疏密影响；满足条件的点不够时返回较少的点
+    std::vector<Position> generateCharacterPositions(const GameMap &map, int characterCount);
 
   private:
     void placeDots();
-    bool isValidCharacterPosition(const Position &pos, const std::vector<Position> &existingPositions) const;
 };
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "game_state_manager.h"
+#include "game_types.h"
+#include "management_interface.h"
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// 行动日志回放：不保存逐回合状态，只保存对局种子、初始状态和每回合所有角色的行动（每个行动 3 位），
+// 外加周期性的完整状态关键帧。跳转到第 N 回合时从不晚于 N 的最近关键帧出发，
+// 用管理系统重新执行其后的行动，耗时只与关键帧间隔有关，与回放长度无关
+// 相邻关键帧至少间隔 keyframeInterval 回合，并且要等其间的行动数据达到上一个关键帧大小的
+// 1 / KEYFRAME_ACTION_RATIO 才写下一个：大地图上关键帧很贵，间隔自动拉长，关键帧总量不超过行动数据的若干倍
+//
+// 文件布局（整数均为小端序）：
+//   头部    "PMRP"、版本、对局种子、角色数、回合数、关键帧间隔、关键帧数
+//   索引    每个关键帧的 (回合, 文件内偏移, 字节数)，按回合递增
+//   行动流  字节数 + 位流：第 t 回合第 i 个角色的行动位于第 (t * 角色数 + i) * 3 位
+//   关键帧  StateCodec 编码的状态，第 0 个为初始状态
+namespace ReplayFormat {
+constexpr uint32_t MAGIC = 0x50524D50; // "PMRP"
+constexpr uint16_t VERSION = 1;
+constexpr int BITS_PER_ACTION = 3;
+constexpr int DEFAULT_KEYFRAME_INTERVAL = 256;
+constexpr int KEYFRAME_ACTION_RATIO = 4;
+} // namespace ReplayFormat
+
+// 录制器：由 TurnBasedGameLoop 在每回合结束时调用
+class ReplayRecorder {
+  private:
+    struct KeyframeEntry {
+        uint32_t turn;
+        uint64_t offset; // 在 keyframeData 中的偏移，关键帧累计可以超过 4 GB
+        uint32_t size;   // 单个关键帧受 StateCodec::MAX_MAP_DIMENSION 限制，不超过 4 GB
+    };
+
+    uint64_t matchSeed;
+    int keyframeInterval;
+    int characterCount;
+    int turnCount;
+    bool started;
+    std::vector<uint8_t> actionBits;
+    uint64_t actionBitCount;
+    uint64_t keyframeActionBits; // 上一个关键帧时的 actionBitCount
+    std::vector<KeyframeEntry> keyframes;
+    std::vector<uint8_t> keyframeData;
+
+    void appendAction(Direction direction);
+    bool appendKeyframe(const GameStateManager &gameState); // 地图无法编码时返回 false，不追加
+    bool needsKeyframe() const;
+
+  public:
+    // keyframeInterval <= 0 时只保存初始状态
+    explicit ReplayRecorder(uint64_t seed, int keyframeInterval = ReplayFormat::DEFAULT_KEYFRAME_INTERVAL);
+
+    // 以当前状态作为第 0 回合开始录制（会清空之前的录制内容）
+    // 地图超出 StateCodec::MAX_MAP_DIMENSION 时无法录制，isStarted() 保持 false
+    void begin(const GameStateManager &initialState);
+
+    // 记录一回合：actions 为本回合交给管理系统的行动，stateAfter 为执行后的状态
+    // 行动数量与开始时的角色数不一致时返回 false，该回合不记录
+    bool recordTurn(const std::vector<Action> &actions, const GameStateManager &stateAfter);
+
+    bool isStarted() const { return started; }
+    int getTurnCount() const { return turnCount; }
+    uint64_t getMatchSeed() const { return matchSeed; }
+
+    // 生成完整的回放文件内容
+    std::vector<uint8_t> serialize() const;
+    bool saveToFile(const std::string &filename) const;
+};
+
+// 播放器：加载回放文件并重建任意回合的状态
+// 管理系统必须是确定性的（结果只取决于行动和当前状态），与录制时使用的规则一致
+class ReplayPlayer {
+  private:
+    struct KeyframeEntry {
+        int turn;
+        size_t offset;
+        size_t size;
+    };
+
+    std::unique_ptr<ManagementInterface> managementSystem;
+    std::vector<uint8_t> fileData;
+    uint64_t matchSeed;
+    int keyframeInterval;
+    int characterCount;
+    int turnCount;
+    std::vector<KeyframeEntry> keyframes;
+    size_t actionOffset; // 行动位流在 fileData 中的起始位置
+    std::vector<Action> turnActions;
+
+    bool parse();
+    Direction actionAt(uint64_t actionIndex) const;
+
+  public:
+    // management 为空时使用内置的 ManagementSystem
+    explicit ReplayPlayer(std::unique_ptr<ManagementInterface> management = nullptr);
+
+    bool loadFromFile(const std::string &filename);
+    bool loadFromBuffer(const std::vector<uint8_t> &data);
+
+    uint64_t getMatchSeed() const { return matchSeed; }
+    int getTurnCount() const { return turnCount; }
+    int getCharacterCount() const { return characterCount; }
+    int getKeyframeCount() const { return static_cast<int>(keyframes.size()); }
+    int getKeyframeInterval() const { return keyframeInterval; }
+
+    // 第 turn 回合（从 1 开始）所有角色的行动
+    bool getActions(int turn, std::vector<Action> &actions) const;
+
+    // 重建执行完前 turn 个回合后的状态（0 为初始状态），turn 超出范围时返回 false
+    bool seek(int turn, GameStateManager &out);
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include "binary_io.h"
+#include "game_state_manager.h"
+
+// 游戏状态的二进制编码：地图尺寸、每格 2 位的单元格、角色、分数、剩余豆子和回合数
+// 不依赖文本解析，解码一遍即可重建状态；回放关键帧和二进制存档共用
+namespace StateCodec {
+
+// 单张地图允许的最大边长，解码时用来拒绝损坏的数据；编码时超出的地图直接拒绝，保证写出的数据都能读回
+constexpr int MAX_MAP_DIMENSION = 1 << 15;
+
+// 地图超出 MAX_MAP_DIMENSION 时返回 false，不写入任何内容
+bool writeMap(ByteWriter &writer, const GameMap &map);
+bool readMap(ByteReader &reader, GameMap &map);
+
+void writeCharacters(ByteWriter &writer, const std::vector<Character> &characters);
+bool readCharacters(ByteReader &reader, std::vector<Character> &characters);
+
+bool writeGameState(ByteWriter &writer, const GameStateManager &gameState); // 同 writeMap
+bool readGameState(ByteReader &reader, GameStateManager &gameState);
+
+// 存档文件：带版本号的头部加若干分节，每节有自己的 CRC-32，读取时先校验再解码
+//   头部  "PMSV"、版本(u16)、保留(u16)、分节数(u32)、头部前 12 字节的 CRC(u32)
+//   分节  标签(u32)、载荷 CRC(u32)、载荷长度(u64)、载荷
+// 必需的分节为 MAP（地图）、CHAR（角色）、STAT（分数、剩余豆子、回合数），未知标签跳过，便于以后扩展
+constexpr uint32_t SAVE_MAGIC = 0x56534D50; // "PMSV"
+constexpr uint16_t SAVE_VERSION = 1;
+
+// 判断数据是否以存档文件头开始（用于区分旧版存档）
+bool isSaveFile(const uint8_t *data, size_t size);
+
+// 地图超出 MAX_MAP_DIMENSION 时返回空数组
+std::vector<uint8_t> encodeSaveFile(const GameStateManager &gameState);
+bool decodeSaveFile(const uint8_t *data, size_t size, GameStateManager &gameState);
+
+} // namespace StateCodec
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 工作窃取线程池
+// 每个工作线程拥有自己的任务队列：优先从自己队列尾部取任务，
+// 自己的队列为空时从其他线程队列头部窃取，负载不均时也能保持所有核心忙碌
+class ThreadPool {
+  public:
+    using Task = std::function<void()>;
+
+  private:
+    struct WorkerQueue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    std::vector<std::unique_ptr<WorkerQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex sleepMutex;
+    std::condition_variable wakeCondition; // 有新任务或正在关闭
+    std::condition_variable idleCondition; // 所有任务已完成
+
+    std::atomic<int> queuedTasks;  // 队列中尚未被取走的任务数
+    std::atomic<int> pendingTasks; // 已提交但尚未执行完的任务数
+    std::atomic<unsigned int> nextQueue;
+    bool stopping;
+
+    void workerLoop(int index);
+    bool popTask(int index, Task &task);
+
+  public:
+    // threadCount <= 0 时使用全部硬件线程
+    explicit ThreadPool(int threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    int getThreadCount() const { return static_cast<int>(workers.size()); }
+
+    // 提交任务；在工作线程内提交时放入该线程自己的队列
+    void submit(Task task);
+
+    // 阻塞直到所有已提交的任务执行完毕
+    void waitIdle();
+
+    // 当前线程在所属线程池中的编号，非工作线程返回 -1
+    static int currentWorkerIndex();
+
+    // 硬件线程数（至少为 1）
+    static int hardwareThreadCount();
+};
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "match_runner.h"
+#include <string>
+#include <vector>
+
+// 参赛 AI 版本
+struct TournamentAgent {
+    std::string name;
+    AgentFactory factory;
+
+    TournamentAgent() {}
+    TournamentAgent(const std::string &n, const AgentFactory &f) : name(n), factory(f) {}
+};
+
+// 锦标赛配置
+struct TournamentConfig {
+    uint64_t baseSeed; // 第 i 张地图使用对局种子 baseSeed + i
+    int seedCount;     // 地图数量，每张地图上每组对阵各打一局
+    int threadCount;   // 工作线程数，<= 0 表示使用全部硬件线程
+    MatchConfig match;
+    const MapPack *mapPack; // 非空时先从地图包取地图（见 loadMatchMap），不持有
+
+    TournamentConfig() : baseSeed(1), seedCount(100), threadCount(0), mapPack(nullptr) {}
+};
+
+// 一组对阵（吃豆人 AI vs 怪物 AI）的统计结果
+struct PairingStats {
+    std::string pacmanAgent;
+    std::string monsterAgent;
+    int matches;
+    int pacmanWins;
+    int monsterWins;
+    int draws;
+    int failedSetups; // 地图空地不足无法开局的次数
+    long long totalTurns;
+    long long totalPacmanScore;
+    long long totalMonsterScore;
+    int minTurns;
+    int maxTurns;
+    long long pacmanThinkOverruns; // 超出思考时间预算的回合数（见 MatchConfig::thinkTimeMs）
+    long long monsterThinkOverruns;
+
+    PairingStats()
+        : matches(0), pacmanWins(0), monsterWins(0), draws(0), failedSetups(0), totalTurns(0), totalPacmanScore(0),
+          totalMonsterScore(0), minTurns(0), maxTurns(0), pacmanThinkOverruns(0), monsterThinkOverruns(0) {}
+
+    void addResult(const MatchResult &result);
+    void merge(const PairingStats &other);
+};
+
+// 锦标赛汇总结果
+struct TournamentResult {
+    std::vector<PairingStats> pairings;
+    int totalMatches;
+    long long totalTurns;
+    int threadCount;
+    double elapsedSeconds;
+
+    TournamentResult() : totalMatches(0), totalTurns(0), threadCount(0), elapsedSeconds(0.0) {}
+
+    double matchesPerSecond() const { return elapsedSeconds > 0.0 ? totalMatches / elapsedSeconds : 0.0; }
+};
+
+// 锦标赛运行器 - 把 (地图种子, 对阵组合) 任务分发到工作窃取线程池
+// 每个工作线程拥有自己的地图生成器、游戏状态和 AI 实例，对局之间不共享可变状态；
+// 统计数据先写入各线程私有的缓冲区，全部完成后再合并，运行过程中无需加锁
+class TournamentRunner {
+  private:
+    TournamentConfig config;
+    std::vector<TournamentAgent> pacmanAgents;
+    std::vector<TournamentAgent> monsterAgents;
+
+  public:
+    explicit TournamentRunner(const TournamentConfig &tournamentConfig);
+
+    // 注册参赛 AI；所有吃豆人 AI 与所有怪物 AI 两两对阵
+    void addPacmanAgent(const std::string &name, const AgentFactory &factory);
+    void addMonsterAgent(const std::string &name, const AgentFactory &factory);
+
+    // 运行全部对局并返回汇总统计
+    TournamentResult run();
+};
@@ -0,0 +1,107 @@
+#pragma once
+
+#include "profile_clock.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// 时间线追踪：记录每个回合及其各阶段（视野、决策、管理系统、状态记录、渲染等）的起止时间，
+// 结束时写成 Chrome trace-event JSON，可直接用 Perfetto（ui.perfetto.dev）或 chrome://tracing 打开。
+// 每个线程第一次记录时在登记表中领取一个自己的缓冲区（只有这一次加锁），之后只往自己的缓冲区追加，
+// 线程之间没有任何同步；缓冲区由追踪器持有，线程退出后事件仍然保留。
+// 同一时刻只有一个追踪器处于安装状态；没有安装时 TraceSpan 只做一次原子读取
+class TraceRecorder {
+  public:
+    // 一段时间区间；名称、类别和参数名必须是字符串字面量（只保存指针）
+    struct Event {
+        const char *name;
+        const char *category;
+        const char *argName; // 为空时没有参数
+        long long arg;
+        uint64_t start; // ProfileClock 读数
+        uint64_t end;
+    };
+
+  private:
+    static constexpr size_t CHUNK_EVENTS = 4096;
+
+    struct ThreadBuffer {
+        int threadId;
+        std::string threadName;
+        std::vector<std::unique_ptr<Event[]>> chunks;
+        size_t count;   // 已记录的事件数
+        size_t dropped; // 超出上限被丢弃的事件数
+
+        ThreadBuffer() : threadId(0), count(0), dropped(0) {}
+    };
+
+    static std::atomic<TraceRecorder *> activeRecorder;
+
+    uint64_t recorderId; // 进程内唯一，线程局部缓存据此判断缓冲区属于哪个追踪器
+    uint64_t startTicks;
+    size_t maxEventsPerThread;
+    std::mutex registryMutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+    ThreadBuffer &localBuffer();
+    void writeJson(std::ostream &out);
+
+  public:
+    // 每个线程最多保留 maxEventsPerThread 个事件（每个事件 40 字节），超出的只计数
+    explicit TraceRecorder(size_t maxEventsPerThread = size_t(1) << 22);
+    // 仍处于安装状态时自动卸载
+    ~TraceRecorder();
+
+    TraceRecorder(const TraceRecorder &) = delete;
+    TraceRecorder &operator=(const TraceRecorder &) = delete;
+
+    // 安装追踪器（nullptr 卸载），此后所有线程的 TraceSpan 都记入它
+    static void install(TraceRecorder *recorder) { activeRecorder.store(recorder, std::memory_order_release); }
+    static TraceRecorder *active() { return activeRecorder.load(std::memory_order_acquire); }
+
+    // 记录当前线程的一个区间
+    void record(const char *name, const char *category, const char *argName, long long arg, uint64_t start,
+                uint64_t end);
+
+    // 设置当前线程在时间线上显示的名称（默认为线程池的 worker N 或 thread N）
+    void setThreadName(const std::string &name);
+
+    size_t getEventCount();
+    size_t getDroppedCount();
+
+    // 写出 Chrome trace-event JSON；调用前应卸载追踪器并确保被追踪的线程都已停止记录
+    std::string toJson();
+    bool writeFile(const std::string &path);
+};
+
+// 作用域区间：构造时开始，析构或 end() 时结束并记入当时安装的追踪器
+class TraceSpan {
+  private:
+    TraceRecorder *recorder;
+    const char *name;
+    const char *category;
+    const char *argName;
+    long long arg;
+    uint64_t start;
+
+  public:
+    TraceSpan(const char *spanName, const char *spanCategory, const char *spanArgName = nullptr, long long spanArg = 0)
+        : recorder(TraceRecorder::active()), name(spanName), category(spanCategory), argName(spanArgName),
+          arg(spanArg), start(recorder ? ProfileClock::now() : 0) {}
+    ~TraceSpan() { end(); }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+    void end() {
+        if (recorder) {
+            recorder->record(name, category, argName, arg, start, ProfileClock::now());
+            recorder = nullptr;
+        }
+    }
+};
@@ -4,10 +4,17 @@
 #include "game_control_system.h"
 #include "game_state_manager.h"
 #include "management_interface.h"
+#include "replay.h"
+#include "turn_profiler.h"
 #include "visibility_system.h"
+#include <atomic>
+#include <condition_variable>
 #include <memory>
+#include <mutex>
 #include <vector>
 
+class ThreadPool;
+
 // 回合制游戏循环 - 协调AI决策、管理系统和渲染
 class TurnBasedGameLoop {
   private:
@@ -15,15 +22,74 @@ class TurnBasedGameLoop {
     GameControlSystem controlSystem;
     VisibilitySystem pacmanVisibilitySystem;  // 吃豆人视野系统
     VisibilitySystem monsterVisibilitySystem; // 怪物视野系统
+    std::vector<VisibleArea> observations;    // 每个角色一份视野缓冲区，跨回合复用，并行决策时互不干扰
+    std::vector<Action> turnActions;          // 本回合各角色的行动，跨回合复用
 
     std::vector<std::unique_ptr<AIInterface>> aiAgents;
     std::unique_ptr<ManagementInterface> managementSystem;
 
+    ReplayRecorder *replayRecorder; // 不持有，可为空
+
+    // 每回合各角色的视野和决策耗时（时钟计数），由执行决策的线程各写各的下标，收集完成后在回合线程上计入剖析器
+    struct AgentTiming {
+        uint64_t viewTicks;
+        uint64_t decisionTicks;
+        bool hasView;
+        bool hasDecision;
+    };
+    TurnProfiler *profiler; // 不持有，可为空；只在 TurnProfiler::ENABLED 时生效
+    std::vector<AgentTiming> agentTimings;
+
+    // 一回合的并行决策：调用线程和池中的帮手任务轮流领取下一个角色下标，领完即退出。
+    // 调用线程自己也领取任务，所以即使在 decisionPool 的工作线程里执行回合、池中没有空闲线程也不会死锁；
+    // 帮手任务可能在本回合结束后才开始运行，因此只通过共享指针持有本结构，领不到下标时不会再碰游戏循环。
+    // helpersInFlight 是已提交但尚未退出的帮手数：帮手最后一次访问本结构后以 release 递减，
+    // 回合线程以 acquire 读到 0 时才复用本结构，否则另建一个
+    struct DecisionBatch {
+        std::atomic<int> nextIndex;
+        std::atomic<int> completed;
+        std::atomic<int> count;
+        std::atomic<int> helpersInFlight;
+        std::mutex mutex;
+        std::condition_variable finished;
+
+        DecisionBatch() : nextIndex(0), completed(0), count(0), helpersInFlight(0) {}
+    };
+    ThreadPool *decisionPool; // 不持有，为空时按角色顺序串行决策
+    std::shared_ptr<DecisionBatch> decisionBatch;
+
+    // 思考时间预算：每个决策作为任务提交到线程池，调用线程只等到截止时间。到期未返回的决策按 STAY 处理并记一次超时；
+    // 该 AI 的上一次调用返回之前，之后的回合也直接按 STAY 处理并记超时，迟到的结果被丢弃。
+    // 槽位（含视野缓冲区）由仍在运行的任务引用，创建后地址不变，直到游戏循环析构
+    struct AgentSlot {
+        VisibleArea view;
+        DecisionDeadline deadline;
+        Action result;
+        uint64_t decisionTicks; // 最近一次返回的决策耗时（受 slotMutex 保护，仅剖析时记录）
+        bool thinking; // 决策任务已提交且尚未返回（受 slotMutex 保护）
+        bool answered; // result 是最近一次提交的决策结果（受 slotMutex 保护）
+        int overruns;
+
+        AgentSlot() : decisionTicks(0), thinking(false), answered(false), overruns(0) {}
+    };
+    int thinkTimeMs; // <= 0 表示不限时
+    std::vector<std::unique_ptr<AgentSlot>> agentSlots;
+    std::vector<int> submittedAgents;         // 本回合提交了决策的角色下标
+    std::unique_ptr<ThreadPool> watchdogPool; // 未设置 decisionPool 时限时决策使用的线程池
+    std::mutex slotMutex;
+    std::condition_variable slotChanged;
+    int runningDecisions; // 仍在运行的决策任务数（受 slotMutex 保护）
+
     bool isRunning;
     int currentTurn;
 
   public:
     TurnBasedGameLoop(const GameMap &map, const std::vector<Character> &characters);
+    // 等待仍在运行的限时决策返回（先通知它们截止时间已过）；从不检查截止时间又永不返回的 AI 会让析构一直阻塞
+    ~TurnBasedGameLoop();
+
+    TurnBasedGameLoop(const TurnBasedGameLoop &) = delete;
+    TurnBasedGameLoop &operator=(const TurnBasedGameLoop &) = delete;
 
     // 设置AI代理
     void setAIAgent(int characterIndex, std::unique_ptr<AIInterface> ai);
@@ -31,6 +97,29 @@ class TurnBasedGameLoop {
     // 设置管理系统
     void setManagementSystem(std::unique_ptr<ManagementInterface> management);
 
+    // 设置行动日志录制器：以当前状态为起点开始录制，此后每回合的行动都交给它；传入 nullptr 停止录制
+    // 录制器由调用者持有，须在游戏循环之后销毁或先解除
+    void setReplayRecorder(ReplayRecorder *recorder);
+
+    // 设置回合剖析器：此后每回合各阶段和各角色的耗时都计入它；传入 nullptr 停止计时
+    // 剖析器由调用者持有；不以 PACMAN_ENABLE_PROFILING 构建时不计时
+    void setProfiler(TurnProfiler *turnProfiler) { profiler = turnProfiler; }
+    TurnProfiler *getProfiler() const { return profiler; }
+
+    // 设置决策线程池：非空时每回合所有角色的视野计算和 getAction 在池上并发执行，结果按角色顺序合并，
+    // 与串行执行逐位一致（要求各 AI 只读自己的视野和私有状态）。线程池由调用者持有，可被多个游戏循环共用
+    void setDecisionPool(ThreadPool *pool) { decisionPool = pool; }
+
+    // 设置每回合的 AI 思考时间预算（毫秒，<= 0 表示不限时，默认不限时）
+    // 限时时各 AI 的决策在线程池（decisionPool，未设置时自建一个每个 AI 一个线程的池）上并发执行，
+    // 通过 getActionWithDeadline 把截止时间交给 AI；到截止时间仍未返回的 AI 本回合按 STAY 处理并记一次超时。
+    // 限时的结果取决于实际耗时，不保证可复现；decisionPool 的线程数少于 AI 数量时排队等待也计入耗时
+    void setThinkTimeBudget(int milliseconds) { thinkTimeMs = milliseconds; }
+    int getThinkTimeBudget() const { return thinkTimeMs; }
+
+    // 第 characterIndex 个角色的 AI 累计超时次数（包括上一次决策尚未返回而被跳过的回合）
+    int getThinkOverruns(int characterIndex) const;
+
     // 游戏循环控制
     void start();
     void stop();
@@ -53,6 +142,18 @@ class TurnBasedGameLoop {
     void setGameState(const GameStateManager &state);
 
   private:
-    // 收集所有AI的决策
-    std::vector<Action> collectAIActions();
+    // 收集所有AI的决策，写入 actions（复用其容量）
+    void collectAIActions(std::vector<Action> &actions);
+
+    // 计算第 index 个角色的视野和决策，写入 actions[index]
+    void decideAction(size_t index, std::vector<Action> &actions);
+
+    // 领取并执行 batch 中尚未领取的决策，直到全部领完；只在领到下标时才访问 loop 和 actions
+    static void runDecisions(TurnBasedGameLoop *loop, DecisionBatch &batch, std::vector<Action> *actions);
+
+    // 限时收集决策，结果写入 actions（已按 STAY 初始化）
+    void collectTimedActions(std::vector<Action> &actions);
+
+    // 等待所有限时决策任务返回
+    void waitForRunningDecisions();
 };
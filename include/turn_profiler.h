@@ -0,0 +1,60 @@
+#pragma once
+
+#include "latency_histogram.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 回合耗时剖析：按阶段和按角色累计延迟直方图，对局结束后输出 JSON 或 CSV
+// 只有用 PACMAN_ENABLE_PROFILING 构建（CMake 选项 -DPACMAN_ENABLE_PROFILING=ON）时回合循环才会计时；
+// 否则 ENABLED 为 false，回合循环中的计时代码在编译期被整体去掉，设置剖析器也不会产生任何开销
+class TurnProfiler {
+  public:
+#ifdef PACMAN_ENABLE_PROFILING
+    static constexpr bool ENABLED = true;
+#else
+    static constexpr bool ENABLED = false;
+#endif
+
+    enum Phase {
+        VISIBILITY, // 每个角色的视野计算
+        DECISION,   // 每个角色的 getAction（限时时为 getActionWithDeadline）
+        COLLECT,    // 收集全部决策（并行或限时时为墙钟时间）
+        MANAGEMENT, // 管理系统 processActions
+        RECORDING,  // 回放状态记录和行动日志
+        TURN,       // 整个回合
+        PHASE_COUNT
+    };
+
+  private:
+    LatencyHistogram phases[PHASE_COUNT];
+    std::vector<LatencyHistogram> agentVisibility; // 按角色下标
+    std::vector<LatencyHistogram> agentDecision;
+
+  public:
+    static const char *phaseName(Phase phase);
+
+    // 记录一个阶段样本（纳秒）；只应由回合循环所在线程调用
+    void record(Phase phase, uint64_t nanos) { phases[phase].record(nanos); }
+
+    // 记录第 agent 个角色的视野或决策样本，同时计入对应的阶段直方图
+    void recordAgent(int agent, Phase phase, uint64_t nanos);
+
+    // 合并另一个剖析器的全部样本（多局汇总）
+    void merge(const TurnProfiler &other);
+    void reset();
+
+    const LatencyHistogram &getPhase(Phase phase) const { return phases[phase]; }
+    int getAgentCount() const { return static_cast<int>(agentDecision.size()); }
+    const LatencyHistogram &getAgentVisibility(int agent) const { return agentVisibility[agent]; }
+    const LatencyHistogram &getAgentDecision(int agent) const { return agentDecision[agent]; }
+    uint64_t getTurnCount() const { return phases[TURN].getCount(); }
+
+    // 每行一个直方图：scope,phase,count,min_ns,mean_ns,p50_ns,p90_ns,p99_ns,p999_ns,max_ns，
+    // scope 为 turn 或 agent<N>
+    std::string toCsv() const;
+    std::string toJson() const;
+
+    // 文件名以 .csv 结尾时写 CSV，否则写 JSON；失败返回 false
+    bool writeFile(const std::string &path) const;
+};
@@ -47,3 +47,15 @@ inline std::wstring GbkToWide(const std::string &gbkstr) {
     MultiByteToWideChar(CP_ACP, 0, gbkstr.c_str(), (int)gbkstr.size(), &wstrTo[0], size_needed);
     return wstrTo;
 }
+
+// UTF-16 到 GBK（系统 ANSI 代码页）转换，用于传给接受窄字符路径的接口
+inline std::string WideToGbk(const std::wstring &wstr) {
+    if (wstr.empty()) return std::string();
+
+    int size_needed = WideCharToMultiByte(CP_ACP, 0, wstr.c_str(), (int)wstr.size(), NULL, 0, NULL, NULL);
+    if (size_needed <= 0) return std::string();
+
+    std::string strTo(size_needed, 0);
+    WideCharToMultiByte(CP_ACP, 0, wstr.c_str(), (int)wstr.size(), &strTo[0], size_needed, NULL, NULL);
+    return strTo;
+}
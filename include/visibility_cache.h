@@ -0,0 +1,38 @@
+#pragma once
+
+#include "game_types.h"
+#include <cstdint>
+#include <vector>
+
+// 视野缓存
+// 对局中墙壁不会改变，从每个可走格子出发、某一视野半径下能看到哪些格子是固定的。
+// 缓存为每个可走格子保存一份可见掩码：视野窗口（边长 2 * radius + 1，中心为 (radius, radius)）
+// 每行一个 64 位字，第 x 位表示该行第 x 列在地图内且视线未被遮挡。
+// 缓存只依赖墙壁布局，由 VisibilitySystem::buildCache 构建并挂到 GameMap 上，
+// 地图的墙壁发生变化时 GameMap 会自动丢弃所有缓存
+class VisibilityCache {
+  private:
+    int radius;
+    int width;
+    int height;
+    int windowSize;
+    std::vector<int> cellSlots;  // 每个格子在 masks 中的槽位，墙壁为 -1
+    std::vector<uint64_t> masks; // 每个槽位 windowSize 个字
+
+    // 只允许 VisibilitySystem 填充掩码
+    friend class VisibilitySystem;
+    uint64_t *getMutableMasks(int x, int y);
+
+  public:
+    // cellIsWalkable 按行优先给出每个格子是否可走，长度为 width * height
+    VisibilityCache(int radius, int width, int height, const std::vector<bool> &cellIsWalkable);
+
+    int getRadius() const { return radius; }
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getWindowSize() const { return windowSize; }
+    size_t getSlotCount() const { return windowSize > 0 ? masks.size() / windowSize : 0; }
+
+    // 以 center 为中心的可见掩码（windowSize 个字）；center 不在地图内或是墙时返回 nullptr
+    const uint64_t *findMasks(const Position &center) const;
+};
@@ -1,26 +1,85 @@
 #pragma once
 
 #include "game_map.h"
+#include "game_state_manager.h"
 #include "game_types.h"
+#include "occupancy_grid.h"
+#include "visibility_cache.h"
 #include "visible_area.h"
 #include <vector>
 
+class ThreadPool;
+
 class VisibilitySystem {
   private:
+    // 视线依赖表
+    // Bresenham 路径的形状只取决于目标相对中心的偏移，与地图无关。构造时对曼哈顿距离内的每个目标
+    // 预先求出路径上需要检查的格子（中间点以及对角移动时的两个相邻格），按视野窗口的行合并成位掩码；
+    // 目标可见当且仅当这些格子都不是墙，运行时只需几次按字与运算
+    struct SightMask {
+        int row;       // 视野窗口中的行
+        uint64_t bits; // 该行需要检查的列
+    };
+    struct SightLine {
+        int localX; // 目标在视野窗口中的坐标，中心为 (radius, radius)
+        int localY;
+        int maskBegin; // 在 sightMasks 中的起始下标
+        int maskCount;
+    };
+
     int visibilityRadius;
+    std::vector<SightLine> sightLines;
+    std::vector<SightMask> sightMasks;
+    std::vector<uint64_t> diamondRows; // 每行曼哈顿距离内的列
+
+    void buildSightTable();
+
+    // 查表求出以 center 为中心的可见掩码（格式同 VisibilityCache）
+    void computeVisibleMasks(const Position &center, const GameMap &map, uint64_t *visibleRows) const;
+
+    // 按可见掩码填充视野内容，曼哈顿距离内的界外格子标为 OVERBOUND，其余保持 UNKNOWN
+    // occupancy 非空时用占用索引查角色，否则扫描 characters
+    void fillVisibleArea(VisibleArea &visibleArea, const Position &center, const uint64_t *visibleRows,
+                         const GameMap &map, const std::vector<Character> &characters,
+                         const OccupancyGrid *occupancy) const;
+
+    void computeVisibleArea(const Position &center, const GameMap &map, const std::vector<Character> &characters,
+                            const OccupancyGrid *occupancy, VisibleArea &visibleArea) const;
 
-    // Bresenham's line 算法检查视线
+    // Bresenham's line 算法检查视线（逐格查询地图，作为依赖表的参照实现）
     bool isVisible(const Position &from, const Position &to, const GameMap &map) const;
     int manhattanDistance(const Position &a, const Position &b) const;
 
     // 将CellType转换为VisibleArea::CellContent
     VisibleArea::CellContent getCellContent(const Position &pos, const GameMap &map,
-                                            const std::vector<Character> &characters) const;
+                                            const std::vector<Character> &characters,
+                                            const OccupancyGrid *occupancy = nullptr) const;
 
   public:
+    // radius 必须在 [0, GameConfig::MAX_VISIBILITY_RADIUS] 内（视野每行的墙壁位要放进一个 64 位字），
+    // 超出范围抛出 std::invalid_argument，不会悄悄截断
     VisibilitySystem(int radius);
 
-    // 计算指定位置的可见区域
+    int getRadius() const { return visibilityRadius; }
+
+    // 为 map 的所有可走格子预计算当前半径的可见掩码并挂到 map 上
+    // pool 非空时按行分块并行构建：调用线程和池中的帮手任务轮流领取行块，只等待本次的行块完成，
+    // 不等待池中的其他任务，所以池可以与其他工作共用，也可以在池的工作线程内调用
+    void buildCache(GameMap &map, ThreadPool *pool = nullptr) const;
+
+    // 计算指定位置的可见区域（map 上有对应半径的缓存时直接查缓存，否则查视线依赖表）
     VisibleArea calculateVisibleArea(const Position &center, const GameMap &map,
                                      const std::vector<Character> &characters) const;
+
+    // 同上，但通过游戏状态的占用索引查角色，视野开销与角色数量无关
+    VisibleArea calculateVisibleArea(const Position &center, const GameStateManager &gameState) const;
+
+    // 写入调用者提供的视野对象（不分配内存），回合循环中复用同一个对象
+    void calculateVisibleArea(const Position &center, const GameStateManager &gameState,
+                              VisibleArea &visibleArea) const;
+
+    // 参照实现：对每个目标重新走一遍 Bresenham，结果必须与 calculateVisibleArea 完全一致
+    // 仅用于差分验证和基准对照
+    VisibleArea calculateVisibleAreaReference(const Position &center, const GameMap &map,
+                                              const std::vector<Character> &characters) const;
 };
@@ -1,18 +1,23 @@
 #pragma once
 
+#include "config.h"
 #include "game_types.h"
-#include <vector>
+#include <cstdint>
 
 // 前向声明
 class VisibilitySystem;
 
 // VisibleArea 类
+// 视野大小由视野半径决定，上限为 MAX_SIZE x MAX_SIZE。单元格每格一个字节，按行紧凑存放在对象内部的
+// 固定缓冲区中（行跨度等于宽度），构造、填充和读取都不分配堆内存；复制时只拷贝实际使用的部分
 class VisibleArea {
   public:
-    enum class CellContent { EMPTY, WALL, DOT, PACMAN, MONSTER, UNKNOWN, OVERBOUND };
+    enum class CellContent : uint8_t { EMPTY, WALL, DOT, PACMAN, MONSTER, UNKNOWN, OVERBOUND };
+
+    static constexpr int MAX_SIZE = 2 * GameConfig::MAX_VISIBILITY_RADIUS + 1;
 
   private:
-    std::vector<std::vector<CellContent>> grid;
+    CellContent cells[MAX_SIZE * MAX_SIZE];
     int width;
     int height;
     Position centerPosition;
@@ -20,12 +25,22 @@ class VisibleArea {
     // 只允许 VisibilitySystem 修改视野内容
     friend class VisibilitySystem;
     void setCell(int x, int y, CellContent content);
+    void fill(CellContent content);
+    void resize(int w, int h); // 同构造函数，超出范围时抛出异常而不是截断
 
   public:
-    VisibleArea(int w, int h);
+    VisibleArea();
+    VisibleArea(int w, int h); // 宽高必须在 [0, MAX_SIZE] 内，否则抛出 std::invalid_argument
+
+    VisibleArea(const VisibleArea &other);
+    VisibleArea &operator=(const VisibleArea &other);
 
     // AI 只能读取视野，不能修改
     CellContent getCell(int x, int y) const;
     int getWidth() const { return width; }
     int getHeight() const { return height; }
+
+    // 行访问：返回第 y 行首个单元格的指针，该行共 getWidth() 个单元格
+    // 调用者需保证 0 <= y < getHeight()
+    const CellContent *getRow(int y) const { return cells + y * width; }
 };
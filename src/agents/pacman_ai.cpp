@@ -1,17 +1,18 @@
 #include "../../include/pacman_ai.h"
-#include <ctime>
 
-PacmanAI::PacmanAI() { randomEngine.seed(static_cast<unsigned int>(std::time(nullptr))); }
+// 不使用系统时间播种，保证对局可复现；需要不同行为时请传入种子
+PacmanAI::PacmanAI() : randomEngine(std::mt19937::default_seed) {}
 
-PacmanAI::PacmanAI(unsigned int seed) { randomEngine.seed(seed); }
+PacmanAI::PacmanAI(unsigned int seed) : randomEngine(seed) {}
 
 Action PacmanAI::getAction(const VisibleArea &visibleArea) {
-    // 获取所有有效的移动方向
-    std::vector<Direction> validMoves = getValidMoves(visibleArea);
+    // 获取所有有效的移动方向（最多 4 个，放在栈上的数组里，每回合不分配内存）
+    Direction validMoves[MAX_MOVES];
+    int moveCount = getValidMoves(visibleArea, validMoves);
 
     // 随机选择一个方向
-    if (!validMoves.empty()) {
-        int index = randomEngine() % validMoves.size();
+    if (moveCount > 0) {
+        int index = static_cast<int>(randomEngine() % static_cast<unsigned int>(moveCount));
         return Action{validMoves[index]};
     }
 
@@ -20,23 +21,23 @@ Action PacmanAI::getAction(const VisibleArea &visibleArea) {
 }
 
 // 辅助方法实现
-std::vector<Direction> PacmanAI::getValidMoves(const VisibleArea &visibleArea) const {
-    std::vector<Direction> validMoves;
+int PacmanAI::getValidMoves(const VisibleArea &visibleArea, Direction validMoves[MAX_MOVES]) const {
+    int moveCount = 0;
 
     Direction directions[] = {Direction::UP, Direction::DOWN, Direction::LEFT, Direction::RIGHT};
 
     for (Direction dir : directions) {
         if (canMove(visibleArea, dir)) {
-            validMoves.push_back(dir);
+            validMoves[moveCount++] = dir;
         }
     }
 
     // 如果没有有效移动，可以选择停留
-    if (validMoves.empty()) {
-        validMoves.push_back(Direction::STAY);
+    if (moveCount == 0) {
+        validMoves[moveCount++] = Direction::STAY;
     }
 
-    return validMoves;
+    return moveCount;
 }
 
 bool PacmanAI::canMove(const VisibleArea &visibleArea, Direction dir) const {
@@ -1,11 +1,17 @@
 #include "../../include/game_control_system.h"
-#include <fstream>
+#include "../../include/binary_io.h"
+#include "../../include/bit_ops.h"
+#include "../../include/mapped_file.h"
+#include "../../include/state_codec.h"
+#include <algorithm>
+#include <cstring>
 
-GameControlSystem::GameControlSystem()
-    : isPaused(false), playbackStatus(PlaybackStatus::PLAYING), currentHistoryIndex(-1), maxHistorySize(100) {}
+GameControlSystem::GameControlSystem() : GameControlSystem(100) {}
 
-GameControlSystem::GameControlSystem(int maxHistory)
-    : isPaused(false), playbackStatus(PlaybackStatus::PLAYING), currentHistoryIndex(-1), maxHistorySize(maxHistory) {}
+GameControlSystem::GameControlSystem(int maxHistory, int interval)
+    : isPaused(false), playbackStatus(PlaybackStatus::PLAYING), segmentHead(0), segmentCount(0), historySize(0),
+      currentHistoryIndex(-1), maxHistorySize(maxHistory), keyframeInterval(std::max(1, interval)),
+      cursorSerial(-1), cursorTurn(0), cursorCharacterOffset(0), cursorCellOffset(0) {}
 
 void GameControlSystem::pause() {
     isPaused = true;
@@ -20,129 +26,398 @@ void GameControlSystem::resume() {
 void GameControlSystem::togglePause() { isPaused = !isPaused; }
 
 bool GameControlSystem::saveGame(const GameStateManager &gameState, const std::string &filename) const {
-    std::ofstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
+    std::vector<uint8_t> bytes = StateCodec::encodeSaveFile(gameState);
+    return !bytes.empty() && writeFileBytes(filename, bytes);
+}
+
+namespace {
+
+// 旧版存档：size_t 长度 + 文本地图、三个 int 分数、size_t 数量 + Character 结构体原样转储
+// 只能读取同一平台写出的文件；不含回合数，回合数按 1 处理
+bool loadLegacyGame(const uint8_t *data, size_t size, GameStateManager &gameState) {
+    size_t offset = 0;
+    auto readRaw = [&](void *out, size_t count) {
+        if (count > size - offset) return false;
+        std::memcpy(out, data + offset, count);
+        offset += count;
+        return true;
+    };
+
+    size_t mapSize = 0;
+    if (!readRaw(&mapSize, sizeof(mapSize)) || mapSize > size - offset) {
         return false;
     }
+    GameState state;
+    state.map = GameMap(0, 0);
+    if (!state.map.loadFromString(std::string_view(reinterpret_cast<const char *>(data + offset), mapSize))) {
+        return false;
+    }
+    offset += mapSize;
 
-    // 保存游戏状态
-    std::string mapData = gameState.getMap().saveToString();
+    size_t charCount = 0;
+    if (!readRaw(&state.pacmanScore, sizeof(int)) || !readRaw(&state.monsterScore, sizeof(int)) ||
+        !readRaw(&state.remainingDots, sizeof(int)) || !readRaw(&charCount, sizeof(charCount)) ||
+        charCount > (size - offset) / sizeof(Character)) {
+        return false;
+    }
+    state.characters.resize(charCount);
+    for (size_t i = 0; i < charCount; ++i) {
+        readRaw(&state.characters[i], sizeof(Character));
+    }
 
-    // 写入地图数据长度
-    size_t mapSize = mapData.size();
-    file.write(reinterpret_cast<const char *>(&mapSize), sizeof(mapSize));
+    gameState.restoreState(state);
+    return true;
+}
 
-    // 写入地图数据
-    file.write(mapData.c_str(), mapSize);
+} // namespace
 
-    // 保存其他状态数据
-    int pacmanScore = gameState.getPacmanScore();
-    int monsterScore = gameState.getMonsterScore();
-    int remainingDots = gameState.getRemainingDots();
+bool GameControlSystem::loadGame(GameStateManager &gameState, const std::string &filename) const {
+    MappedFile file;
+    if (!file.open(filename)) {
+        return false;
+    }
+    if (StateCodec::isSaveFile(file.data(), file.size())) {
+        return StateCodec::decodeSaveFile(file.data(), file.size(), gameState);
+    }
+    return loadLegacyGame(file.data(), file.size(), gameState);
+}
 
-    file.write(reinterpret_cast<const char *>(&pacmanScore), sizeof(pacmanScore));
-    file.write(reinterpret_cast<const char *>(&monsterScore), sizeof(monsterScore));
-    file.write(reinterpret_cast<const char *>(&remainingDots), sizeof(remainingDots));
+void GameControlSystem::recordState(const GameStateManager &gameState) {
+    // 如果当前不在历史末尾，删除后面的历史
+    if (currentHistoryIndex < historySize - 1) {
+        truncateAfter(currentHistoryIndex);
+    }
 
-    // 保存角色数据
-    const auto &characters = gameState.getCharacters();
-    size_t charCount = characters.size();
-    file.write(reinterpret_cast<const char *>(&charCount), sizeof(charCount));
+    // 当前段已满或无法用增量表示（地图尺寸、角色列表变化等）时开始新段
+    if (segmentCount == 0 || needsKeyframe(segmentAt(segmentCount - 1)) ||
+        !appendDelta(segmentAt(segmentCount - 1), gameState)) {
+        startSegment(gameState);
+    }
+    captureFrame(gameState);
+    historySize++;
+    currentHistoryIndex++;
 
-    for (const auto &character : characters) {
-        file.write(reinterpret_cast<const char *>(&character), sizeof(Character));
+    // 限制历史大小
+    if (maxHistorySize > 0 && historySize > maxHistorySize) {
+        evictOldest();
+        currentHistoryIndex--;
     }
+}
 
-    file.close();
-    return true;
+void GameControlSystem::captureFrame(const GameStateManager &gameState) {
+    // 只复制分块指针，与地图面积无关
+    lastFrame.map = gameState.getMap();
+    lastFrame.characters = gameState.getCharacters();
+    lastFrame.pacmanScore = gameState.getPacmanScore();
+    lastFrame.monsterScore = gameState.getMonsterScore();
+    lastFrame.remainingDots = gameState.getRemainingDots();
+    lastFrame.turnCount = gameState.getTurnCount();
 }
 
-bool GameControlSystem::loadGame(GameStateManager &gameState, const std::string &filename) const {
-    std::ifstream file(filename, std::ios::binary);
-    if (!file.is_open()) {
+bool GameControlSystem::appendDelta(HistorySegment &segment, const GameStateManager &gameState) {
+    const GameMap &map = gameState.getMap();
+    const GameMap &previousMap = lastFrame.map;
+    const std::vector<Character> &characters = gameState.getCharacters();
+
+    // 先检查能否表示为增量，确认之后才写入；格子数超限时撤回本回合已写入的部分
+    if (map.getWidth() != previousMap.getWidth() || map.getHeight() != previousMap.getHeight() ||
+        characters.size() != lastFrame.characters.size() || characters.size() > 0x7FFF ||
+        static_cast<uint64_t>(map.getWidth()) * map.getHeight() > UINT32_MAX) {
         return false;
     }
+    for (size_t i = 0; i < characters.size(); ++i) {
+        const Character &previous = lastFrame.characters[i];
+        int dx = characters[i].position.x - previous.position.x;
+        int dy = characters[i].position.y - previous.position.y;
+        if (characters[i].id != previous.id || characters[i].type != previous.type || dx < INT8_MIN || dx > INT8_MAX ||
+            dy < INT8_MIN || dy > INT8_MAX) {
+            return false;
+        }
+    }
 
-    // 读取地图数据长度
-    size_t mapSize;
-    file.read(reinterpret_cast<char *>(&mapSize), sizeof(mapSize));
+    TurnDelta turn;
+    turn.pacmanScore = gameState.getPacmanScore();
+    turn.monsterScore = gameState.getMonsterScore();
+    turn.remainingDots = gameState.getRemainingDots();
+    turn.turnCount = gameState.getTurnCount();
+    turn.characterCount = 0;
+    turn.cellCount = 0;
+    size_t cellCount = 0;
+
+    for (size_t i = 0; i < characters.size(); ++i) {
+        const Character &previous = lastFrame.characters[i];
+        if (characters[i].position != previous.position || characters[i].isAlive != previous.isAlive) {
+            CharacterDelta delta;
+            delta.indexAndAlive = static_cast<uint16_t>(i | (characters[i].isAlive ? 0x8000 : 0));
+            delta.dx = static_cast<int8_t>(characters[i].position.x - previous.position.x);
+            delta.dy = static_cast<int8_t>(characters[i].position.y - previous.position.y);
+            segment.characterDeltas.push_back(delta);
+            turn.characterCount++;
+        }
+    }
 
-    // 读取地图数据
-    std::string mapData(mapSize, '\0');
-    file.read(&mapData[0], mapSize);
+    // 仍与上一次记录共享的分块没有被写过，跳过；其余分块按字比较墙壁和豆子位平面，
+    // 只有发生变化的字才逐位展开。每回合的开销与被改动的分块数成正比，而不是与地图面积成正比
+    int wordsPerRow = map.getWordsPerRow();
+    for (int tile = 0; tile < map.getTileCount(); ++tile) {
+        if (map.sharesTile(previousMap, tile)) {
+            continue;
+        }
+        int endRow = std::min((tile + 1) * GameMap::TILE_ROWS, map.getHeight());
+        for (int y = tile * GameMap::TILE_ROWS; y < endRow; ++y) {
+            const uint64_t *wallRow = map.getWallBitsRow(y);
+            const uint64_t *dotRow = map.getDotBitsRow(y);
+            const uint64_t *previousWallRow = previousMap.getWallBitsRow(y);
+            const uint64_t *previousDotRow = previousMap.getDotBitsRow(y);
+            for (int w = 0; w < wordsPerRow; ++w) {
+                uint64_t changed = (wallRow[w] ^ previousWallRow[w]) | (dotRow[w] ^ previousDotRow[w]);
+                while (changed != 0) {
+                    int bit = BitOps::lowestSetBit(changed);
+                    uint64_t mask = 1ULL << bit;
+                    CellDelta delta;
+                    // GameMap 不限制尺寸，格子数可以超过 INT_MAX：下标按 uint32_t 计算，避免 int 乘法溢出
+                    delta.cell = static_cast<uint32_t>(y) * static_cast<uint32_t>(map.getWidth()) +
+                                 static_cast<uint32_t>(w * 64 + bit);
+                    delta.type = (wallRow[w] & mask)  ? CellType::WALL
+                                 : (dotRow[w] & mask) ? CellType::DOT
+                                                      : CellType::EMPTY;
+                    segment.cellDeltas.push_back(delta);
+                    cellCount++;
+                    changed &= changed - 1;
+                }
+            }
+        }
+    }
 
-    // 加载地图
-    GameMap map(0, 0);
-    if (!map.loadFromString(mapData)) {
-        file.close();
+    // 变化的格子太多时（例如整张地图被替换）不如直接记关键帧
+    if (cellCount > UINT16_MAX) {
+        segment.characterDeltas.resize(segment.characterDeltas.size() - turn.characterCount);
+        segment.cellDeltas.resize(segment.cellDeltas.size() - cellCount);
         return false;
     }
+    turn.cellCount = static_cast<uint16_t>(cellCount);
+    segment.turns.push_back(turn);
+    return true;
+}
 
-    // 读取其他状态数据
-    int pacmanScore, monsterScore, remainingDots;
-    file.read(reinterpret_cast<char *>(&pacmanScore), sizeof(pacmanScore));
-    file.read(reinterpret_cast<char *>(&monsterScore), sizeof(monsterScore));
-    file.read(reinterpret_cast<char *>(&remainingDots), sizeof(remainingDots));
+bool GameControlSystem::needsKeyframe(const HistorySegment &segment) const {
+    // 有上限时段的物理长度（含已并入关键帧的部分）也不超过上限，
+    // 否则同一段既在头部淘汰又在尾部追加，存储会无限增长
+    if (maxHistorySize > 0 && segment.turns.size() + 1 >= static_cast<size_t>(maxHistorySize)) {
+        return true;
+    }
+    return segment.entryCount() >= keyframeInterval &&
+           deltaBytes(segment) >= KEYFRAME_DELTA_RATIO * keyframeBytes(segment.keyframe);
+}
 
-    // 读取角色数据
-    size_t charCount;
-    file.read(reinterpret_cast<char *>(&charCount), sizeof(charCount));
+size_t GameControlSystem::keyframeBytes(const GameState &keyframe) {
+    const GameMap &map = keyframe.map;
+    size_t words = static_cast<size_t>(map.getWordsPerRow()) * map.getHeight();
+    return static_cast<size_t>(map.getWidth()) * map.getHeight() * sizeof(CellType) + 2 * words * sizeof(uint64_t) +
+           keyframe.characters.size() * sizeof(Character);
+}
 
-    std::vector<Character> characters(charCount);
-    for (size_t i = 0; i < charCount; ++i) {
-        file.read(reinterpret_cast<char *>(&characters[i]), sizeof(Character));
+size_t GameControlSystem::deltaBytes(const HistorySegment &segment) {
+    return (segment.turns.size() - segment.turnBegin) * sizeof(TurnDelta) +
+           (segment.characterDeltas.size() - segment.characterBegin) * sizeof(CharacterDelta) +
+           (segment.cellDeltas.size() - segment.cellBegin) * sizeof(CellDelta);
+}
+
+GameControlSystem::HistorySegment &GameControlSystem::acquireSegment() {
+    if (segmentCount == segmentSlots.size()) {
+        // 环已满（预热阶段或不限历史）：先把环展开成从 0 开始，再在末尾增加槽位
+        std::rotate(segmentSlots.begin(), segmentSlots.begin() + segmentHead, segmentSlots.end());
+        segmentHead = 0;
+        segmentSlots.emplace_back();
     }
 
-    file.close();
+    HistorySegment &segment = segmentAt(segmentCount++);
+    segment.turns.clear();
+    segment.characterDeltas.clear();
+    segment.cellDeltas.clear();
+    segment.turnBegin = 0;
+    segment.characterBegin = 0;
+    segment.cellBegin = 0;
+    return segment;
+}
 
-    // 更新游戏状态
-    gameState = GameStateManager(map, characters);
-    gameState.setPacmanScore(pacmanScore);
-    gameState.setMonsterScore(monsterScore);
+void GameControlSystem::startSegment(const GameStateManager &gameState) {
+    long long serial = 0;
+    if (segmentCount > 0) {
+        const HistorySegment &last = segmentAt(segmentCount - 1);
+        serial = last.firstSerial + last.entryCount();
+    }
 
-    return true;
+    // 逐字段复制赋值到槽位中已有的存储，避免构造临时 GameState
+    HistorySegment &segment = acquireSegment();
+    if (segment.turns.capacity() == 0) {
+        // 新槽位按一个关键帧间隔预留增量空间（格子按每回合一个估计），段内不再逐步扩容；
+        // 环填满之后记录一回合不分配内存
+        size_t reservedTurns = static_cast<size_t>(std::min(keyframeInterval, 1024));
+        segment.turns.reserve(reservedTurns);
+        segment.characterDeltas.reserve(reservedTurns * gameState.getCharacters().size());
+        segment.cellDeltas.reserve(reservedTurns);
+    }
+    segment.firstSerial = serial;
+    segment.keyframe.map = gameState.getMap();
+    segment.keyframe.characters = gameState.getCharacters();
+    segment.keyframe.pacmanScore = gameState.getPacmanScore();
+    segment.keyframe.monsterScore = gameState.getMonsterScore();
+    segment.keyframe.remainingDots = gameState.getRemainingDots();
+    segment.keyframe.turnCount = gameState.getTurnCount();
 }
 
-void GameControlSystem::recordState(const GameStateManager &gameState) {
-    // 如果当前不在历史末尾，删除后面的历史
-    if (currentHistoryIndex < static_cast<int>(stateHistory.size()) - 1) {
-        stateHistory.erase(stateHistory.begin() + currentHistoryIndex + 1, stateHistory.end());
+void GameControlSystem::applyDelta(GameState &state, const TurnDelta &turn, const CharacterDelta *characterDeltas,
+                                   const CellDelta *cellDeltas) {
+    for (uint16_t i = 0; i < turn.characterCount; ++i) {
+        Character &character = state.characters[characterDeltas[i].indexAndAlive & 0x7FFF];
+        character.position.x += characterDeltas[i].dx;
+        character.position.y += characterDeltas[i].dy;
+        character.isAlive = (characterDeltas[i].indexAndAlive & 0x8000) != 0;
     }
 
-    // 添加新状态
-    stateHistory.push_back(gameState);
-    currentHistoryIndex++;
+    int width = state.map.getWidth();
+    for (uint16_t i = 0; i < turn.cellCount; ++i) {
+        state.map.setCell(static_cast<int>(cellDeltas[i].cell % width), static_cast<int>(cellDeltas[i].cell / width),
+                          cellDeltas[i].type);
+    }
 
-    // 限制历史大小
-    if (static_cast<int>(stateHistory.size()) > maxHistorySize) {
-        stateHistory.erase(stateHistory.begin());
-        currentHistoryIndex--;
+    state.pacmanScore = turn.pacmanScore;
+    state.monsterScore = turn.monsterScore;
+    state.remainingDots = turn.remainingDots;
+    state.turnCount = turn.turnCount;
+}
+
+void GameControlSystem::evictOldest() {
+    HistorySegment &front = segmentAt(0);
+    cursorSerial = -1;
+
+    if (front.entryCount() == 1) {
+        // 整段淘汰：槽位留在环中等待复用
+        segmentHead = (segmentHead + 1) % segmentSlots.size();
+        segmentCount--;
+    } else {
+        // 把第一条增量并入关键帧，段的起点后移一条
+        const TurnDelta &turn = front.turns[front.turnBegin];
+        applyDelta(front.keyframe, turn, front.characterDeltas.data() + front.characterBegin,
+                   front.cellDeltas.data() + front.cellBegin);
+        front.characterBegin += turn.characterCount;
+        front.cellBegin += turn.cellCount;
+        front.turnBegin++;
+        front.firstSerial++;
     }
+    historySize--;
+}
+
+void GameControlSystem::truncateAfter(int index) {
+    cursorSerial = -1;
+    if (index < 0) {
+        segmentCount = 0;
+        historySize = 0;
+        return;
+    }
+
+    long long serial = serialOf(index);
+    int segmentIndex = findSegment(serial);
+    segmentCount = segmentIndex + 1;
+
+    HistorySegment &segment = segmentAt(segmentIndex);
+    size_t keptTurns = segment.turnBegin + static_cast<size_t>(serial - segment.firstSerial);
+    size_t keptCharacters = segment.characterBegin;
+    size_t keptCells = segment.cellBegin;
+    for (size_t i = segment.turnBegin; i < keptTurns; ++i) {
+        keptCharacters += segment.turns[i].characterCount;
+        keptCells += segment.turns[i].cellCount;
+    }
+    segment.turns.resize(keptTurns);
+    segment.characterDeltas.resize(keptCharacters);
+    segment.cellDeltas.resize(keptCells);
+    historySize = index + 1;
+
+    // 之后的增量要相对被保留的最后一条记录计算
+    captureFrame(stateAt(index));
+}
+
+int GameControlSystem::findSegment(long long serial) const {
+    // 在环上二分：找最后一个 firstSerial <= serial 的段
+    size_t low = 0;
+    size_t high = segmentCount;
+    while (low < high) {
+        size_t mid = (low + high) / 2;
+        if (segmentAt(mid).firstSerial <= serial) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return static_cast<int>(low) - 1;
+}
+
+GameStateManager GameControlSystem::stateAt(int index) const {
+    GameStateManager result;
+    if (index < 0 || index >= historySize) {
+        return result;
+    }
+
+    long long serial = serialOf(index);
+    const HistorySegment &segment = segmentAt(findSegment(serial));
+
+    // 游标在同一段内且不超过目标时从游标继续，否则从关键帧开始
+    if (cursorSerial < segment.firstSerial || cursorSerial > serial) {
+        cursorState = segment.keyframe;
+        cursorSerial = segment.firstSerial;
+        cursorTurn = segment.turnBegin;
+        cursorCharacterOffset = segment.characterBegin;
+        cursorCellOffset = segment.cellBegin;
+    }
+    while (cursorSerial < serial) {
+        const TurnDelta &turn = segment.turns[cursorTurn];
+        applyDelta(cursorState, turn, segment.characterDeltas.data() + cursorCharacterOffset,
+                   segment.cellDeltas.data() + cursorCellOffset);
+        cursorCharacterOffset += turn.characterCount;
+        cursorCellOffset += turn.cellCount;
+        cursorTurn++;
+        cursorSerial++;
+    }
+
+    result.restoreState(cursorState);
+    return result;
+}
+
+GameStateManager GameControlSystem::getHistoryState(int index) const { return stateAt(index); }
+
+size_t GameControlSystem::getHistoryMemoryBytes() const {
+    size_t bytes = segmentSlots.capacity() * sizeof(HistorySegment);
+    for (size_t i = 0; i < segmentCount; ++i) {
+        const HistorySegment &segment = segmentAt(i);
+        bytes += keyframeBytes(segment.keyframe) + deltaBytes(segment);
+    }
+    return bytes;
 }
 
 bool GameControlSystem::canUndo() const { return currentHistoryIndex > 0; }
 
-bool GameControlSystem::canRedo() const { return currentHistoryIndex < static_cast<int>(stateHistory.size()) - 1; }
+bool GameControlSystem::canRedo() const { return currentHistoryIndex < historySize - 1; }
 
 GameStateManager GameControlSystem::undo() {
     if (canUndo()) {
         currentHistoryIndex--;
-        return stateHistory[currentHistoryIndex];
     }
-    return stateHistory[currentHistoryIndex];
+    return stateAt(currentHistoryIndex);
 }
 
 GameStateManager GameControlSystem::redo() {
     if (canRedo()) {
         currentHistoryIndex++;
-        return stateHistory[currentHistoryIndex];
     }
-    return stateHistory[currentHistoryIndex];
+    return stateAt(currentHistoryIndex);
 }
 
 void GameControlSystem::clearHistory() {
-    stateHistory.clear();
+    segmentCount = 0;
+    historySize = 0;
     currentHistoryIndex = -1;
+    cursorSerial = -1;
 }
 
 void GameControlSystem::reset() {
@@ -152,18 +427,15 @@ void GameControlSystem::reset() {
 
 bool GameControlSystem::canStepBackward() const { return currentHistoryIndex > 0; }
 
-bool GameControlSystem::canStepForward() const {
-    return currentHistoryIndex < static_cast<int>(stateHistory.size()) - 1;
-}
+bool GameControlSystem::canStepForward() const { return currentHistoryIndex < historySize - 1; }
 
 GameStateManager GameControlSystem::stepBackward() {
     if (canStepBackward()) {
         currentHistoryIndex--;
         isPaused = true; // 后退后保持暂停
         playbackStatus = PlaybackStatus::STEPPED_BACKWARD;
-        return stateHistory[currentHistoryIndex];
     }
-    return stateHistory[currentHistoryIndex];
+    return stateAt(currentHistoryIndex);
 }
 
 GameStateManager GameControlSystem::stepForward() {
@@ -171,18 +443,16 @@ GameStateManager GameControlSystem::stepForward() {
         currentHistoryIndex++;
         isPaused = true; // 前进后保持暂停
         playbackStatus = PlaybackStatus::STEPPED_FORWARD;
-        return stateHistory[currentHistoryIndex];
     }
-    return stateHistory[currentHistoryIndex];
+    return stateAt(currentHistoryIndex);
 }
 
 GameStateManager GameControlSystem::restartFromBeginning() {
-    if (!stateHistory.empty()) {
+    if (historySize > 0) {
         currentHistoryIndex = 0;
         playbackStatus = PlaybackStatus::PLAYING;
-        return stateHistory[0];
     }
-    return stateHistory[currentHistoryIndex];
+    return stateAt(currentHistoryIndex);
 }
 
-bool GameControlSystem::hasHistory() const { return !stateHistory.empty(); }
+bool GameControlSystem::hasHistory() const { return historySize > 0; }
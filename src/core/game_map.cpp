@@ -1,44 +1,264 @@
 #include "../../include/game_map.h"
-#include <fstream>
-#include <sstream>
+#include "../../include/binary_io.h"
+#include "../../include/bit_ops.h"
+#include "../../include/map_connectivity.h"
+#include "../../include/map_text.h"
+#include "../../include/mapped_file.h"
+#include "../../include/visibility_cache.h"
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <utility>
+
+// 空闲分块池：同一张地图及其副本共用。容量在创建时预留好，回收和取用都不分配内存
+struct GameMap::TilePool {
+    std::mutex mutex;
+    std::vector<MapTile *> freeTiles;
+    size_t limit;      // 最多保留的空闲分块数，超出的直接释放
+    size_t cellBytes;  // 单元格区域的字节数（TILE_ROWS 行，按 8 字节补齐）
+    size_t planeWords; // 每个位平面的字数（TILE_ROWS 行）
+    size_t blockBytes; // 整块大小
+
+    TilePool(size_t maxFree, size_t cells, size_t words)
+        : limit(maxFree), cellBytes((cells + 7) & ~static_cast<size_t>(7)), planeWords(words),
+          blockBytes(headerBytes() + cellBytes + 2 * words * sizeof(uint64_t)) {
+        freeTiles.reserve(limit);
+    }
+    ~TilePool() {
+        for (MapTile *tile : freeTiles) destroy(tile);
+    }
+
+    static size_t headerBytes() { return (sizeof(MapTile) + 7) & ~static_cast<size_t>(7); }
+    static void destroy(MapTile *tile) {
+        tile->~MapTile();
+        ::operator delete(tile);
+    }
+};
+
+GameMap::GameMap() : width(GameConfig::MAP_WIDTH), height(GameConfig::MAP_HEIGHT), wordsPerRow(0), totalDots(0) {
+    initialize();
+}
 
-GameMap::GameMap() : width(GameConfig::MAP_WIDTH), height(GameConfig::MAP_HEIGHT), totalDots(0) { initialize(); }
+GameMap::GameMap(int w, int h) : width(w), height(h), wordsPerRow(0), totalDots(0) { initialize(); }
+
+GameMap &GameMap::operator=(const GameMap &other) {
+    tiles = other.tiles;
+    tilePool = other.tilePool;
+    width = other.width;
+    height = other.height;
+    wordsPerRow = other.wordsPerRow;
+    totalDots = other.totalDots;
+    visibilityCaches = other.visibilityCaches;
+    return *this;
+}
 
-GameMap::GameMap(int w, int h) : width(w), height(h), totalDots(0) { initialize(); }
+GameMap &GameMap::operator=(GameMap &&other) noexcept {
+    tiles = std::move(other.tiles);
+    tilePool = std::move(other.tilePool);
+    width = other.width;
+    height = other.height;
+    wordsPerRow = other.wordsPerRow;
+    totalDots = other.totalDots;
+    visibilityCaches = std::move(other.visibilityCaches);
+    return *this;
+}
 
 void GameMap::initialize() {
-    grid.resize(height);
-    for (int y = 0; y < height; ++y) {
-        grid[y].resize(width, CellType::WALL);
+    // 负的尺寸按 0 处理；宽为 0、高大于 0 的地图仍按行分配（空）分块，保证按行访问始终有效
+    width = std::max(width, 0);
+    height = std::max(height, 0);
+    wordsPerRow = (width + 63) / 64;
+    visibilityCaches.clear();
+    tiles.clear(); // 旧分块先回到旧池，再换新池
+    int tileCount = (height + TILE_ROWS - 1) / TILE_ROWS;
+    tilePool = std::make_shared<TilePool>(static_cast<size_t>(tileCount), static_cast<size_t>(TILE_ROWS) * width,
+                                          static_cast<size_t>(TILE_ROWS) * wordsPerRow);
+    if (height == 0) {
+        return;
+    }
+
+    // 全墙地图：所有完整分块共享同一份存储，第一次写入时才各自复制
+    int fullTiles = height / TILE_ROWS;
+    int lastRows = height % TILE_ROWS;
+    tiles.reserve(tileCount);
+    if (fullTiles > 0) {
+        TileRef wallTile = makeWallTile(TILE_ROWS);
+        tiles.assign(fullTiles, wallTile);
+    }
+    if (lastRows > 0) {
+        tiles.push_back(makeWallTile(lastRows));
     }
 }
 
-void GameMap::clear() {
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            grid[y][x] = CellType::WALL;
+GameMap::MapTile *GameMap::acquireTile(int rows) const {
+    TilePool &pool = *tilePool;
+    MapTile *tile = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        if (!pool.freeTiles.empty()) {
+            tile = pool.freeTiles.back();
+            pool.freeTiles.pop_back();
+        }
+    }
+    if (tile == nullptr) {
+        uint8_t *block = static_cast<uint8_t *>(::operator new(pool.blockBytes));
+        tile = new (block) MapTile();
+        tile->pool = &pool;
+        tile->cells = reinterpret_cast<CellType *>(block + TilePool::headerBytes());
+        tile->wallBits = reinterpret_cast<uint64_t *>(block + TilePool::headerBytes() + pool.cellBytes);
+        tile->dotBits = tile->wallBits + pool.planeWords;
+    }
+    tile->refs.store(1, std::memory_order_relaxed);
+    tile->rows = rows;
+    return tile;
+}
+
+void GameMap::releaseTile(MapTile *tile) {
+    TilePool &pool = *tile->pool;
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        if (pool.freeTiles.size() < pool.limit) {
+            pool.freeTiles.push_back(tile);
+            return;
+        }
+    }
+    TilePool::destroy(tile);
+}
+
+GameMap::TileRef GameMap::makeWallTile(int rows) const {
+    MapTile *tile = acquireTile(rows);
+    std::fill(tile->cells, tile->cells + static_cast<size_t>(rows) * width, CellType::WALL);
+
+    // 每行前 width 位置 1，行尾多余的位保持 0
+    size_t words = static_cast<size_t>(rows) * wordsPerRow;
+    std::fill(tile->wallBits, tile->wallBits + words, ~0ULL);
+    std::fill(tile->dotBits, tile->dotBits + words, 0);
+    if (width % 64 != 0) {
+        uint64_t lastWordMask = BitOps::lowMask(width % 64);
+        for (int row = 0; row < rows; ++row) {
+            tile->wallBits[static_cast<size_t>(row) * wordsPerRow + wordsPerRow - 1] = lastWordMask;
         }
     }
+    return TileRef(tile);
+}
+
+GameMap::MapTile &GameMap::mutableTile(int tileIndex) {
+    TileRef &tile = tiles[tileIndex];
+    if (tile.isShared()) {
+        const MapTile &source = *tile.get();
+        MapTile *copy = acquireTile(source.rows);
+        size_t words = static_cast<size_t>(source.rows) * wordsPerRow;
+        std::memcpy(copy->cells, source.cells, static_cast<size_t>(source.rows) * width);
+        std::memcpy(copy->wallBits, source.wallBits, words * sizeof(uint64_t));
+        std::memcpy(copy->dotBits, source.dotBits, words * sizeof(uint64_t));
+        tile = TileRef(copy);
+    }
+    return *tile.get();
+}
+
+bool GameMap::sharesTile(const GameMap &other, int tileIndex) const {
+    return tileIndex >= 0 && tileIndex < getTileCount() && tileIndex < other.getTileCount() &&
+           tiles[tileIndex].get() == other.tiles[tileIndex].get();
+}
+
+void GameMap::clear() {
+    initialize();
     totalDots = 0;
 }
 
+void GameMap::writeCell(int x, int y, CellType type) {
+    int row = y % TILE_ROWS;
+    if (tiles[y / TILE_ROWS]->cells[static_cast<size_t>(row) * width + x] == type) {
+        return; // 内容不变时不触发写时复制
+    }
+
+    MapTile &tile = mutableTile(y / TILE_ROWS);
+    CellType &cell = tile.cells[static_cast<size_t>(row) * width + x];
+    if (!visibilityCaches.empty() && (cell == CellType::WALL) != (type == CellType::WALL)) {
+        visibilityCaches.clear();
+    }
+    cell = type;
+
+    size_t word = static_cast<size_t>(row) * wordsPerRow + (x >> 6);
+    uint64_t bit = 1ULL << (x & 63);
+    if (type == CellType::WALL) {
+        tile.wallBits[word] |= bit;
+    } else {
+        tile.wallBits[word] &= ~bit;
+    }
+    if (type == CellType::DOT) {
+        tile.dotBits[word] |= bit;
+    } else {
+        tile.dotBits[word] &= ~bit;
+    }
+}
+
 CellType GameMap::getCell(int x, int y) const {
     if (!isInBounds(x, y)) {
         return CellType::WALL;
     }
-    return grid[y][x];
+    return getRow(y)[x];
 }
 
 CellType GameMap::getCell(const Position &pos) const { return getCell(pos.x, pos.y); }
 
 void GameMap::setCell(int x, int y, CellType type) {
     if (isInBounds(x, y)) {
-        grid[y][x] = type;
+        writeCell(x, y, type);
     }
 }
 
 void GameMap::setCell(const Position &pos, CellType type) { setCell(pos.x, pos.y, type); }
 
+void GameMap::setRow(int y, const CellType *rowCells) {
+    if (std::equal(rowCells, rowCells + width, getRow(y))) {
+        return;
+    }
+
+    MapTile &tile = mutableTile(y / TILE_ROWS);
+    size_t rowOffset = static_cast<size_t>(y % TILE_ROWS);
+    std::copy(rowCells, rowCells + width, tile.cells + rowOffset * width);
+
+    uint64_t *wallRow = tile.wallBits + rowOffset * wordsPerRow;
+    uint64_t *dotRow = tile.dotBits + rowOffset * wordsPerRow;
+    bool wallsChanged = false;
+    for (int word = 0; word < wordsPerRow; ++word) {
+        int begin = word * 64;
+        int end = std::min(begin + 64, width);
+        uint64_t walls = 0;
+        uint64_t dots = 0;
+        int x = begin;
+        // 每次处理 8 格（按小端序装入，与主机字节序无关）：单元格取值 0/1/2，墙为 01、豆子为 10，
+        // 按字节取出对应位再收集成掩码
+        for (; x + 8 <= end; x += 8) {
+            uint64_t group = BitOps::loadLittleEndian64(rowCells + x);
+            uint64_t wallBytes = group & ~(group >> 1) & 0x0101010101010101ULL;
+            uint64_t dotBytes = (group >> 1) & 0x0101010101010101ULL;
+            walls |= static_cast<uint64_t>(BitOps::gatherByteBits(wallBytes)) << (x - begin);
+            dots |= static_cast<uint64_t>(BitOps::gatherByteBits(dotBytes)) << (x - begin);
+        }
+        for (; x < end; ++x) {
+            walls |= static_cast<uint64_t>(rowCells[x] == CellType::WALL) << (x - begin);
+            dots |= static_cast<uint64_t>(rowCells[x] == CellType::DOT) << (x - begin);
+        }
+        wallsChanged |= wallRow[word] != walls;
+        wallRow[word] = walls;
+        dotRow[word] = dots;
+    }
+    if (wallsChanged) {
+        visibilityCaches.clear();
+    }
+}
+
+GameMap::RowWriter GameMap::writeRow(int y) {
+    visibilityCaches.clear();
+    MapTile &tile = mutableTile(y / TILE_ROWS);
+    size_t rowOffset = static_cast<size_t>(y % TILE_ROWS);
+    return RowWriter{tile.cells + rowOffset * width, tile.wallBits + rowOffset * wordsPerRow,
+                     tile.dotBits + rowOffset * wordsPerRow};
+}
+
 bool GameMap::isInBounds(int x, int y) const { return x >= 0 && x < width && y >= 0 && y < height; }
 
 bool GameMap::isInBounds(const Position &pos) const { return isInBounds(pos.x, pos.y); }
@@ -49,111 +269,67 @@ bool GameMap::isEmpty(const Position &pos) const { return getCell(pos) == CellTy
 
 bool GameMap::hasDot(const Position &pos) const { return getCell(pos) == CellType::DOT; }
 
+uint64_t GameMap::extractWallBits(int x0, int y, int count) const {
+    uint64_t all = BitOps::lowMask(count);
+    if (y < 0 || y >= height || x0 >= width || x0 + count <= 0) {
+        return all;
+    }
+
+    // 地图内的列区间 [begin, end)
+    int begin = std::max(x0, 0);
+    int end = std::min(x0 + count, width);
+    int inMapCount = end - begin;
+
+    const uint64_t *row = getWallBitsRow(y);
+    int wordIndex = begin >> 6;
+    int shift = begin & 63;
+    uint64_t bits = row[wordIndex] >> shift;
+    if (shift != 0 && wordIndex + 1 < wordsPerRow) {
+        bits |= row[wordIndex + 1] << (64 - shift);
+    }
+
+    uint64_t inMapMask = BitOps::lowMask(inMapCount);
+    int offset = begin - x0;
+    return ((bits & inMapMask) << offset) | (all & ~(inMapMask << offset));
+}
+
 int GameMap::countDots() const {
-    int count = 0;
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            if (grid[y][x] == CellType::DOT) {
-                count++;
-            }
-        }
+    uint64_t dots = 0;
+    for (const auto &tile : tiles) {
+        dots += BitOps::popcount(tile->dotBits, static_cast<size_t>(tile->rows) * wordsPerRow);
     }
-    return count;
+    return static_cast<int>(dots);
 }
 
 int GameMap::countEmptyCells() const {
-    int count = 0;
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            if (grid[y][x] == CellType::EMPTY) {
-                count++;
-            }
-        }
+    // 非墙非豆即为空地
+    uint64_t cellCount = 0;
+    uint64_t walls = 0;
+    uint64_t dots = 0;
+    for (const auto &tile : tiles) {
+        size_t words = static_cast<size_t>(tile->rows) * wordsPerRow;
+        cellCount += static_cast<uint64_t>(tile->rows) * width;
+        walls += BitOps::popcount(tile->wallBits, words);
+        dots += BitOps::popcount(tile->dotBits, words);
     }
-    return count;
+    return static_cast<int>(cellCount - walls - dots);
 }
 
 bool GameMap::loadFromFile(const std::string &filename) {
-    std::ifstream file(filename);
-    if (!file.is_open()) {
+    MappedFile file;
+    if (!file.open(filename)) {
         return false;
     }
-
-    std::stringstream buffer;
-    buffer << file.rdbuf();
-    return loadFromString(buffer.str());
+    return loadFromString(std::string_view(reinterpret_cast<const char *>(file.data()), file.size()));
 }
 
 bool GameMap::saveToFile(const std::string &filename) const {
-    std::ofstream file(filename);
-    if (!file.is_open()) {
-        return false;
-    }
-
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            char c;
-            switch (grid[y][x]) {
-            case CellType::EMPTY:
-                c = ' ';
-                break;
-            case CellType::WALL:
-                c = '#';
-                break;
-            case CellType::DOT:
-                c = '.';
-                break;
-            default:
-                c = '?';
-                break;
-            }
-            file << c;
-        }
-        file << '\n';
-    }
-
-    return true;
-}
-
-bool GameMap::loadFromString(const std::string &mapData) {
-    std::istringstream stream(mapData);
-    std::string line;
-
-    // 读取宽度和高度
-    if (std::getline(stream, line)) {
-        std::istringstream lineStream(line);
-        lineStream >> width >> height;
-        initialize();
-    }
-
-    int y = 0;
-    while (std::getline(stream, line) && y < height) {
-        for (int x = 0; x < width && x < (int)line.length(); ++x) {
-            char c = line[x];
-            CellType type;
-            switch (c) {
-            case ' ':
-                type = CellType::EMPTY;
-                break;
-            case '#':
-                type = CellType::WALL;
-                break;
-            case '.':
-                type = CellType::DOT;
-                break;
-            default:
-                type = CellType::WALL;
-                break;
-            }
-            grid[y][x] = type;
-        }
-        y++;
-    }
-
-    totalDots = countDots();
-    return true;
+    std::string text = saveToString();
+    return writeFileBytes(filename, std::vector<uint8_t>(text.begin(), text.end()));
 }
 
+bool GameMap::loadFromString(std::string_view mapData) { return MapText::parse(mapData, *this); }
+
 bool GameMap::validate() const {
     // 检查地图尺寸
     if (width <= 0 || height <= 0) {
@@ -161,13 +337,21 @@ bool GameMap::validate() const {
     }
 
     // 检查边界是否全是墙
-    for (int x = 0; x < width; ++x) {
-        if (grid[0][x] != CellType::WALL || grid[height - 1][x] != CellType::WALL) {
+    // 首行和末行按字比较：除最后一个字外应全为 1，最后一个字为低 width % 64 位
+    const uint64_t *topRow = getWallBitsRow(0);
+    const uint64_t *bottomRow = getWallBitsRow(height - 1);
+    for (int w = 0; w < wordsPerRow; ++w) {
+        uint64_t expected = (w == wordsPerRow - 1) ? BitOps::lowMask(width - 64 * w) : ~0ULL;
+        if (topRow[w] != expected || bottomRow[w] != expected) {
             return false;
         }
     }
+
+    // 左右两列
+    uint64_t rightBit = 1ULL << ((width - 1) & 63);
     for (int y = 0; y < height; ++y) {
-        if (grid[y][0] != CellType::WALL || grid[y][width - 1] != CellType::WALL) {
+        const uint64_t *row = getWallBitsRow(y);
+        if ((row[0] & 1ULL) == 0 || (row[wordsPerRow - 1] & rightBit) == 0) {
             return false;
         }
     }
@@ -178,44 +362,37 @@ bool GameMap::validate() const {
         return false;
     }
 
-    return true;
+    // 所有豆子都必须位于最大的连通区域内，否则有的豆子永远吃不到
+    MapConnectivity connectivity;
+    connectivity.analyze(*this);
+    return connectivity.countUnreachableDots(connectivity.getLargestComponent()) == 0;
 }
 
-GameMap GameMap::clone() const {
-    GameMap newMap(width, height);
-    newMap.grid = this->grid;
-    newMap.totalDots = this->totalDots;
-    return newMap;
+void GameMap::attachVisibilityCache(std::shared_ptr<const VisibilityCache> cache) {
+    if (!cache || cache->getWidth() != width || cache->getHeight() != height) {
+        return;
+    }
+    for (auto &existing : visibilityCaches) {
+        if (existing->getRadius() == cache->getRadius()) {
+            existing = std::move(cache);
+            return;
+        }
+    }
+    visibilityCaches.push_back(std::move(cache));
 }
 
-std::string GameMap::saveToString() const {
-    std::stringstream ss;
-
-    // 保存宽度和高度
-    ss << width << " " << height << "\n";
-
-    // 保存地图数据
-    for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            char c;
-            switch (grid[y][x]) {
-            case CellType::EMPTY:
-                c = ' ';
-                break;
-            case CellType::WALL:
-                c = '#';
-                break;
-            case CellType::DOT:
-                c = '.';
-                break;
-            default:
-                c = '?';
-                break;
-            }
-            ss << c;
+const VisibilityCache *GameMap::findVisibilityCache(int radius) const {
+    for (const auto &cache : visibilityCaches) {
+        if (cache->getRadius() == radius) {
+            return cache.get();
         }
-        ss << '\n';
     }
+    return nullptr;
+}
 
-    return ss.str();
+GameMap GameMap::clone() const {
+    // 分块按写时复制共享，复制本身只增加引用计数
+    return *this;
 }
+
+std::string GameMap::saveToString() const { return MapText::serialize(*this); }
@@ -1,10 +1,13 @@
 #include "../../include/game_state_manager.h"
 
-GameStateManager::GameStateManager() : pacmanScore(0), monsterScore(0), remainingDots(0), turnCount(1) {}
+GameStateManager::GameStateManager()
+    : pacmanScore(0), monsterScore(0), remainingDots(0), turnCount(1), occupancy(map.getWidth(), map.getHeight()) {}
 
 GameStateManager::GameStateManager(const GameMap &gameMap, const std::vector<Character> &chars)
-    : map(gameMap), characters(chars), pacmanScore(0), monsterScore(0), remainingDots(0), turnCount(1) {
+    : map(gameMap), characters(chars), pacmanScore(0), monsterScore(0), remainingDots(0), turnCount(1),
+      occupancy(map.getWidth(), map.getHeight()) {
     remainingDots = map.countDots();
+    occupancy.update(characters);
 }
 
 void GameStateManager::initializeGame(const GameMap &gameMap, const std::vector<Character> &chars) {
@@ -14,6 +17,8 @@ void GameStateManager::initializeGame(const GameMap &gameMap, const std::vector<
     monsterScore = 0;
     turnCount = 1;
     remainingDots = map.countDots();
+    occupancy.reset(map.getWidth(), map.getHeight());
+    occupancy.update(characters);
 }
 
 const Character &GameStateManager::getCharacter(int index) const {
@@ -47,6 +52,7 @@ std::vector<Character> GameStateManager::getMonsters() const {
 void GameStateManager::updateCharacterPosition(int index, const Position &newPos) {
     if (index >= 0 && index < (int)characters.size()) {
         characters[index].position = newPos;
+        occupancy.moveCharacter(index, newPos);
     }
 }
 
@@ -118,9 +124,16 @@ void GameStateManager::restoreState(const GameState &state) {
     monsterScore = state.monsterScore;
     remainingDots = state.remainingDots;
     turnCount = state.turnCount;
+    occupancy.reset(map.getWidth(), map.getHeight());
+    occupancy.update(characters);
 }
 
-void GameStateManager::setCharacters(const std::vector<Character> &chars) { characters = chars; }
+void GameStateManager::setCharacters(const std::vector<Character> &chars) {
+    characters = chars;
+    occupancy.update(characters);
+}
+
+int GameStateManager::findCharacterAt(const Position &pos) const { return occupancy.findAlive(pos, characters); }
 
 void GameStateManager::setPacmanScore(int newScore) { pacmanScore = newScore; }
 
@@ -0,0 +1,175 @@
+#include "../../include/map_batch_generator.h"
+#include "../../include/map_pack.h"
+#include "../../include/match_runner.h"
+#include "../../include/random_map_generator.h"
+#include "../../include/thread_pool.h"
+#include "../../include/trace_recorder.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+MapRejection checkMapQuality(const GameMap &map, int monsterCount, unsigned int spawnSeed,
+                             MapConnectivity &connectivity) {
+    std::vector<Character> characters = createMatchCharacters(map, monsterCount, spawnSeed);
+    if (characters.empty()) {
+        return MapRejection::NO_SPAWN;
+    }
+
+    connectivity.analyze(map);
+    int component = connectivity.componentAt(characters[0].position);
+    for (const auto &character : characters) {
+        if (connectivity.componentAt(character.position) != component) {
+            return MapRejection::UNREACHABLE_SPAWN;
+        }
+    }
+    return connectivity.countUnreachableDots(component) == 0 ? MapRejection::NONE : MapRejection::UNREACHABLE_DOTS;
+}
+
+uint64_t hashMapContent(const GameMap &map) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    auto mix = [&hash](uint64_t value) {
+        hash ^= value;
+        hash *= 0x100000001B3ULL;
+        hash ^= hash >> 29;
+    };
+    mix(static_cast<uint64_t>(map.getWidth()) << 32 | static_cast<uint32_t>(map.getHeight()));
+    for (int y = 0; y < map.getHeight(); ++y) {
+        const uint64_t *walls = map.getWallBitsRow(y);
+        const uint64_t *dots = map.getDotBitsRow(y);
+        for (int w = 0; w < map.getWordsPerRow(); ++w) {
+            mix(walls[w]);
+            mix(dots[w]);
+        }
+    }
+    return hash;
+}
+
+bool sameMapContent(const GameMap &a, const GameMap &b) {
+    if (a.getWidth() != b.getWidth() || a.getHeight() != b.getHeight()) {
+        return false;
+    }
+    for (int y = 0; y < a.getHeight(); ++y) {
+        if (std::memcmp(a.getRow(y), b.getRow(y), static_cast<size_t>(a.getWidth())) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+namespace {
+
+constexpr long long SEEDS_PER_CHUNK = 64;
+constexpr int CHUNKS_PER_THREAD = 4; // 每批的块数 = 线程数 * CHUNKS_PER_THREAD
+// 一批中所有地图的格子总数上限（每格约 1.25 字节，约 80 MB）：大地图时缩小每块的种子数，
+// 但每个工作线程至少一张，否则线程池无法跑满
+constexpr long long MAX_BATCH_CELLS = 64LL << 20;
+
+struct GeneratedMap {
+    MapRejection rejection;
+    uint64_t contentHash;
+    std::unique_ptr<GameMap> map; // 只保留通过检查的地图
+};
+
+// 工作线程私有的生成器，按缓存行对齐避免伪共享
+struct alignas(64) WorkerGenerator {
+    std::unique_ptr<RandomMapGenerator> generator;
+    MapConnectivity connectivity;
+};
+
+} // namespace
+
+MapBatchStats MapBatchGenerator::run(const Sink &sink) {
+    MapBatchStats stats;
+    ThreadPool pool(config.threadCount);
+    int threadCount = pool.getThreadCount();
+    stats.threadCount = threadCount;
+
+    std::vector<WorkerGenerator> workers(threadCount);
+    for (auto &worker : workers) {
+        worker.generator = std::make_unique<RandomMapGenerator>(config.width, config.height, GameConfig::DOT_RATIO);
+    }
+
+    // 指纹 -> 第一张具有该指纹的地图的种子下标；指纹碰撞时同一指纹下有多张不同的地图
+    std::unordered_multimap<uint64_t, long long> seenHashes;
+    RandomMapGenerator representativeGenerator(config.width, config.height, GameConfig::DOT_RATIO);
+    auto isDuplicate = [&](uint64_t contentHash, const GameMap &map) {
+        auto range = seenHashes.equal_range(contentHash);
+        for (auto it = range.first; it != range.second; ++it) {
+            uint64_t matchSeed = config.baseSeed + static_cast<uint64_t>(it->second);
+            representativeGenerator.setSeed(deriveMatchSeeds(matchSeed, 1 + config.monsterCount).mapSeed);
+            if (sameMapContent(representativeGenerator.generateMap(), map)) {
+                return true;
+            }
+        }
+        return false;
+    };
+    long long mapCells = std::max(1LL, static_cast<long long>(config.width) * config.height);
+    long long chunkSeeds = MAX_BATCH_CELLS / (mapCells * CHUNKS_PER_THREAD * threadCount);
+    chunkSeeds = std::max(1LL, std::min(SEEDS_PER_CHUNK, chunkSeeds));
+    long long batchSeeds = chunkSeeds * CHUNKS_PER_THREAD * threadCount;
+    std::vector<GeneratedMap> results(static_cast<size_t>(std::min(batchSeeds, std::max(config.seedCount, 0LL))));
+    auto startTime = std::chrono::steady_clock::now();
+
+    for (long long batchBegin = 0; batchBegin < config.seedCount; batchBegin += batchSeeds) {
+        long long batchEnd = std::min(config.seedCount, batchBegin + batchSeeds);
+
+        for (long long chunkBegin = batchBegin; chunkBegin < batchEnd; chunkBegin += chunkSeeds) {
+            long long chunkEnd = std::min(batchEnd, chunkBegin + chunkSeeds);
+            pool.submit([this, &workers, &results, batchBegin, chunkBegin, chunkEnd] {
+                WorkerGenerator &worker = workers[ThreadPool::currentWorkerIndex()];
+                for (long long i = chunkBegin; i < chunkEnd; ++i) {
+                    uint64_t matchSeed = config.baseSeed + static_cast<uint64_t>(i);
+                    MatchSeeds seeds = deriveMatchSeeds(matchSeed, 1 + config.monsterCount);
+                    worker.generator->setSeed(seeds.mapSeed);
+                    TraceSpan generateSpan("generateMap", "mapgen", "seed_index", i);
+                    auto map = std::make_unique<GameMap>(worker.generator->generateMap());
+                    generateSpan.end();
+
+                    TraceSpan checkSpan("checkMap", "mapgen", "seed_index", i);
+                    GeneratedMap &result = results[static_cast<size_t>(i - batchBegin)];
+                    result.rejection = checkMapQuality(*map, config.monsterCount, seeds.spawnSeed, worker.connectivity);
+                    result.contentHash = hashMapContent(*map);
+                    result.map = result.rejection == MapRejection::NONE ? std::move(map) : nullptr;
+                }
+            });
+        }
+        pool.waitIdle();
+
+        // 按种子顺序汇总：去重时保留种子最小的一张
+        TraceSpan aggregateSpan("aggregate", "mapgen", "batch_begin", batchBegin);
+        for (long long i = batchBegin; i < batchEnd; ++i) {
+            GeneratedMap &result = results[static_cast<size_t>(i - batchBegin)];
+            stats.generated++;
+            if (result.rejection == MapRejection::NO_SPAWN) {
+                stats.noSpawn++;
+            } else if (result.rejection == MapRejection::UNREACHABLE_DOTS) {
+                stats.unreachableDots++;
+            } else if (result.rejection == MapRejection::UNREACHABLE_SPAWN) {
+                stats.unreachableSpawns++;
+            } else if (config.deduplicate && isDuplicate(result.contentHash, *result.map)) {
+                stats.duplicates++;
+            } else {
+                if (config.deduplicate) seenHashes.emplace(result.contentHash, i);
+                stats.accepted++;
+                if (sink) sink(config.baseSeed + static_cast<uint64_t>(i), *result.map);
+            }
+            result.map.reset();
+        }
+    }
+
+    stats.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    return stats;
+}
+
+bool MapBatchGenerator::writePack(const std::string &filename, MapBatchStats &stats) {
+    MapPackWriter writer;
+    if (!writer.open(filename)) {
+        return false;
+    }
+    bool ok = true;
+    stats = run([&writer, &ok](uint64_t seed, const GameMap &map) { ok = writer.add(seed, map) && ok; });
+    return writer.finish() && ok;
+}
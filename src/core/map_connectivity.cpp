@@ -0,0 +1,173 @@
+#include "../../include/map_connectivity.h"
+#include "../../include/bit_ops.h"
+#include <algorithm>
+
+namespace {
+
+// words 中 [begin, end) 位的置位数，begin < end
+int countBitsInRange(const uint64_t *words, int begin, int end) {
+    int firstWord = begin >> 6;
+    int lastWord = (end - 1) >> 6;
+    uint64_t firstMask = ~BitOps::lowMask(begin & 63);
+    if (firstWord == lastWord) {
+        return BitOps::popcount64(words[firstWord] & firstMask & BitOps::lowMask(end - 64 * lastWord));
+    }
+    int count = BitOps::popcount64(words[firstWord] & firstMask);
+    for (int w = firstWord + 1; w < lastWord; ++w) {
+        count += BitOps::popcount64(words[w]);
+    }
+    return count + BitOps::popcount64(words[lastWord] & BitOps::lowMask(end - 64 * lastWord));
+}
+
+} // namespace
+
+MapConnectivity::MapConnectivity() : width(0), height(0), totalDots(0), largestComponent(-1) {}
+
+int MapConnectivity::findRoot(int run) {
+    // 路径减半
+    while (labels[run] != run) {
+        labels[run] = labels[labels[run]];
+        run = labels[run];
+    }
+    return run;
+}
+
+void MapConnectivity::unite(int a, int b) {
+    a = findRoot(a);
+    b = findRoot(b);
+    // 总是把下标大的根挂到下标小的根下，根始终是集合中最早扫描到的行段，保证 labels[i] <= i
+    if (a < b) {
+        labels[b] = a;
+    } else if (b < a) {
+        labels[a] = b;
+    }
+}
+
+void MapConnectivity::analyze(const GameMap &map) {
+    width = map.getWidth();
+    height = map.getHeight();
+    totalDots = 0;
+    largestComponent = -1;
+    runs.clear();
+    labels.clear();
+    components.clear();
+    rowStart.assign(static_cast<size_t>(std::max(height, 0)) + 1, 0);
+    if (width <= 0 || height <= 0) {
+        return;
+    }
+
+    int wordsPerRow = map.getWordsPerRow();
+    uint64_t lastWordMask = BitOps::lowMask(width - 64 * (wordsPerRow - 1));
+    size_t previousBegin = 0;
+    for (int y = 0; y < height; ++y) {
+        size_t rowBegin = runs.size();
+        rowStart[y] = rowBegin;
+
+        // 行段的起点是左边为墙的非墙格，终点是右边为墙的非墙格；跨字时带上相邻字的边界位
+        const uint64_t *walls = map.getWallBitsRow(y);
+        size_t endCursor = rowBegin;
+        uint64_t open = ~walls[0] & (wordsPerRow == 1 ? lastWordMask : ~0ULL);
+        uint64_t carry = 0;
+        for (int w = 0; w < wordsPerRow; ++w) {
+            uint64_t nextOpen = 0;
+            if (w + 1 < wordsPerRow) {
+                nextOpen = ~walls[w + 1] & (w + 2 == wordsPerRow ? lastWordMask : ~0ULL);
+            }
+            uint64_t starts = open & ~((open << 1) | carry);
+            uint64_t ends = open & ~((open >> 1) | (nextOpen << 63));
+            while (starts != 0) {
+                Run run;
+                run.begin = 64 * w + BitOps::lowestSetBit(starts);
+                run.end = 0;
+                runs.push_back(run);
+                starts &= starts - 1;
+            }
+            // 本字内结束的行段都已在本字或之前的字中登记了起点
+            while (ends != 0) {
+                runs[endCursor++].end = 64 * w + BitOps::lowestSetBit(ends) + 1;
+                ends &= ends - 1;
+            }
+            carry = open >> 63;
+            open = nextOpen;
+        }
+
+        for (size_t i = rowBegin; i < runs.size(); ++i) {
+            labels.push_back(static_cast<int>(i));
+        }
+
+        // 与上一行列区间重叠的行段上下相邻，两个有序序列归并一遍即可找出全部重叠对
+        size_t above = previousBegin;
+        size_t below = rowBegin;
+        while (above < rowBegin && below < runs.size()) {
+            const Run &upper = runs[above];
+            const Run &lower = runs[below];
+            if (upper.end <= lower.begin) {
+                ++above;
+            } else if (lower.end <= upper.begin) {
+                ++below;
+            } else {
+                // 下方行段第一次与上一行相连时它还是单独的根，直接挂到上方的根下，省去一次查找
+                if (labels[below] == static_cast<int>(below)) {
+                    labels[below] = findRoot(static_cast<int>(above));
+                } else {
+                    unite(static_cast<int>(above), static_cast<int>(below));
+                }
+                if (upper.end < lower.end) {
+                    ++above;
+                } else {
+                    ++below;
+                }
+            }
+        }
+        previousBegin = rowBegin;
+    }
+    rowStart[height] = runs.size();
+
+    // 按扫描顺序给根编号；labels[i] <= i，所以父节点总是先于自己被改写为区域编号
+    for (int y = 0; y < height; ++y) {
+        const uint64_t *dots = map.getDotBitsRow(y);
+        for (size_t i = rowStart[y]; i < rowStart[y + 1]; ++i) {
+            int parent = labels[i];
+            if (parent == static_cast<int>(i)) {
+                labels[i] = static_cast<int>(components.size());
+                components.push_back(Component{0, 0});
+            } else {
+                labels[i] = labels[parent];
+            }
+            Component &component = components[labels[i]];
+            int dotCount = countBitsInRange(dots, runs[i].begin, runs[i].end);
+            component.cells += runs[i].end - runs[i].begin;
+            component.dots += dotCount;
+            totalDots += dotCount;
+        }
+    }
+
+    for (int id = 0; id < static_cast<int>(components.size()); ++id) {
+        if (largestComponent < 0 || components[id].cells > components[largestComponent].cells) {
+            largestComponent = id;
+        }
+    }
+}
+
+int MapConnectivity::componentAt(int x, int y) const {
+    if (x < 0 || x >= width || y < 0 || y >= height) {
+        return -1;
+    }
+    // 行内按起点二分，找到最后一个起点不超过 x 的行段
+    auto first = runs.begin() + static_cast<std::ptrdiff_t>(rowStart[y]);
+    auto last = runs.begin() + static_cast<std::ptrdiff_t>(rowStart[y + 1]);
+    auto it = std::upper_bound(first, last, x, [](int column, const Run &run) { return column < run.begin; });
+    if (it == first) {
+        return -1;
+    }
+    --it;
+    return x < it->end ? labels[static_cast<size_t>(it - runs.begin())] : -1;
+}
+
+int MapConnectivity::countDotComponents() const {
+    int count = 0;
+    for (const auto &component : components) {
+        count += component.dots > 0 ? 1 : 0;
+    }
+    return count;
+}
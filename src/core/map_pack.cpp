@@ -0,0 +1,266 @@
+#include "../../include/map_pack.h"
+#include "../../include/binary_io.h"
+#include "../../include/state_codec.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace {
+
+// 索引项中各字段的偏移
+constexpr size_t FIELD_SEED = 0;
+constexpr size_t FIELD_OFFSET = 8;
+constexpr size_t FIELD_WIDTH = 16;
+constexpr size_t FIELD_HEIGHT = 20;
+constexpr size_t FIELD_TOTAL_DOTS = 24;
+constexpr size_t FIELD_CRC = 28;
+
+size_t alignTo8(size_t value) { return (value + 7) & ~static_cast<size_t>(7); }
+
+size_t wordsPerRowFor(int width) { return static_cast<size_t>(width + 63) / 64; }
+
+size_t recordBytesFor(int width, int height) {
+    size_t planeBytes = static_cast<size_t>(height) * wordsPerRowFor(width) * sizeof(uint64_t);
+    return alignTo8(static_cast<size_t>(width) * height) + 2 * planeBytes;
+}
+
+// 零拷贝视图直接把文件中的小端 u64 当作位平面使用，只能在小端主机上打开
+bool hostIsLittleEndian() {
+    uint32_t probe = 1;
+    uint8_t firstByte;
+    std::memcpy(&firstByte, &probe, 1);
+    return firstByte == 1;
+}
+
+uint64_t loadU64(const uint8_t *data) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) value |= static_cast<uint64_t>(data[i]) << (8 * i);
+    return value;
+}
+
+uint32_t loadU32(const uint8_t *data) {
+    return static_cast<uint32_t>(data[0]) | static_cast<uint32_t>(data[1]) << 8 |
+           static_cast<uint32_t>(data[2]) << 16 | static_cast<uint32_t>(data[3]) << 24;
+}
+
+void storeU64(uint8_t *data, uint64_t value) {
+    for (int i = 0; i < 8; ++i) data[i] = static_cast<uint8_t>(value >> (8 * i));
+}
+
+} // namespace
+
+bool MapView::toGameMap(GameMap &map) const {
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(cells);
+    size_t cellCount = static_cast<size_t>(width) * height;
+    for (size_t i = 0; i < cellCount; ++i) {
+        if (bytes[i] > static_cast<uint8_t>(CellType::DOT)) return false;
+    }
+
+    GameMap result(width, height);
+    for (int y = 0; y < height; ++y) {
+        result.setRow(y, getRow(y));
+    }
+    result.setTotalDots(result.countDots());
+    map = std::move(result);
+    return true;
+}
+
+bool MapPackWriter::open(const std::string &filename) {
+    entries.clear();
+    seeds.clear();
+    failed = false;
+    file.open(filename, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    // 头部先占位，finish() 时回填
+    char header[MapPackFormat::HEADER_BYTES] = {};
+    file.write(header, sizeof(header));
+    position = MapPackFormat::HEADER_BYTES;
+    return static_cast<bool>(file);
+}
+
+bool MapPackWriter::add(uint64_t seed, const GameMap &map) {
+    if (!file.is_open() || failed) {
+        return false;
+    }
+    if (seeds.count(seed) != 0) {
+        return false;
+    }
+
+    int width = map.getWidth();
+    int height = map.getHeight();
+    if (width == 0 || height == 0 || width > StateCodec::MAX_MAP_DIMENSION ||
+        height > StateCodec::MAX_MAP_DIMENSION) {
+        return false;
+    }
+    size_t cellBytes = static_cast<size_t>(width) * height;
+    size_t wordsPerRow = wordsPerRowFor(width);
+    record.assign(recordBytesFor(width, height), 0);
+
+    uint8_t *out = record.data();
+    for (int y = 0; y < height; ++y) {
+        std::memcpy(out + static_cast<size_t>(y) * width, map.getRow(y), width);
+    }
+    out += alignTo8(cellBytes);
+    for (int y = 0; y < height; ++y) {
+        const uint64_t *row = map.getWallBitsRow(y);
+        for (size_t w = 0; w < wordsPerRow; ++w, out += 8) storeU64(out, row[w]);
+    }
+    for (int y = 0; y < height; ++y) {
+        const uint64_t *row = map.getDotBitsRow(y);
+        for (size_t w = 0; w < wordsPerRow; ++w, out += 8) storeU64(out, row[w]);
+    }
+
+    Entry entry;
+    entry.seed = seed;
+    entry.offset = position;
+    entry.width = static_cast<uint32_t>(width);
+    entry.height = static_cast<uint32_t>(height);
+    entry.totalDots = static_cast<uint32_t>(map.getTotalDots());
+    entry.crc = crc32(record.data(), record.size());
+
+    file.write(reinterpret_cast<const char *>(record.data()), static_cast<std::streamsize>(record.size()));
+    if (!file) {
+        failed = true;
+        return false;
+    }
+    position += record.size();
+    entries.push_back(entry);
+    seeds.insert(seed);
+    return true;
+}
+
+bool MapPackWriter::finish() {
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry &a, const Entry &b) { return a.seed < b.seed; });
+    ByteWriter index;
+    for (const auto &entry : entries) {
+        index.writeU64(entry.seed);
+        index.writeU64(entry.offset);
+        index.writeU32(entry.width);
+        index.writeU32(entry.height);
+        index.writeU32(entry.totalDots);
+        index.writeU32(entry.crc);
+    }
+    file.write(reinterpret_cast<const char *>(index.data().data()), static_cast<std::streamsize>(index.size()));
+
+    ByteWriter header;
+    header.writeU32(MapPackFormat::MAGIC);
+    header.writeU16(MapPackFormat::VERSION);
+    header.writeU16(0);
+    header.writeU32(static_cast<uint32_t>(entries.size()));
+    header.writeU32(crc32(index.data().data(), index.size()));
+    header.writeU64(position);
+    header.writeU32(0);
+    header.writeU32(crc32(header.data().data(), header.size()));
+    file.seekp(0);
+    file.write(reinterpret_cast<const char *>(header.data().data()), static_cast<std::streamsize>(header.size()));
+
+    bool ok = !failed && static_cast<bool>(file);
+    file.close();
+    return ok;
+}
+
+bool MapPack::open(const std::string &filename) {
+    close();
+    // 查找和读取按索引跳着访问记录，顺序预读只会读入用不到的地图
+    if (!hostIsLittleEndian() || !file.open(filename, MappedFile::Access::RANDOM)) {
+        return false;
+    }
+
+    const uint8_t *data = file.data();
+    size_t size = file.size();
+    ByteReader reader(data, size);
+    uint32_t magic = reader.readU32();
+    uint16_t version = reader.readU16();
+    reader.readU16();
+    uint32_t count = reader.readU32();
+    uint32_t indexCrc = reader.readU32();
+    uint64_t indexOffset = reader.readU64();
+    reader.readU32();
+    uint32_t headerCrc = reader.readU32();
+    if (!reader.ok() || magic != MapPackFormat::MAGIC || version != MapPackFormat::VERSION ||
+        headerCrc != crc32(data, MapPackFormat::HEADER_BYTES - 4) || indexOffset < MapPackFormat::HEADER_BYTES ||
+        indexOffset > size || count > (size - indexOffset) / MapPackFormat::INDEX_ENTRY_BYTES ||
+        indexCrc != crc32(data + indexOffset, count * MapPackFormat::INDEX_ENTRY_BYTES)) {
+        close();
+        return false;
+    }
+
+    indexData = data + indexOffset;
+    mapCount = static_cast<int>(count);
+
+    // 索引项必须按种子严格递增，记录必须对齐并完整落在头部和索引之间
+    for (int i = 0; i < mapCount; ++i) {
+        uint64_t offset = readIndexU64(i, FIELD_OFFSET);
+        uint32_t width = readIndexU32(i, FIELD_WIDTH);
+        uint32_t height = readIndexU32(i, FIELD_HEIGHT);
+        bool valid = width <= StateCodec::MAX_MAP_DIMENSION && height <= StateCodec::MAX_MAP_DIMENSION &&
+                     offset % 8 == 0 && offset >= MapPackFormat::HEADER_BYTES && offset <= indexOffset &&
+                     recordBytes(i) <= indexOffset - offset && (i == 0 || seedAt(i - 1) < seedAt(i));
+        if (!valid) {
+            close();
+            return false;
+        }
+    }
+    return true;
+}
+
+void MapPack::close() {
+    file.close();
+    indexData = nullptr;
+    mapCount = 0;
+}
+
+uint64_t MapPack::readIndexU64(int index, size_t field) const {
+    return loadU64(indexData + static_cast<size_t>(index) * MapPackFormat::INDEX_ENTRY_BYTES + field);
+}
+
+uint32_t MapPack::readIndexU32(int index, size_t field) const {
+    return loadU32(indexData + static_cast<size_t>(index) * MapPackFormat::INDEX_ENTRY_BYTES + field);
+}
+
+size_t MapPack::recordBytes(int index) const {
+    return recordBytesFor(static_cast<int>(readIndexU32(index, FIELD_WIDTH)),
+                          static_cast<int>(readIndexU32(index, FIELD_HEIGHT)));
+}
+
+int MapPack::find(uint64_t seed) const {
+    int low = 0;
+    int high = mapCount;
+    while (low < high) {
+        int mid = low + (high - low) / 2;
+        if (seedAt(mid) < seed) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return (low < mapCount && seedAt(low) == seed) ? low : -1;
+}
+
+MapView MapPack::view(int index) const {
+    MapView view;
+    view.width = static_cast<int>(readIndexU32(index, FIELD_WIDTH));
+    view.height = static_cast<int>(readIndexU32(index, FIELD_HEIGHT));
+    view.wordsPerRow = static_cast<int>(wordsPerRowFor(view.width));
+    view.totalDots = static_cast<int>(readIndexU32(index, FIELD_TOTAL_DOTS));
+
+    const uint8_t *record = file.data() + readIndexU64(index, FIELD_OFFSET);
+    size_t planeWords = static_cast<size_t>(view.height) * view.wordsPerRow;
+    view.cells = reinterpret_cast<const CellType *>(record);
+    size_t cellBytes = alignTo8(static_cast<size_t>(view.width) * view.height);
+    view.wallBits = reinterpret_cast<const uint64_t *>(record + cellBytes);
+    view.dotBits = view.wallBits + planeWords;
+    return view;
+}
+
+bool MapPack::verify(int index) const {
+    const uint8_t *record = file.data() + readIndexU64(index, FIELD_OFFSET);
+    return crc32(record, recordBytes(index)) == readIndexU32(index, FIELD_CRC);
+}
@@ -0,0 +1,207 @@
+#include "../../include/map_text.h"
+#include "../../include/game_map.h"
+#include "../../include/state_codec.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace MapText {
+
+namespace {
+
+constexpr uint8_t INVALID_CELL = 0xFF;
+
+// 字符到单元格类型的分类表，非法字符为 INVALID_CELL
+struct CharTable {
+    uint8_t cell[256];
+
+    CharTable() {
+        for (int c = 0; c < 256; ++c) {
+            cell[c] = INVALID_CELL;
+        }
+        cell[static_cast<uint8_t>(' ')] = static_cast<uint8_t>(CellType::EMPTY);
+        cell[static_cast<uint8_t>('#')] = static_cast<uint8_t>(CellType::WALL);
+        cell[static_cast<uint8_t>('.')] = static_cast<uint8_t>(CellType::DOT);
+    }
+};
+
+const CharTable &charTable() {
+    static const CharTable table;
+    return table;
+}
+
+constexpr uint64_t HIGH_BITS = 0x8080808080808080ULL;
+constexpr uint64_t LOW_SEVEN_BITS = 0x7F7F7F7F7F7F7F7FULL;
+
+// 8 个字符一组（SWAR）：等于 c 的字节在结果中最高位为 1，其余为 0，逐字节精确、无跨字节进位
+inline uint64_t matchBytes(uint64_t group, char c) {
+    uint64_t diff = group ^ (0x0101010101010101ULL * static_cast<uint8_t>(c));
+    return ~(((diff & LOW_SEVEN_BITS) + LOW_SEVEN_BITS) | diff) & HIGH_BITS;
+}
+
+constexpr char CELL_CHARS[4] = {' ', '#', '.', '?'};
+
+bool fail(ParseError *error, int line, int column, const char *message) {
+    if (error != nullptr) {
+        error->line = line;
+        error->column = column;
+        error->message = message;
+    }
+    return false;
+}
+
+bool isBlank(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; }
+
+// 读取首行中的一个尺寸，position 指向第一个数字，成功后指向数字之后
+bool parseDimension(std::string_view text, size_t &position, int &value, bool isWidth, ParseError *error) {
+    size_t start = position;
+    long long result = 0;
+    while (position < text.size() && text[position] >= '0' && text[position] <= '9') {
+        result = result * 10 + (text[position] - '0');
+        if (result > StateCodec::MAX_MAP_DIMENSION) {
+            return fail(error, 1, static_cast<int>(start) + 1,
+                        isWidth ? "map width is too large" : "map height is too large");
+        }
+        ++position;
+    }
+    if (position == start) {
+        return fail(error, 1, static_cast<int>(start) + 1, isWidth ? "expected map width" : "expected map height");
+    }
+    value = static_cast<int>(result);
+    return true;
+}
+
+} // namespace
+
+bool parse(std::string_view text, GameMap &map, ParseError *error) {
+    // 首行：宽 高
+    size_t position = 0;
+    int width = 0;
+    int height = 0;
+    while (position < text.size() && (text[position] == ' ' || text[position] == '\t')) ++position;
+    if (!parseDimension(text, position, width, true, error)) {
+        return false;
+    }
+    while (position < text.size() && (text[position] == ' ' || text[position] == '\t')) ++position;
+    if (!parseDimension(text, position, height, false, error)) {
+        return false;
+    }
+    while (position < text.size() && (text[position] == ' ' || text[position] == '\t' || text[position] == '\r')) {
+        ++position;
+    }
+    if (position < text.size() && text[position] != '\n') {
+        return fail(error, 1, static_cast<int>(position) + 1, "unexpected character after map size");
+    }
+    if (height > 0 && position >= text.size()) {
+        return fail(error, 2, 1, "missing map rows");
+    }
+    ++position;
+
+    const uint8_t *table = charTable().cell;
+    GameMap result(width, height);
+    std::vector<CellType> row(static_cast<size_t>(width));
+    for (int y = 0; y < height; ++y) {
+        int line = y + 2;
+        if (position >= text.size()) {
+            return fail(error, line, 1, "missing map row");
+        }
+
+        // 本行长度：到 '\n' 为止，去掉可选的 '\r'
+        std::string_view rest = text.substr(position);
+        size_t lineLength = rest.find('\n');
+        size_t nextLine = lineLength == std::string_view::npos ? text.size() : position + lineLength + 1;
+        if (lineLength == std::string_view::npos) lineLength = rest.size();
+        if (lineLength > 0 && rest[lineLength - 1] == '\r') --lineLength;
+        if (lineLength != static_cast<size_t>(width)) {
+            int column = static_cast<int>(std::min(lineLength, static_cast<size_t>(width))) + 1;
+            return fail(error, line, column,
+                        lineLength < static_cast<size_t>(width) ? "row is shorter than map width"
+                                                                : "row is longer than map width");
+        }
+
+        // 整行先按 8 字节一组比较分类，不足 8 个的尾部查表；只累积非法标志，出错时再回头查表定位列号
+        const uint8_t *bytes = reinterpret_cast<const uint8_t *>(rest.data());
+        uint8_t *cells = reinterpret_cast<uint8_t *>(row.data());
+        uint64_t invalidBytes = 0;
+        int x = 0;
+        for (; x + 8 <= width; x += 8) {
+            uint64_t group;
+            std::memcpy(&group, bytes + x, sizeof(group));
+            uint64_t walls = matchBytes(group, '#');
+            uint64_t dots = matchBytes(group, '.');
+            invalidBytes |= ~(walls | dots | matchBytes(group, ' ')) & HIGH_BITS;
+            uint64_t packed = (walls >> 7) | (dots >> 6);
+            std::memcpy(cells + x, &packed, sizeof(packed));
+        }
+        uint8_t invalid = invalidBytes != 0 ? INVALID_CELL : 0;
+        for (; x < width; ++x) {
+            uint8_t cell = table[bytes[x]];
+            invalid |= cell;
+            cells[x] = cell;
+        }
+        if (invalid == INVALID_CELL) {
+            for (int x = 0; x < width; ++x) {
+                if (table[bytes[x]] == INVALID_CELL) {
+                    return fail(error, line, x + 1, "invalid map character");
+                }
+            }
+        }
+        if (width > 0) {
+            result.setRow(y, row.data()); // 宽为 0 时每行都是空行，没有单元格可写
+        }
+        position = nextLine;
+    }
+
+    // 地图之后只允许空白
+    for (size_t i = position; i < text.size(); ++i) {
+        if (!isBlank(text[i])) {
+            int line = height + 2;
+            size_t lineStart = position;
+            for (size_t j = position; j < i; ++j) {
+                if (text[j] == '\n') {
+                    ++line;
+                    lineStart = j + 1;
+                }
+            }
+            return fail(error, line, static_cast<int>(i - lineStart) + 1, "unexpected data after map rows");
+        }
+    }
+
+    result.setTotalDots(result.countDots());
+    map = std::move(result);
+    return true;
+}
+
+void serialize(const GameMap &map, std::string &out) {
+    int width = map.getWidth();
+    int height = map.getHeight();
+    out = std::to_string(width);
+    out += ' ';
+    out += std::to_string(height);
+    out += '\n';
+
+    // 一次分配到最终大小，再按行直接写入
+    size_t headerSize = out.size();
+    out.resize(headerSize + static_cast<size_t>(height) * (width + 1));
+    char *dest = &out[0] + headerSize;
+    for (int y = 0; y < height; ++y) {
+        const CellType *row = map.getRow(y);
+        for (int x = 0; x < width; ++x) {
+            dest[x] = CELL_CHARS[static_cast<uint8_t>(row[x]) & 3];
+        }
+        dest[width] = '\n';
+        dest += width + 1;
+    }
+}
+
+std::string serialize(const GameMap &map) {
+    std::string out;
+    serialize(map, out);
+    return out;
+}
+
+std::string formatError(const ParseError &error) {
+    return "line " + std::to_string(error.line) + ", column " + std::to_string(error.column) + ": " + error.message;
+}
+
+} // namespace MapText
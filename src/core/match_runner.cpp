@@ -0,0 +1,214 @@
+#include "../../include/match_runner.h"
+#include "../../include/management_system.h"
+#include "../../include/map_pack.h"
+#include "../../include/monster_ai.h"
+#include "../../include/pacman_ai.h"
+#include "../../include/random_map_generator.h"
+#include "../../include/trace_recorder.h"
+#include "../../include/visibility_system.h"
+#include <random>
+
+AgentFactory defaultPacmanFactory() {
+    return [](unsigned int seed) -> std::unique_ptr<AIInterface> { return std::make_unique<PacmanAI>(seed); };
+}
+
+AgentFactory defaultMonsterFactory() {
+    return [](unsigned int seed) -> std::unique_ptr<AIInterface> { return std::make_unique<MonsterAI>(seed); };
+}
+
+std::vector<Character> createMatchCharacters(const GameMap &map, int monsterCount, unsigned int spawnSeed) {
+    std::vector<Character> characters;
+
+    // 查找空地位置来放置角色
+    std::vector<Position> validPositions;
+    for (int y = 1; y < map.getHeight() - 1; ++y) {
+        for (int x = 1; x < map.getWidth() - 1; ++x) {
+            Position pos(x, y);
+            if (map.isEmpty(pos)) {
+                validPositions.push_back(pos);
+            }
+        }
+    }
+
+    // 检查是否有足够的位置（1个吃豆人 + N个怪物）
+    int totalCharacters = 1 + monsterCount;
+    if (validPositions.size() < static_cast<size_t>(totalCharacters)) {
+        return characters;
+    }
+
+    // 随机选择位置
+    // 手写 Fisher-Yates 洗牌：std::shuffle 的结果依赖标准库实现，无法跨平台复现
+    std::mt19937 randomEngine(spawnSeed);
+    for (size_t i = validPositions.size() - 1; i > 0; --i) {
+        size_t j = randomEngine() % (i + 1);
+        std::swap(validPositions[i], validPositions[j]);
+    }
+
+    int posIndex = 0;
+
+    // 创建吃豆人
+    Character pacman;
+    pacman.type = CharacterType::PACMAN;
+    pacman.position = validPositions[posIndex++];
+    pacman.id = 0;
+    characters.push_back(pacman);
+
+    // 创建怪物
+    for (int i = 0; i < monsterCount; ++i) {
+        Character monster;
+        monster.type = CharacterType::MONSTER;
+        monster.position = validPositions[posIndex++];
+        monster.id = 1 + i;
+        characters.push_back(monster);
+    }
+
+    return characters;
+}
+
+void buildMatchVisibilityCaches(GameMap &map, ThreadPool *pool) {
+    VisibilitySystem(GameConfig::PACMAN_VISIBILITY_RADIUS).buildCache(map, pool);
+    if (GameConfig::MONSTER_VISIBILITY_RADIUS != GameConfig::PACMAN_VISIBILITY_RADIUS) {
+        VisibilitySystem(GameConfig::MONSTER_VISIBILITY_RADIUS).buildCache(map, pool);
+    }
+}
+
+GameMap generateMatchMap(const MatchConfig &config, const MatchSeeds &seeds, ThreadPool *pool) {
+    RandomMapGenerator mapGenerator(config.mapWidth, config.mapHeight, GameConfig::DOT_RATIO, seeds.mapSeed);
+    GameMap map = mapGenerator.generateMap();
+    if (config.visibilityCache) {
+        buildMatchVisibilityCaches(map, pool);
+    }
+    return map;
+}
+
+GameMap loadMatchMap(const MatchConfig &config, const MatchSeeds &seeds, const MapPack *pack, ThreadPool *pool) {
+    int index = pack != nullptr ? pack->find(seeds.matchSeed) : -1;
+    if (index < 0) {
+        return generateMatchMap(config, seeds, pool);
+    }
+
+    // 先比较尺寸（不读记录内容），再校验记录的 CRC：把墙翻成空地的损坏单元格取值仍然合法，toGameMap 查不出来
+    MapView view = pack->view(index);
+    if (view.getWidth() != config.mapWidth || view.getHeight() != config.mapHeight || !pack->verify(index)) {
+        return generateMatchMap(config, seeds, pool);
+    }
+    GameMap map(0, 0);
+    if (!view.toGameMap(map)) {
+        return generateMatchMap(config, seeds, pool);
+    }
+    if (config.visibilityCache) {
+        buildMatchVisibilityCaches(map, pool);
+    }
+    return map;
+}
+
+std::unique_ptr<TurnBasedGameLoop> createMatch(const GameMap &map, const MatchConfig &config, const MatchSeeds &seeds,
+                                               const AgentFactory &pacmanFactory, const AgentFactory &monsterFactory) {
+    // 创建角色
+    std::vector<Character> characters = createMatchCharacters(map, config.monsterCount, seeds.spawnSeed);
+    if (characters.empty() || seeds.agentSeeds.size() < characters.size()) {
+        return nullptr;
+    }
+
+    auto gameLoop = std::make_unique<TurnBasedGameLoop>(map, characters);
+
+    // 设置AI代理
+    gameLoop->setAIAgent(0, pacmanFactory(seeds.agentSeeds[0]));
+    for (int i = 0; i < config.monsterCount; ++i) {
+        gameLoop->setAIAgent(1 + i, monsterFactory(seeds.agentSeeds[1 + i]));
+    }
+
+    // 设置管理系统
+    gameLoop->setManagementSystem(std::make_unique<ManagementSystem>());
+    gameLoop->setThinkTimeBudget(config.thinkTimeMs);
+
+    // 启动游戏并记录初始状态（第0回合）
+    gameLoop->start();
+    gameLoop->getControlSystem().recordState(gameLoop->getGameState());
+
+    return gameLoop;
+}
+
+std::unique_ptr<TurnBasedGameLoop> createMatch(const MatchConfig &config, uint64_t matchSeed) {
+    MatchSeeds seeds = deriveMatchSeeds(matchSeed, 1 + config.monsterCount);
+    GameMap map = generateMatchMap(config, seeds);
+    return createMatch(map, config, seeds, defaultPacmanFactory(), defaultMonsterFactory());
+}
+
+namespace {
+
+void hashBytes(uint64_t &hash, const void *data, size_t size) {
+    const unsigned char *bytes = static_cast<const unsigned char *>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001B3ULL;
+    }
+}
+
+void hashInt(uint64_t &hash, int value) { hashBytes(hash, &value, sizeof(value)); }
+
+} // namespace
+
+uint64_t hashGameState(const GameStateManager &gameState) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    const GameMap &map = gameState.getMap();
+
+    hashInt(hash, map.getWidth());
+    hashInt(hash, map.getHeight());
+    for (int y = 0; y < map.getHeight(); ++y) {
+        for (int x = 0; x < map.getWidth(); ++x) {
+            hashInt(hash, static_cast<int>(map.getCell(x, y)));
+        }
+    }
+
+    // 逐字段哈希，避免结构体填充字节影响结果
+    for (const auto &character : gameState.getCharacters()) {
+        hashInt(hash, character.id);
+        hashInt(hash, character.position.x);
+        hashInt(hash, character.position.y);
+        hashInt(hash, static_cast<int>(character.type));
+        hashInt(hash, character.isAlive ? 1 : 0);
+    }
+
+    hashInt(hash, gameState.getPacmanScore());
+    hashInt(hash, gameState.getMonsterScore());
+    hashInt(hash, gameState.getRemainingDots());
+    hashInt(hash, gameState.getTurnCount());
+    return hash;
+}
+
+MatchResult runMatch(TurnBasedGameLoop &gameLoop, int maxTurns, const TurnCallback &onTurn) {
+    TraceSpan matchSpan("match", "match");
+    MatchResult result;
+
+    while (gameLoop.getRunning() && gameLoop.getCurrentTurn() < maxTurns) {
+        bool continueGame = gameLoop.executeTurn();
+        if (onTurn) {
+            onTurn(gameLoop.getCurrentTurn());
+        }
+        if (!continueGame || gameLoop.getGameState().isGameOver()) {
+            break;
+        }
+    }
+
+    const GameStateManager &gameState = gameLoop.getGameState();
+    result.turns = gameLoop.getCurrentTurn();
+    result.pacmanScore = gameState.getPacmanScore();
+    result.monsterScore = gameState.getMonsterScore();
+    result.remainingDots = gameState.getRemainingDots();
+    result.finalStateHash = hashGameState(gameState);
+    result.pacmanThinkOverruns = gameLoop.getThinkOverruns(0);
+    for (int i = 1; i < static_cast<int>(gameState.getCharacters().size()); ++i) {
+        result.monsterThinkOverruns += gameLoop.getThinkOverruns(i);
+    }
+
+    if (gameState.getRemainingDots() == 0) {
+        result.outcome = MatchOutcome::PACMAN_WIN;
+    } else if (!gameState.getPacman().isAlive) {
+        result.outcome = MatchOutcome::MONSTER_WIN;
+    } else {
+        result.outcome = MatchOutcome::DRAW;
+    }
+
+    return result;
+}
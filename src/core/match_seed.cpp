@@ -0,0 +1,64 @@
+#include "../../include/match_seed.h"
+
+namespace {
+// 子种子分流编号
+constexpr uint64_t STREAM_MAP = 1;
+constexpr uint64_t STREAM_SPAWN = 2;
+constexpr uint64_t STREAM_AGENT_BASE = 16;
+} // namespace
+
+uint64_t splitMix64(uint64_t value) {
+    value += 0x9E3779B97F4A7C15ULL;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+    return value ^ (value >> 31);
+}
+
+unsigned int deriveSubSeed(uint64_t matchSeed, uint64_t stream) {
+    uint64_t mixed = splitMix64(matchSeed ^ splitMix64(stream));
+    return static_cast<unsigned int>(mixed >> 32);
+}
+
+MatchSeeds deriveMatchSeeds(uint64_t matchSeed, int agentCount) {
+    MatchSeeds seeds;
+    seeds.matchSeed = matchSeed;
+    seeds.mapSeed = deriveSubSeed(matchSeed, STREAM_MAP);
+    seeds.spawnSeed = deriveSubSeed(matchSeed, STREAM_SPAWN);
+
+    for (int i = 0; i < agentCount; ++i) {
+        seeds.agentSeeds.push_back(deriveSubSeed(matchSeed, STREAM_AGENT_BASE + static_cast<uint64_t>(i)));
+    }
+
+    return seeds;
+}
+
+bool parseMatchSeed(std::string_view text, uint64_t &seed) {
+    uint64_t base = 10;
+    if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+        base = 16;
+        text.remove_prefix(2);
+    }
+    if (text.empty()) {
+        return false;
+    }
+
+    uint64_t value = 0;
+    for (char c : text) {
+        uint64_t digit;
+        if (c >= '0' && c <= '9') {
+            digit = static_cast<uint64_t>(c - '0');
+        } else if (base == 16 && c >= 'a' && c <= 'f') {
+            digit = static_cast<uint64_t>(c - 'a' + 10);
+        } else if (base == 16 && c >= 'A' && c <= 'F') {
+            digit = static_cast<uint64_t>(c - 'A' + 10);
+        } else {
+            return false;
+        }
+        if (value > (UINT64_MAX - digit) / base) {
+            return false; // 溢出
+        }
+        value = value * base + digit;
+    }
+    seed = value;
+    return true;
+}
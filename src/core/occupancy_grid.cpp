@@ -0,0 +1,147 @@
+#include "../../include/occupancy_grid.h"
+
+OccupancyGrid::OccupancyGrid() : width(0), height(0) {}
+
+OccupancyGrid::OccupancyGrid(int w, int h) : width(0), height(0) { reset(w, h); }
+
+void OccupancyGrid::reset(int w, int h) {
+    width = w > 0 ? w : 0;
+    height = h > 0 ? h : 0;
+    slots.clear();
+    nextInCell.clear();
+    indexedCell.clear();
+}
+
+int OccupancyGrid::cellIndex(const Position &pos) const {
+    if (pos.x < 0 || pos.x >= width || pos.y < 0 || pos.y >= height) {
+        return -1;
+    }
+    return pos.y * width + pos.x;
+}
+
+int OccupancyGrid::findSlot(int cell) const {
+    if (slots.empty()) {
+        return -1;
+    }
+    // 装载率不超过 1/2，探测序列一定会遇到空槽
+    for (size_t i = hashCell(cell) & slotMask();; i = (i + 1) & slotMask()) {
+        if (slots[i].cell == cell) {
+            return static_cast<int>(i);
+        }
+        if (slots[i].cell < 0) {
+            return -1;
+        }
+    }
+}
+
+int OccupancyGrid::acquireSlot(int cell) {
+    size_t i = hashCell(cell) & slotMask();
+    while (slots[i].cell >= 0 && slots[i].cell != cell) {
+        i = (i + 1) & slotMask();
+    }
+    if (slots[i].cell < 0) {
+        slots[i].cell = cell;
+        slots[i].head = -1;
+    }
+    return static_cast<int>(i);
+}
+
+void OccupancyGrid::eraseSlot(size_t slot) {
+    // 向后移位删除：把探测链上后面的元素前移填补空位，不留墓碑，查找不会越来越慢
+    size_t hole = slot;
+    for (size_t i = (hole + 1) & slotMask(); slots[i].cell >= 0; i = (i + 1) & slotMask()) {
+        size_t home = hashCell(slots[i].cell) & slotMask();
+        // home 在 (hole, i] 之间（环上）时该元素不能前移
+        bool staysPut = hole <= i ? (hole < home && home <= i) : (hole < home || home <= i);
+        if (!staysPut) {
+            slots[hole] = slots[i];
+            hole = i;
+        }
+    }
+    slots[hole].cell = -1;
+    slots[hole].head = -1;
+}
+
+void OccupancyGrid::insert(int index, int cell) {
+    indexedCell[index] = cell;
+    if (cell < 0) {
+        return;
+    }
+
+    // 保持链表按下标升序，查询时先遇到的就是角色列表中靠前的角色
+    int *link = &slots[acquireSlot(cell)].head;
+    while (*link != -1 && *link < index) {
+        link = &nextInCell[*link];
+    }
+    nextInCell[index] = *link;
+    *link = index;
+}
+
+void OccupancyGrid::remove(int index) {
+    int cell = indexedCell[index];
+    if (cell < 0) {
+        return;
+    }
+
+    int slot = findSlot(cell);
+    int *link = &slots[slot].head;
+    while (*link != index) {
+        link = &nextInCell[*link];
+    }
+    *link = nextInCell[index];
+    nextInCell[index] = -1;
+    indexedCell[index] = -1;
+    if (slots[slot].head < 0) {
+        eraseSlot(static_cast<size_t>(slot));
+    }
+}
+
+void OccupancyGrid::update(const std::vector<Character> &characters) {
+    if (characters.size() != indexedCell.size()) {
+        size_t capacity = 8;
+        while (capacity < 2 * characters.size()) {
+            capacity *= 2;
+        }
+        slots.assign(capacity, Slot{-1, -1});
+        nextInCell.assign(characters.size(), -1);
+        indexedCell.assign(characters.size(), -1);
+        for (size_t i = 0; i < characters.size(); ++i) {
+            insert(static_cast<int>(i), cellIndex(characters[i].position));
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < characters.size(); ++i) {
+        int cell = cellIndex(characters[i].position);
+        if (cell != indexedCell[i]) {
+            remove(static_cast<int>(i));
+            insert(static_cast<int>(i), cell);
+        }
+    }
+}
+
+void OccupancyGrid::moveCharacter(int index, const Position &newPos) {
+    if (index < 0 || index >= static_cast<int>(indexedCell.size())) {
+        return;
+    }
+    int cell = cellIndex(newPos);
+    if (cell != indexedCell[index]) {
+        remove(index);
+        insert(index, cell);
+    }
+}
+
+int OccupancyGrid::firstAt(const Position &pos) const { return firstAt(pos.x, pos.y); }
+
+int OccupancyGrid::findAlive(const Position &pos, const std::vector<Character> &characters) const {
+    return findAlive(pos.x, pos.y, characters);
+}
+
+int OccupancyGrid::findAlive(int x, int y, const std::vector<Character> &characters) const {
+    for (int index = firstAt(x, y); index != -1; index = nextInCell[index]) {
+        if (characters[index].isAlive) {
+            return index;
+        }
+    }
+    return -1;
+}
@@ -1,11 +1,8 @@
 #include "../../include/random_map_generator.h"
 #include <algorithm>
-#include <ctime>
 
-RandomMapGenerator::RandomMapGenerator(int w, int h, float ratio)
-    : width(w), height(h), dotRatio(ratio), currentMap(nullptr) {
-    randomEngine.seed(static_cast<unsigned int>(std::time(nullptr)));
-}
+RandomMapGenerator::RandomMapGenerator(int w, int h, float ratio, unsigned int seed)
+    : width(w), height(h), dotRatio(ratio), randomEngine(seed), currentMap(nullptr) {}
 
 void RandomMapGenerator::setSeed(unsigned int seed) { randomEngine.seed(seed); }
 
@@ -33,6 +30,7 @@ GameMap RandomMapGenerator::generateMap() {
     placeDots();
 
     map.setTotalDots(map.countDots());
+    currentMap = nullptr;
 
     return map;
 }
@@ -113,9 +111,12 @@ void RandomMapGenerator::createSmallOpenArea(int centerX, int centerY) {
 }
 
 void RandomMapGenerator::placeDots() {
-    int dotCount = 0;
     int targetDots = static_cast<int>((width - 2) * (height - 2) * dotRatio);
 
+    // 第一遍按 dotRatio 概率放置，没放上豆子的空地留作补充豆子的候选
+    int dotCount = 0;
+    std::vector<Position> &candidates = candidateBuffer;
+    candidates.clear();
     for (int y = 1; y < height - 1; ++y) {
         for (int x = 1; x < width - 1; ++x) {
             Position pos(x, y);
@@ -124,71 +125,135 @@ void RandomMapGenerator::placeDots() {
                 if ((randomEngine() % 100) < (dotRatio * 100)) {
                     currentMap->setCell(pos, CellType::DOT);
                     dotCount++;
+                } else {
+                    candidates.push_back(pos);
                 }
             }
         }
     }
 
-    // 确保至少有足够的豆子
-    while (dotCount < std::min(targetDots, GameConfig::DOTS_TO_WIN)) {
-        int x = 1 + (randomEngine() % (width - 2));
-        int y = 1 + (randomEngine() % (height - 2));
-        Position pos(x, y);
-
-        if (currentMap->isEmpty(pos)) {
-            currentMap->setCell(pos, CellType::DOT);
-            dotCount++;
-        }
+    // 确保至少有足够的豆子：从候选中无放回地抽取，空地用完就停止，不会因为空地不足而卡住
+    size_t remaining = candidates.size();
+    while (dotCount < std::min(targetDots, GameConfig::DOTS_TO_WIN) && remaining > 0) {
+        size_t pick = randomEngine() % remaining;
+        currentMap->setCell(candidates[pick], CellType::DOT);
+        candidates[pick] = candidates[--remaining];
+        dotCount++;
     }
 }
 
-std::vector<Position> RandomMapGenerator::generateCharacterPositions(int characterCount) {
-    std::vector<Position> positions;
-    int attempts = 0;
-    const int maxAttempts = 10000; // 增加尝试次数
-
-    while (positions.size() < static_cast<size_t>(characterCount) && attempts < maxAttempts) {
-        int x = 1 + (randomEngine() % (width - 2));
-        int y = 1 + (randomEngine() % (height - 2));
-        Position pos(x, y);
+namespace {
+
+// 角色位置的均匀网格：按桶记录已放置的位置，距离检查只看查询点附近的桶
+class SpawnGrid {
+  private:
+    int bucketSize;
+    int columns;
+    int rows;
+    std::vector<int> bucketHead; // 每个桶中最后放入的位置下标，没有为 -1
+    std::vector<int> nextInBucket;
+    const std::vector<Position> &positions;
+
+  public:
+    SpawnGrid(int width, int height, int size, const std::vector<Position> &placed)
+        : bucketSize(size), columns(width / size + 1), rows(height / size + 1),
+          bucketHead(static_cast<size_t>(columns) * rows, -1), positions(placed) {}
+
+    void add(int index) {
+        const Position &pos = positions[index];
+        int bucket = (pos.y / bucketSize) * columns + pos.x / bucketSize;
+        nextInBucket.push_back(bucketHead[bucket]);
+        bucketHead[bucket] = index;
+    }
 
-        if (isValidCharacterPosition(pos, positions)) {
-            positions.push_back(pos);
+    // 是否有已放置的位置与 pos 的曼哈顿距离小于 minDistance
+    bool hasNeighborWithin(const Position &pos, int minDistance) const {
+        int reach = minDistance - 1;
+        int bx0 = std::max(0, (pos.x - reach) / bucketSize);
+        int bx1 = std::min(columns - 1, (pos.x + reach) / bucketSize);
+        int by0 = std::max(0, (pos.y - reach) / bucketSize);
+        int by1 = std::min(rows - 1, (pos.y + reach) / bucketSize);
+        for (int by = by0; by <= by1; ++by) {
+            for (int bx = bx0; bx <= bx1; ++bx) {
+                for (int i = bucketHead[by * columns + bx]; i >= 0; i = nextInBucket[i]) {
+                    if (pos.manhattanDistance(positions[i]) < minDistance) {
+                        return true;
+                    }
+                }
+            }
         }
-
-        attempts++;
+        return false;
     }
+};
 
-    return positions;
-}
+} // namespace
 
-bool RandomMapGenerator::isValidCharacterPosition(const Position &pos,
-                                                  const std::vector<Position> &existingPositions) const {
-    // 检查是否是空地或有豆子的位置
-    if (!currentMap->isEmpty(pos) && !currentMap->hasDot(pos)) {
-        return false;
+std::vector<Position> RandomMapGenerator::generateCharacterPositions(const GameMap &map, int characterCount) {
+    std::vector<Position> positions;
+    if (characterCount <= 0) {
+        return positions;
     }
 
-    // 检查与其他角色的距离（降低最小距离要求）
-    int minDistance = (existingPositions.size() < 2) ? GameConfig::MIN_DISTANCE_BETWEEN_CHARACTERS : 3;
-    for (const auto &existing : existingPositions) {
-        if (pos.manhattanDistance(existing) < minDistance) {
-            return false;
+    // 候选位置只取决于地图，一遍扫描得到；之后每个候选最多被抽到两次，总耗时与地图面积成线性
+    // 候选本身必须可走，且周围 3x3 内至少有 3 个可走的格子（降低要求）：按列统计上中下三行的可走格数，
+    // 横向滑动求和
+    std::vector<Position> &candidates = candidateBuffer;
+    candidates.clear();
+    for (int y = 1; y < map.getHeight() - 1; ++y) {
+        const CellType *above = map.getRow(y - 1);
+        const CellType *row = map.getRow(y);
+        const CellType *below = map.getRow(y + 1);
+        auto columnFree = [&](int x) {
+            return (above[x] != CellType::WALL) + (row[x] != CellType::WALL) + (below[x] != CellType::WALL);
+        };
+        int left = columnFree(0);
+        int center = columnFree(1);
+        for (int x = 1; x < map.getWidth() - 1; ++x) {
+            int right = columnFree(x + 1);
+            if (row[x] != CellType::WALL && left + center + right >= 3) {
+                candidates.push_back(Position(x, y));
+            }
+            left = center;
+            center = right;
         }
     }
 
-    // 检查周围是否有足够的活动空间（降低要求）
-    int emptyCount = 0;
-    for (int dy = -1; dy <= 1; ++dy) {
-        for (int dx = -1; dx <= 1; ++dx) {
-            Position neighbor(pos.x + dx, pos.y + dy);
-            if (currentMap->isEmpty(neighbor) || currentMap->hasDot(neighbor)) {
-                emptyCount++;
+    // 前两个角色之间至少相距 MIN_DISTANCE_BETWEEN_CHARACTERS，其余角色放宽到 3（降低最小距离要求）
+    // 候选随机抽取后即从候选区 candidates[0, remaining) 移除。严格阶段因距离不足被拒的候选暂存在数组末尾，
+    // 放宽时移回候选区；放宽之后已放置的位置只增不减，被拒的候选以后也不会满足，直接丢弃
+    const int relaxedDistance = 3;
+    SpawnGrid grid(map.getWidth(), map.getHeight(),
+                   std::max(GameConfig::MIN_DISTANCE_BETWEEN_CHARACTERS, relaxedDistance), positions);
+    positions.reserve(characterCount);
+    size_t remaining = candidates.size();
+    size_t deferred = 0; // 暂存的候选位于 candidates[size - deferred, size)
+    while (static_cast<int>(positions.size()) < characterCount && remaining > 0) {
+        bool strict = positions.size() < 2;
+        size_t pick = randomEngine() % remaining;
+        Position pos = candidates[pick];
+        candidates[pick] = candidates[--remaining];
+
+        int minDistance = strict ? GameConfig::MIN_DISTANCE_BETWEEN_CHARACTERS : relaxedDistance;
+        if (grid.hasNeighborWithin(pos, minDistance)) {
+            if (strict) {
+                candidates[candidates.size() - 1 - deferred] = pos;
+                deferred++;
             }
+            continue;
+        }
+
+        positions.push_back(pos);
+        grid.add(static_cast<int>(positions.size()) - 1);
+        if (positions.size() == 2) {
+            // 由前向后搬移：写入位置总不超过读取位置，不会覆盖尚未搬走的候选
+            for (size_t i = candidates.size() - deferred; i < candidates.size(); ++i) {
+                candidates[remaining++] = candidates[i];
+            }
+            deferred = 0;
         }
     }
 
-    return emptyCount >= 3; // 降低到至少3个可移动的格子
+    return positions;
 }
 
 bool RandomMapGenerator::isInBounds(int x, int y) const { return x >= 0 && x < width && y >= 0 && y < height; }
@@ -0,0 +1,245 @@
+#include "../../include/replay.h"
+#include "../../include/management_system.h"
+#include "../../include/state_codec.h"
+#include <algorithm>
+
+namespace {
+
+constexpr uint32_t ACTION_MASK = (1u << ReplayFormat::BITS_PER_ACTION) - 1;
+constexpr size_t HEADER_BYTES = 32;
+constexpr size_t INDEX_ENTRY_BYTES = 16;
+
+} // namespace
+
+ReplayRecorder::ReplayRecorder(uint64_t seed, int interval)
+    : matchSeed(seed), keyframeInterval(interval), characterCount(0), turnCount(0), started(false), actionBitCount(0),
+      keyframeActionBits(0) {}
+
+void ReplayRecorder::begin(const GameStateManager &initialState) {
+    characterCount = static_cast<int>(initialState.getCharacters().size());
+    turnCount = 0;
+    actionBits.clear();
+    actionBitCount = 0;
+    keyframeActionBits = 0;
+    keyframes.clear();
+    keyframeData.clear();
+    started = appendKeyframe(initialState);
+}
+
+void ReplayRecorder::appendAction(Direction direction) {
+    uint32_t code = static_cast<uint32_t>(direction) & ACTION_MASK;
+    size_t bitOffset = static_cast<size_t>(actionBitCount % 8);
+    if (bitOffset == 0) {
+        actionBits.push_back(0);
+    }
+    actionBits.back() |= static_cast<uint8_t>(code << bitOffset);
+    // 跨字节时把高位写进下一个字节
+    if (bitOffset + ReplayFormat::BITS_PER_ACTION > 8) {
+        actionBits.push_back(static_cast<uint8_t>(code >> (8 - bitOffset)));
+    }
+    actionBitCount += ReplayFormat::BITS_PER_ACTION;
+}
+
+bool ReplayRecorder::appendKeyframe(const GameStateManager &gameState) {
+    ByteWriter writer;
+    if (!StateCodec::writeGameState(writer, gameState)) {
+        return false;
+    }
+
+    KeyframeEntry entry;
+    entry.turn = static_cast<uint32_t>(turnCount);
+    entry.offset = keyframeData.size();
+    entry.size = static_cast<uint32_t>(writer.size());
+    keyframes.push_back(entry);
+    keyframeData.insert(keyframeData.end(), writer.data().begin(), writer.data().end());
+    keyframeActionBits = actionBitCount;
+    return true;
+}
+
+bool ReplayRecorder::needsKeyframe() const {
+    if (keyframeInterval <= 0 || turnCount - static_cast<int>(keyframes.back().turn) < keyframeInterval) {
+        return false;
+    }
+    uint64_t actionBytes = (actionBitCount - keyframeActionBits) / 8;
+    return actionBytes * ReplayFormat::KEYFRAME_ACTION_RATIO >= keyframes.back().size;
+}
+
+bool ReplayRecorder::recordTurn(const std::vector<Action> &actions, const GameStateManager &stateAfter) {
+    if (!started || static_cast<int>(actions.size()) != characterCount) {
+        return false;
+    }
+
+    for (const auto &action : actions) {
+        appendAction(action.direction);
+    }
+    turnCount++;
+
+    if (needsKeyframe()) {
+        appendKeyframe(stateAfter);
+    }
+    return true;
+}
+
+std::vector<uint8_t> ReplayRecorder::serialize() const {
+    ByteWriter writer;
+    writer.writeU32(ReplayFormat::MAGIC);
+    writer.writeU16(ReplayFormat::VERSION);
+    writer.writeU16(ReplayFormat::BITS_PER_ACTION);
+    writer.writeU64(matchSeed);
+    writer.writeU32(static_cast<uint32_t>(characterCount));
+    writer.writeU32(static_cast<uint32_t>(turnCount));
+    writer.writeU32(static_cast<uint32_t>(std::max(keyframeInterval, 0)));
+    writer.writeU32(static_cast<uint32_t>(keyframes.size()));
+
+    // 关键帧位于行动流之后，偏移换算成文件内的绝对位置
+    uint64_t keyframeBase = HEADER_BYTES + keyframes.size() * INDEX_ENTRY_BYTES + 8 + actionBits.size();
+    for (const auto &entry : keyframes) {
+        writer.writeU32(entry.turn);
+        writer.writeU64(keyframeBase + entry.offset);
+        writer.writeU32(entry.size);
+    }
+
+    writer.writeU64(actionBits.size());
+    writer.writeBytes(actionBits.data(), actionBits.size());
+    writer.writeBytes(keyframeData.data(), keyframeData.size());
+    return writer.release();
+}
+
+bool ReplayRecorder::saveToFile(const std::string &filename) const {
+    return started && writeFileBytes(filename, serialize());
+}
+
+ReplayPlayer::ReplayPlayer(std::unique_ptr<ManagementInterface> management)
+    : managementSystem(std::move(management)), matchSeed(0), keyframeInterval(0), characterCount(0), turnCount(0),
+      actionOffset(0) {
+    if (!managementSystem) {
+        managementSystem = std::make_unique<ManagementSystem>();
+    }
+}
+
+bool ReplayPlayer::loadFromFile(const std::string &filename) {
+    if (!readFileBytes(filename, fileData)) {
+        fileData.clear();
+        return false;
+    }
+    return parse();
+}
+
+bool ReplayPlayer::loadFromBuffer(const std::vector<uint8_t> &data) {
+    fileData = data;
+    return parse();
+}
+
+bool ReplayPlayer::parse() {
+    keyframes.clear();
+    turnCount = 0;
+    characterCount = 0;
+
+    ByteReader reader(fileData.data(), fileData.size());
+    uint32_t magic = reader.readU32();
+    uint16_t version = reader.readU16();
+    uint16_t bitsPerAction = reader.readU16();
+    uint64_t seed = reader.readU64();
+    uint32_t characters = reader.readU32();
+    uint32_t turns = reader.readU32();
+    uint32_t interval = reader.readU32();
+    uint32_t keyframeCount = reader.readU32();
+    if (!reader.ok() || magic != ReplayFormat::MAGIC || version != ReplayFormat::VERSION ||
+        bitsPerAction != ReplayFormat::BITS_PER_ACTION || characters > 0xFFFF || turns > 0x7FFFFFFF ||
+        keyframeCount == 0 || keyframeCount > reader.remaining() / INDEX_ENTRY_BYTES) {
+        return false;
+    }
+
+    std::vector<KeyframeEntry> entries(keyframeCount);
+    for (auto &entry : entries) {
+        uint32_t turn = reader.readU32();
+        uint64_t offset = reader.readU64();
+        uint32_t size = reader.readU32();
+        if (turn > turns || offset > fileData.size() || size > fileData.size() - offset) {
+            return false;
+        }
+        entry.turn = static_cast<int>(turn);
+        entry.offset = static_cast<size_t>(offset);
+        entry.size = size;
+    }
+    // 第 0 个关键帧必须是初始状态，其余按回合严格递增
+    if (entries[0].turn != 0) {
+        return false;
+    }
+    for (size_t i = 1; i < entries.size(); ++i) {
+        if (entries[i].turn <= entries[i - 1].turn) {
+            return false;
+        }
+    }
+
+    uint64_t actionBytes = reader.readU64();
+    uint64_t requiredBits = static_cast<uint64_t>(turns) * characters * ReplayFormat::BITS_PER_ACTION;
+    if (!reader.ok() || actionBytes > reader.remaining() || actionBytes < (requiredBits + 7) / 8) {
+        return false;
+    }
+
+    matchSeed = seed;
+    characterCount = static_cast<int>(characters);
+    turnCount = static_cast<int>(turns);
+    keyframeInterval = static_cast<int>(interval);
+    actionOffset = reader.tell();
+    keyframes = std::move(entries);
+
+    // 一次性检查所有行动编码，之后解码时不必再判断
+    uint64_t actionCount = static_cast<uint64_t>(turns) * characters;
+    for (uint64_t i = 0; i < actionCount; ++i) {
+        if (static_cast<uint32_t>(actionAt(i)) > static_cast<uint32_t>(Direction::STAY)) {
+            keyframes.clear();
+            turnCount = 0;
+            characterCount = 0;
+            return false;
+        }
+    }
+    return true;
+}
+
+Direction ReplayPlayer::actionAt(uint64_t actionIndex) const {
+    uint64_t bit = actionIndex * ReplayFormat::BITS_PER_ACTION;
+    size_t byte = actionOffset + static_cast<size_t>(bit / 8);
+    uint32_t word = fileData[byte];
+    if ((bit % 8) + ReplayFormat::BITS_PER_ACTION > 8) {
+        word |= static_cast<uint32_t>(fileData[byte + 1]) << 8;
+    }
+    return static_cast<Direction>((word >> (bit % 8)) & ACTION_MASK);
+}
+
+bool ReplayPlayer::getActions(int turn, std::vector<Action> &actions) const {
+    if (turn < 1 || turn > turnCount) {
+        return false;
+    }
+    actions.resize(characterCount);
+    uint64_t first = static_cast<uint64_t>(turn - 1) * characterCount;
+    for (int i = 0; i < characterCount; ++i) {
+        actions[i] = Action(actionAt(first + i));
+    }
+    return true;
+}
+
+bool ReplayPlayer::seek(int turn, GameStateManager &out) {
+    if (turn < 0 || turn > turnCount || keyframes.empty()) {
+        return false;
+    }
+
+    // 不晚于目标回合的最近关键帧
+    auto it = std::upper_bound(keyframes.begin(), keyframes.end(), turn,
+                               [](int value, const KeyframeEntry &entry) { return value < entry.turn; });
+    const KeyframeEntry &keyframe = *(it - 1);
+
+    ByteReader reader(fileData.data() + keyframe.offset, keyframe.size);
+    if (!StateCodec::readGameState(reader, out)) {
+        return false;
+    }
+
+    // 与 TurnBasedGameLoop::executeTurn 相同的顺序：处理行动，然后回合数加一
+    for (int t = keyframe.turn + 1; t <= turn; ++t) {
+        getActions(t, turnActions);
+        managementSystem->processActions(turnActions, out);
+        out.incrementTurnCount();
+    }
+    return true;
+}
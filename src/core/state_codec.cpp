@@ -0,0 +1,305 @@
+#include "../../include/state_codec.h"
+#include "../../include/bit_ops.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+namespace StateCodec {
+
+namespace {
+
+constexpr int BITS_PER_CELL = 2;
+constexpr int CELLS_PER_BYTE = 8 / BITS_PER_CELL;
+constexpr size_t CHARACTER_BYTES = 14;
+constexpr size_t SAVE_HEADER_BYTES = 16;
+constexpr size_t SECTION_HEADER_BYTES = 16;
+
+constexpr uint32_t makeTag(char a, char b, char c, char d) {
+    return static_cast<uint32_t>(static_cast<uint8_t>(a)) | static_cast<uint32_t>(static_cast<uint8_t>(b)) << 8 |
+           static_cast<uint32_t>(static_cast<uint8_t>(c)) << 16 | static_cast<uint32_t>(static_cast<uint8_t>(d)) << 24;
+}
+
+constexpr uint32_t TAG_MAP = makeTag('M', 'A', 'P', ' ');
+constexpr uint32_t TAG_CHARACTERS = makeTag('C', 'H', 'A', 'R');
+constexpr uint32_t TAG_STATUS = makeTag('S', 'T', 'A', 'T');
+
+void writeScores(ByteWriter &writer, const GameStateManager &gameState) {
+    writer.writeI32(gameState.getPacmanScore());
+    writer.writeI32(gameState.getMonsterScore());
+    writer.writeI32(gameState.getRemainingDots());
+    writer.writeI32(gameState.getTurnCount());
+}
+
+bool readScores(ByteReader &reader, GameState &state) {
+    state.pacmanScore = reader.readI32();
+    state.monsterScore = reader.readI32();
+    state.remainingDots = reader.readI32();
+    state.turnCount = reader.readI32();
+    return reader.ok();
+}
+
+// 写一个分节：先占位头部，写完载荷后回填长度和 CRC
+template <typename Fn> void writeSection(ByteWriter &writer, uint32_t tag, Fn writePayload) {
+    size_t headerOffset = writer.size();
+    writer.writeU32(tag);
+    writer.writeU32(0);
+    writer.writeU64(0);
+    writePayload();
+
+    size_t payloadOffset = headerOffset + SECTION_HEADER_BYTES;
+    uint64_t length = writer.size() - payloadOffset;
+    writer.patchU32(headerOffset + 4, crc32(writer.data().data() + payloadOffset, static_cast<size_t>(length)));
+    writer.patchU32(headerOffset + 8, static_cast<uint32_t>(length));
+    writer.patchU32(headerOffset + 12, static_cast<uint32_t>(length >> 32));
+}
+
+} // namespace
+
+bool writeMap(ByteWriter &writer, const GameMap &map) {
+    int width = map.getWidth();
+    int height = map.getHeight();
+    if (width > MAX_MAP_DIMENSION || height > MAX_MAP_DIMENSION) {
+        return false;
+    }
+    writer.writeI32(width);
+    writer.writeI32(height);
+    writer.writeI32(map.getTotalDots());
+
+    // 单元格按行优先连续编号，每字节 4 格，低位在前；宽为 0 时没有单元格
+    uint8_t packed = 0;
+    int filled = 0;
+    for (int y = 0; width > 0 && y < height; ++y) {
+        const CellType *row = map.getRow(y);
+        for (int x = 0; x < width; ++x) {
+            packed |= static_cast<uint8_t>(static_cast<uint8_t>(row[x]) << (filled * BITS_PER_CELL));
+            if (++filled == CELLS_PER_BYTE) {
+                writer.writeU8(packed);
+                packed = 0;
+                filled = 0;
+            }
+        }
+    }
+    if (filled > 0) {
+        writer.writeU8(packed);
+    }
+    return true;
+}
+
+// 从位流第 bitPos 位起取 64 位：字节按小端序拼接，与主机字节序无关；超出 byteCount 的部分为 0
+uint64_t loadBits(const uint8_t *data, size_t byteCount, size_t bitPos) {
+    size_t first = bitPos / 8;
+    int shift = static_cast<int>(bitPos % 8);
+    size_t available = byteCount - first;
+    uint64_t value = 0;
+    if (available > 8) {
+        // 常见情况：固定 8 次的拼接会被编译器合并成一次装入
+        for (int i = 0; i < 8; ++i) {
+            value |= static_cast<uint64_t>(data[first + i]) << (8 * i);
+        }
+        return shift == 0 ? value : (value >> shift) | (static_cast<uint64_t>(data[first + 8]) << (64 - shift));
+    }
+    for (size_t i = 0; i < available; ++i) {
+        value |= static_cast<uint64_t>(data[first + i]) << (8 * i);
+    }
+    return value >> shift;
+}
+
+// 把偶数位（第 2i 位）压缩到低 32 位的第 i 位，奇数位必须为 0
+uint64_t compressEvenBits(uint64_t bits) {
+    bits = (bits | (bits >> 1)) & 0x3333333333333333ULL;
+    bits = (bits | (bits >> 2)) & 0x0F0F0F0F0F0F0F0FULL;
+    bits = (bits | (bits >> 4)) & 0x00FF00FF00FF00FFULL;
+    bits = (bits | (bits >> 8)) & 0x0000FFFF0000FFFFULL;
+    return (bits | (bits >> 16)) & 0x00000000FFFFFFFFULL;
+}
+
+bool readMap(ByteReader &reader, GameMap &map) {
+    int width = reader.readI32();
+    int height = reader.readI32();
+    int totalDots = reader.readI32();
+    if (!reader.ok() || width < 0 || height < 0 || width > MAX_MAP_DIMENSION || height > MAX_MAP_DIMENSION) {
+        return false;
+    }
+
+    size_t cellCount = static_cast<size_t>(width) * height;
+    const uint8_t *packed = reader.readBytes((cellCount + CELLS_PER_BYTE - 1) / CELLS_PER_BYTE);
+    if (cellCount > 0 && packed == nullptr) {
+        return false;
+    }
+
+    // 一遍解码：每次从位流取 32 格（64 位），同时检查编码、展开单元格并生成两个位平面，直接写入地图的各行。
+    // 每格低位为墙（01）、高位为豆子（10），编码 3 不是合法的单元格类型
+    static const struct UnpackTable {
+        uint8_t cells[256][CELLS_PER_BYTE];
+        UnpackTable() {
+            for (int byte = 0; byte < 256; ++byte) {
+                for (int i = 0; i < CELLS_PER_BYTE; ++i) {
+                    cells[byte][i] = static_cast<uint8_t>((byte >> (i * BITS_PER_CELL)) & 3);
+                }
+            }
+        }
+    } table;
+
+    const uint64_t lowBits = 0x5555555555555555ULL;
+    size_t byteCount = (cellCount + CELLS_PER_BYTE - 1) / CELLS_PER_BYTE;
+    GameMap result(width, height);
+    for (int y = 0; width > 0 && y < height; ++y) {
+        GameMap::RowWriter row = result.writeRow(y);
+        size_t rowBit = static_cast<size_t>(y) * width * BITS_PER_CELL;
+        for (int x = 0; x < width; x += 32) {
+            int count = std::min(32, width - x);
+            uint64_t bits = loadBits(packed, byteCount, rowBit + static_cast<size_t>(x) * BITS_PER_CELL);
+            bits &= BitOps::lowMask(count * BITS_PER_CELL);
+            uint64_t walls = bits & lowBits;
+            uint64_t dots = (bits >> 1) & lowBits;
+            if ((walls & dots) != 0) {
+                return false;
+            }
+
+            int fullBytes = count / CELLS_PER_BYTE;
+            for (int i = 0; i < fullBytes; ++i) {
+                std::memcpy(row.cells + x + i * CELLS_PER_BYTE, table.cells[(bits >> (i * 8)) & 0xFF], CELLS_PER_BYTE);
+            }
+            for (int i = fullBytes * CELLS_PER_BYTE; i < count; ++i) {
+                row.cells[x + i] = static_cast<CellType>((bits >> (i * BITS_PER_CELL)) & 3);
+            }
+            // 32 格占半个字：x 为 64 的倍数时开始新字，否则填高半部分
+            int word = x / 64;
+            int shift = x % 64;
+            uint64_t wallWord = compressEvenBits(walls) << shift;
+            uint64_t dotWord = compressEvenBits(dots) << shift;
+            row.wallBits[word] = shift == 0 ? wallWord : row.wallBits[word] | wallWord;
+            row.dotBits[word] = shift == 0 ? dotWord : row.dotBits[word] | dotWord;
+        }
+    }
+    result.setTotalDots(totalDots);
+    map = std::move(result);
+    return true;
+}
+
+void writeCharacters(ByteWriter &writer, const std::vector<Character> &characters) {
+    writer.writeU32(static_cast<uint32_t>(characters.size()));
+    for (const auto &character : characters) {
+        writer.writeI32(character.id);
+        writer.writeI32(character.position.x);
+        writer.writeI32(character.position.y);
+        writer.writeU8(static_cast<uint8_t>(character.type));
+        writer.writeU8(character.isAlive ? 1 : 0);
+    }
+}
+
+bool readCharacters(ByteReader &reader, std::vector<Character> &characters) {
+    // 每个角色占 14 字节，先按剩余长度检查数量，避免损坏的数据触发巨大的分配
+    uint32_t characterCount = reader.readU32();
+    if (!reader.ok() || characterCount > reader.remaining() / CHARACTER_BYTES) {
+        return false;
+    }
+    characters.resize(characterCount);
+    for (auto &character : characters) {
+        character.id = reader.readI32();
+        character.position.x = reader.readI32();
+        character.position.y = reader.readI32();
+        uint8_t type = reader.readU8();
+        uint8_t alive = reader.readU8();
+        if (type > static_cast<uint8_t>(CharacterType::MONSTER) || alive > 1) {
+            return false;
+        }
+        character.type = static_cast<CharacterType>(type);
+        character.isAlive = alive != 0;
+    }
+    return reader.ok();
+}
+
+bool writeGameState(ByteWriter &writer, const GameStateManager &gameState) {
+    if (!writeMap(writer, gameState.getMap())) {
+        return false;
+    }
+    writeCharacters(writer, gameState.getCharacters());
+    writeScores(writer, gameState);
+    return true;
+}
+
+bool readGameState(ByteReader &reader, GameStateManager &gameState) {
+    GameState state;
+    if (!readMap(reader, state.map) || !readCharacters(reader, state.characters) || !readScores(reader, state)) {
+        return false;
+    }
+    gameState.restoreState(state);
+    return true;
+}
+
+bool isSaveFile(const uint8_t *data, size_t size) {
+    ByteReader reader(data, size);
+    return reader.readU32() == SAVE_MAGIC && reader.ok();
+}
+
+std::vector<uint8_t> encodeSaveFile(const GameStateManager &gameState) {
+    const GameMap &map = gameState.getMap();
+    if (map.getWidth() > MAX_MAP_DIMENSION || map.getHeight() > MAX_MAP_DIMENSION) {
+        return {};
+    }
+
+    ByteWriter writer;
+    writer.writeU32(SAVE_MAGIC);
+    writer.writeU16(SAVE_VERSION);
+    writer.writeU16(0);
+    writer.writeU32(3);
+    writer.writeU32(crc32(writer.data().data(), writer.size()));
+
+    writeSection(writer, TAG_MAP, [&] { writeMap(writer, map); });
+    writeSection(writer, TAG_CHARACTERS, [&] { writeCharacters(writer, gameState.getCharacters()); });
+    writeSection(writer, TAG_STATUS, [&] { writeScores(writer, gameState); });
+    return writer.release();
+}
+
+bool decodeSaveFile(const uint8_t *data, size_t size, GameStateManager &gameState) {
+    ByteReader reader(data, size);
+    uint32_t magic = reader.readU32();
+    uint16_t version = reader.readU16();
+    reader.readU16();
+    uint32_t sectionCount = reader.readU32();
+    uint32_t headerCrc = reader.readU32();
+    if (!reader.ok() || magic != SAVE_MAGIC || version != SAVE_VERSION ||
+        headerCrc != crc32(data, SAVE_HEADER_BYTES - 4)) {
+        return false;
+    }
+
+    GameState state;
+    bool hasMap = false;
+    bool hasCharacters = false;
+    bool hasStatus = false;
+    for (uint32_t i = 0; i < sectionCount; ++i) {
+        uint32_t tag = reader.readU32();
+        uint32_t payloadCrc = reader.readU32();
+        uint64_t length = reader.readU64();
+        if (!reader.ok() || length > reader.remaining()) {
+            return false;
+        }
+        const uint8_t *payload = data + reader.tell();
+        reader.skip(static_cast<size_t>(length));
+        if (crc32(payload, static_cast<size_t>(length)) != payloadCrc) {
+            return false;
+        }
+
+        // 每节必须恰好用完自己的载荷
+        ByteReader section(payload, static_cast<size_t>(length));
+        if (tag == TAG_MAP) {
+            hasMap = readMap(section, state.map) && section.remaining() == 0;
+            if (!hasMap) return false;
+        } else if (tag == TAG_CHARACTERS) {
+            hasCharacters = readCharacters(section, state.characters) && section.remaining() == 0;
+            if (!hasCharacters) return false;
+        } else if (tag == TAG_STATUS) {
+            hasStatus = readScores(section, state) && section.remaining() == 0;
+            if (!hasStatus) return false;
+        }
+    }
+    if (!hasMap || !hasCharacters || !hasStatus) {
+        return false;
+    }
+
+    gameState.restoreState(state);
+    return true;
+}
+
+} // namespace StateCodec
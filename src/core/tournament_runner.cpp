@@ -0,0 +1,156 @@
+#include "../../include/tournament_runner.h"
+#include "../../include/thread_pool.h"
+#include "../../include/trace_recorder.h"
+#include <algorithm>
+#include <chrono>
+
+void PairingStats::addResult(const MatchResult &result) {
+    if (matches == 0 || result.turns < minTurns) minTurns = result.turns;
+    if (matches == 0 || result.turns > maxTurns) maxTurns = result.turns;
+
+    matches++;
+    totalTurns += result.turns;
+    totalPacmanScore += result.pacmanScore;
+    totalMonsterScore += result.monsterScore;
+    pacmanThinkOverruns += result.pacmanThinkOverruns;
+    monsterThinkOverruns += result.monsterThinkOverruns;
+
+    switch (result.outcome) {
+    case MatchOutcome::PACMAN_WIN:
+        pacmanWins++;
+        break;
+    case MatchOutcome::MONSTER_WIN:
+        monsterWins++;
+        break;
+    case MatchOutcome::DRAW:
+        draws++;
+        break;
+    }
+}
+
+void PairingStats::merge(const PairingStats &other) {
+    if (other.matches > 0) {
+        if (matches == 0 || other.minTurns < minTurns) minTurns = other.minTurns;
+        if (matches == 0 || other.maxTurns > maxTurns) maxTurns = other.maxTurns;
+    }
+
+    matches += other.matches;
+    pacmanWins += other.pacmanWins;
+    monsterWins += other.monsterWins;
+    draws += other.draws;
+    failedSetups += other.failedSetups;
+    totalTurns += other.totalTurns;
+    totalPacmanScore += other.totalPacmanScore;
+    totalMonsterScore += other.totalMonsterScore;
+    pacmanThinkOverruns += other.pacmanThinkOverruns;
+    monsterThinkOverruns += other.monsterThinkOverruns;
+}
+
+namespace {
+
+// 工作线程私有上下文，按缓存行对齐避免伪共享
+struct alignas(64) WorkerContext {
+    std::vector<PairingStats> stats;
+
+    // 同一种子的多组对阵共用一张地图，避免重复生成
+    int cachedSeedIndex;
+    GameMap cachedMap;
+
+    WorkerContext() : cachedSeedIndex(-1), cachedMap(0, 0) {}
+};
+
+} // namespace
+
+TournamentRunner::TournamentRunner(const TournamentConfig &tournamentConfig) : config(tournamentConfig) {}
+
+void TournamentRunner::addPacmanAgent(const std::string &name, const AgentFactory &factory) {
+    pacmanAgents.emplace_back(name, factory);
+}
+
+void TournamentRunner::addMonsterAgent(const std::string &name, const AgentFactory &factory) {
+    monsterAgents.emplace_back(name, factory);
+}
+
+TournamentResult TournamentRunner::run() {
+    TournamentResult result;
+
+    // 未注册时使用内置参考 AI
+    if (pacmanAgents.empty()) addPacmanAgent("random", defaultPacmanFactory());
+    if (monsterAgents.empty()) addMonsterAgent("random", defaultMonsterFactory());
+
+    int pairingCount = static_cast<int>(pacmanAgents.size() * monsterAgents.size());
+    for (const auto &pacmanAgent : pacmanAgents) {
+        for (const auto &monsterAgent : monsterAgents) {
+            PairingStats stats;
+            stats.pacmanAgent = pacmanAgent.name;
+            stats.monsterAgent = monsterAgent.name;
+            result.pairings.push_back(stats);
+        }
+    }
+
+    ThreadPool pool(config.threadCount);
+    int threadCount = pool.getThreadCount();
+    result.threadCount = threadCount;
+
+    std::vector<WorkerContext> contexts(threadCount);
+    for (auto &context : contexts) {
+        context.stats = result.pairings;
+    }
+
+    // 任务按 (种子, 对阵) 顺序编号，切成小块提交；块数远多于线程数，由工作窃取平衡负载
+    long long jobCount = static_cast<long long>(config.seedCount) * pairingCount;
+    long long chunkSize = std::max(1LL, jobCount / (static_cast<long long>(threadCount) * 16));
+
+    auto runJobs = [this, &contexts, pairingCount](long long begin, long long end) {
+        WorkerContext &context = contexts[ThreadPool::currentWorkerIndex()];
+
+        for (long long job = begin; job < end; ++job) {
+            int seedIndex = static_cast<int>(job / pairingCount);
+            int pairingIndex = static_cast<int>(job % pairingCount);
+            const TournamentAgent &pacmanAgent = pacmanAgents[pairingIndex / monsterAgents.size()];
+            const TournamentAgent &monsterAgent = monsterAgents[pairingIndex % monsterAgents.size()];
+
+            // 同一张地图上的各组对阵使用相同的对局种子，出生点和 AI 种子也相同
+            MatchSeeds seeds =
+                deriveMatchSeeds(config.baseSeed + static_cast<uint64_t>(seedIndex), 1 + config.match.monsterCount);
+            TraceSpan jobSpan("job", "tournament", "seed_index", seedIndex);
+            if (context.cachedSeedIndex != seedIndex) {
+                TraceSpan mapSpan("loadMap", "tournament", "seed_index", seedIndex);
+                context.cachedMap = loadMatchMap(config.match, seeds, config.mapPack);
+                context.cachedSeedIndex = seedIndex;
+            }
+
+            auto gameLoop =
+                createMatch(context.cachedMap, config.match, seeds, pacmanAgent.factory, monsterAgent.factory);
+            if (!gameLoop) {
+                context.stats[pairingIndex].failedSetups++;
+                continue;
+            }
+
+            context.stats[pairingIndex].addResult(runMatch(*gameLoop, config.match.maxTurns));
+        }
+    };
+
+    auto startTime = std::chrono::steady_clock::now();
+
+    for (long long begin = 0; begin < jobCount; begin += chunkSize) {
+        long long end = std::min(jobCount, begin + chunkSize);
+        pool.submit([runJobs, begin, end] { runJobs(begin, end); });
+    }
+    pool.waitIdle();
+
+    result.elapsedSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    // 所有工作线程结束后再合并统计
+    for (const auto &context : contexts) {
+        for (int i = 0; i < pairingCount; ++i) {
+            result.pairings[i].merge(context.stats[i]);
+        }
+    }
+    for (const auto &stats : result.pairings) {
+        result.totalMatches += stats.matches;
+        result.totalTurns += stats.totalTurns;
+    }
+
+    return result;
+}
@@ -1,15 +1,35 @@
 #include "../../include/turn_based_game_loop.h"
+#include "../../include/profile_clock.h"
+#include "../../include/thread_pool.h"
+#include "../../include/trace_recorder.h"
+#include <algorithm>
+#include <chrono>
 
 TurnBasedGameLoop::TurnBasedGameLoop(const GameMap &map, const std::vector<Character> &characters)
     : gameState(map, characters), pacmanVisibilitySystem(GameConfig::PACMAN_VISIBILITY_RADIUS),
-      monsterVisibilitySystem(GameConfig::MONSTER_VISIBILITY_RADIUS), isRunning(false), currentTurn(0) {
+      monsterVisibilitySystem(GameConfig::MONSTER_VISIBILITY_RADIUS), replayRecorder(nullptr),
+      profiler(nullptr), decisionPool(nullptr), thinkTimeMs(0), runningDecisions(0), isRunning(false), currentTurn(0) {
 
     // 为每个角色初始化AI代理槽位
     aiAgents.resize(characters.size());
 }
 
+TurnBasedGameLoop::~TurnBasedGameLoop() {
+    {
+        std::lock_guard<std::mutex> lock(slotMutex);
+        for (auto &slot : agentSlots) {
+            if (slot->thinking) {
+                slot->deadline.cancel();
+            }
+        }
+    }
+    waitForRunningDecisions();
+}
+
 void TurnBasedGameLoop::setAIAgent(int characterIndex, std::unique_ptr<AIInterface> ai) {
     if (characterIndex >= 0 && characterIndex < static_cast<int>(aiAgents.size())) {
+        // 被替换的 AI 可能还在执行上一次限时决策
+        waitForRunningDecisions();
         aiAgents[characterIndex] = std::move(ai);
     }
 }
@@ -18,6 +38,13 @@ void TurnBasedGameLoop::setManagementSystem(std::unique_ptr<ManagementInterface>
     managementSystem = std::move(management);
 }
 
+void TurnBasedGameLoop::setReplayRecorder(ReplayRecorder *recorder) {
+    replayRecorder = recorder;
+    if (replayRecorder) {
+        replayRecorder->begin(gameState);
+    }
+}
+
 void TurnBasedGameLoop::start() {
     isRunning = true;
     currentTurn = 0;
@@ -34,48 +61,267 @@ bool TurnBasedGameLoop::executeTurn() {
         return false; // 没有管理系统，无法继续
     }
 
+    // 剖析器未启用时 profiling 在编译期为 false，下面的计时全部被去掉
+    bool profiling = TurnProfiler::ENABLED && profiler != nullptr;
+    uint64_t turnStart = profiling ? ProfileClock::now() : 0;
+    TraceSpan turnSpan("turn", "loop", "turn", currentTurn + 1);
+
     // 第一步：收集所有AI的决策
-    std::vector<Action> actions = collectAIActions();
+    TraceSpan collectSpan("collect", "loop");
+    std::vector<Action> &actions = turnActions;
+    collectAIActions(actions);
+    collectSpan.end();
+    uint64_t collected = profiling ? ProfileClock::now() : 0;
 
     // 第二步：管理系统处理行动
+    TraceSpan managementSpan("management", "loop");
     bool continueGame = managementSystem->processActions(actions, gameState);
+    managementSpan.end();
+    uint64_t managed = profiling ? ProfileClock::now() : 0;
 
     // 第三步：更新回合数
     currentTurn++;
     gameState.incrementTurnCount();
 
     // 记录执行后的状态（用于回放）
+    TraceSpan recordingSpan("recording", "loop");
     controlSystem.recordState(gameState);
+    if (replayRecorder) {
+        replayRecorder->recordTurn(actions, gameState);
+    }
+    recordingSpan.end();
+
+    if (profiling) {
+        uint64_t turnEnd = ProfileClock::now();
+        for (size_t i = 0; i < agentTimings.size(); ++i) {
+            const AgentTiming &timing = agentTimings[i];
+            if (timing.hasView) {
+                profiler->recordAgent(static_cast<int>(i), TurnProfiler::VISIBILITY,
+                                      ProfileClock::toNanos(timing.viewTicks));
+            }
+            if (timing.hasDecision) {
+                profiler->recordAgent(static_cast<int>(i), TurnProfiler::DECISION,
+                                      ProfileClock::toNanos(timing.decisionTicks));
+            }
+        }
+        profiler->record(TurnProfiler::COLLECT, ProfileClock::toNanos(collected - turnStart));
+        profiler->record(TurnProfiler::MANAGEMENT, ProfileClock::toNanos(managed - collected));
+        profiler->record(TurnProfiler::RECORDING, ProfileClock::toNanos(turnEnd - managed));
+        profiler->record(TurnProfiler::TURN, ProfileClock::toNanos(turnEnd - turnStart));
+    }
 
     // 返回游戏是否继续
     return continueGame;
 }
 
-std::vector<Action> TurnBasedGameLoop::collectAIActions() {
-    std::vector<Action> actions;
+void TurnBasedGameLoop::collectAIActions(std::vector<Action> &actions) {
+    size_t characterCount = gameState.getCharacters().size();
+    actions.assign(characterCount, Action{Direction::STAY}); // 默认行动
+    if (observations.size() != characterCount) {
+        observations.resize(characterCount);
+    }
+    if (TurnProfiler::ENABLED && profiler) {
+        agentTimings.assign(characterCount, AgentTiming{0, 0, false, false});
+    }
+
+    if (thinkTimeMs > 0) {
+        collectTimedActions(actions);
+        return;
+    }
+
+    int thinkingAgents = 0;
+    for (size_t i = 0; i < characterCount && i < aiAgents.size(); ++i) {
+        thinkingAgents += aiAgents[i] ? 1 : 0;
+    }
+    if (!decisionPool || thinkingAgents < 2) {
+        for (size_t i = 0; i < characterCount; ++i) {
+            decideAction(i, actions);
+        }
+        return;
+    }
+
+    // 上一回合的帮手任务都已退出时复用同一个批次对象
+    if (!decisionBatch || decisionBatch->helpersInFlight.load(std::memory_order_acquire) != 0) {
+        decisionBatch = std::make_shared<DecisionBatch>();
+    }
+    DecisionBatch &batch = *decisionBatch;
+    batch.count = static_cast<int>(characterCount);
+    batch.nextIndex.store(0);
+    batch.completed.store(0);
+
+    // 调用线程自己也领取任务，帮手数量比决策数少一个即可
+    int helpers = std::min(decisionPool->getThreadCount(), thinkingAgents - 1);
+    for (int h = 0; h < helpers; ++h) {
+        std::shared_ptr<DecisionBatch> shared = decisionBatch;
+        std::vector<Action> *target = &actions;
+        batch.helpersInFlight.fetch_add(1, std::memory_order_relaxed);
+        decisionPool->submit([this, shared, target] {
+            runDecisions(this, *shared, target);
+            shared->helpersInFlight.fetch_sub(1, std::memory_order_release);
+        });
+    }
+    runDecisions(this, batch, &actions);
+
+    std::unique_lock<std::mutex> lock(batch.mutex);
+    batch.finished.wait(lock, [&batch] { return batch.completed.load() == batch.count.load(); });
+}
+
+void TurnBasedGameLoop::decideAction(size_t index, std::vector<Action> &actions) {
+    // 如果有对应的AI代理，获取其决策
+    if (index >= aiAgents.size() || !aiAgents[index]) {
+        return;
+    }
+    const Character &character = gameState.getCharacters()[index];
+
+    // 根据角色类型选择对应的视野系统
+    const VisibilitySystem &visSystem =
+        (character.type == CharacterType::PACMAN) ? pacmanVisibilitySystem : monsterVisibilitySystem;
+
+    bool profiling = TurnProfiler::ENABLED && profiler != nullptr;
+    uint64_t start = profiling ? ProfileClock::now() : 0;
+
+    // 计算可见区域
+    TraceSpan viewSpan("view", "agent", "agent", static_cast<long long>(index));
+    visSystem.calculateVisibleArea(character.position, gameState, observations[index]);
+    viewSpan.end();
+    uint64_t viewed = profiling ? ProfileClock::now() : 0;
+
+    // 获取AI决策
+    TraceSpan decisionSpan("decision", "agent", "agent", static_cast<long long>(index));
+    actions[index] = aiAgents[index]->getAction(observations[index]);
+    decisionSpan.end();
+
+    if (profiling) {
+        AgentTiming &timing = agentTimings[index];
+        timing.viewTicks = viewed - start;
+        timing.decisionTicks = ProfileClock::now() - viewed;
+        timing.hasView = true;
+        timing.hasDecision = true;
+    }
+}
+
+void TurnBasedGameLoop::runDecisions(TurnBasedGameLoop *loop, DecisionBatch &batch, std::vector<Action> *actions) {
+    for (;;) {
+        int index = batch.nextIndex.fetch_add(1);
+        if (index >= batch.count) {
+            return;
+        }
+        loop->decideAction(static_cast<size_t>(index), *actions);
+        if (batch.completed.fetch_add(1) + 1 == batch.count) {
+            // 在锁内通知，避免等待方检查条件后、进入等待前错过通知
+            std::lock_guard<std::mutex> lock(batch.mutex);
+            batch.finished.notify_all();
+        }
+    }
+}
+
+void TurnBasedGameLoop::collectTimedActions(std::vector<Action> &actions) {
     const auto &characters = gameState.getCharacters();
+    size_t agentCount = std::min(characters.size(), aiAgents.size());
+    while (agentSlots.size() < agentCount) {
+        agentSlots.push_back(std::make_unique<AgentSlot>());
+    }
 
-    for (size_t i = 0; i < characters.size(); ++i) {
-        Action action{Direction::STAY}; // 默认行动
+    ThreadPool *pool = decisionPool;
+    if (!pool) {
+        // 每个 AI 最多同时有一个决策在运行，线程数等于 AI 数量时卡住的 AI 不会挤占其他 AI
+        if (!watchdogPool || watchdogPool->getThreadCount() < static_cast<int>(agentCount)) {
+            waitForRunningDecisions();
+            watchdogPool = std::make_unique<ThreadPool>(static_cast<int>(std::max<size_t>(agentCount, 1)));
+        }
+        pool = watchdogPool.get();
+    }
 
-        // 如果有对应的AI代理，获取其决策
-        if (i < aiAgents.size() && aiAgents[i]) {
-            // 根据角色类型选择对应的视野系统
-            VisibilitySystem &visSystem =
-                (characters[i].type == CharacterType::PACMAN) ? pacmanVisibilitySystem : monsterVisibilitySystem;
+    bool profiling = TurnProfiler::ENABLED && profiler != nullptr;
 
-            // 计算可见区域
-            VisibleArea visibleArea =
-                visSystem.calculateVisibleArea(characters[i].position, gameState.getMap(), characters);
+    // 视野在调用线程上计算（结果确定且耗时很短），截止时间从提交决策前开始计算
+    DecisionDeadline::Clock::time_point deadline =
+        DecisionDeadline::Clock::now() + std::chrono::milliseconds(thinkTimeMs);
+    submittedAgents.clear();
+    for (size_t i = 0; i < agentCount; ++i) {
+        if (!aiAgents[i]) {
+            continue;
+        }
+        AgentSlot &slot = *agentSlots[i];
+        {
+            std::lock_guard<std::mutex> lock(slotMutex);
+            if (slot.thinking) {
+                slot.overruns++; // 上一次决策还没有返回，本回合直接按 STAY 处理
+                continue;
+            }
+            slot.thinking = true;
+            slot.answered = false;
+            runningDecisions++;
+        }
 
-            // 获取AI决策
-            action = aiAgents[i]->getAction(visibleArea);
+        const VisibilitySystem &visSystem =
+            (characters[i].type == CharacterType::PACMAN) ? pacmanVisibilitySystem : monsterVisibilitySystem;
+        uint64_t viewStart = profiling ? ProfileClock::now() : 0;
+        TraceSpan viewSpan("view", "agent", "agent", static_cast<long long>(i));
+        visSystem.calculateVisibleArea(characters[i].position, gameState, slot.view);
+        viewSpan.end();
+        if (profiling) {
+            agentTimings[i].viewTicks = ProfileClock::now() - viewStart;
+            agentTimings[i].hasView = true;
         }
+        slot.deadline.reset(deadline);
+        submittedAgents.push_back(static_cast<int>(i));
 
-        actions.push_back(action);
+        AgentSlot *target = &slot;
+        AIInterface *agent = aiAgents[i].get();
+        long long agentIndex = static_cast<long long>(i);
+        pool->submit([this, target, agent, profiling, agentIndex] {
+            uint64_t started = profiling ? ProfileClock::now() : 0;
+            TraceSpan decisionSpan("decision", "agent", "agent", agentIndex);
+            Action action = agent->getActionWithDeadline(target->view, target->deadline);
+            decisionSpan.end();
+            uint64_t finished = profiling ? ProfileClock::now() : 0;
+            std::lock_guard<std::mutex> lock(slotMutex);
+            target->result = action;
+            target->decisionTicks = finished - started;
+            target->answered = true;
+            target->thinking = false;
+            runningDecisions--;
+            slotChanged.notify_all();
+        });
     }
 
-    return actions;
+    // 看门狗：最多等到截止时间，未返回的决策保持 STAY
+    std::unique_lock<std::mutex> lock(slotMutex);
+    slotChanged.wait_until(lock, deadline, [this] {
+        for (int index : submittedAgents) {
+            if (!agentSlots[index]->answered) {
+                return false;
+            }
+        }
+        return true;
+    });
+    for (int index : submittedAgents) {
+        AgentSlot &slot = *agentSlots[index];
+        if (slot.answered) {
+            actions[index] = slot.result;
+            if (profiling) {
+                // 超时的决策不计入决策耗时，只计入超时次数
+                agentTimings[index].decisionTicks = slot.decisionTicks;
+                agentTimings[index].hasDecision = true;
+            }
+        } else {
+            slot.deadline.cancel();
+            slot.overruns++;
+        }
+    }
+}
+
+void TurnBasedGameLoop::waitForRunningDecisions() {
+    std::unique_lock<std::mutex> lock(slotMutex);
+    slotChanged.wait(lock, [this] { return runningDecisions == 0; });
+}
+
+int TurnBasedGameLoop::getThinkOverruns(int characterIndex) const {
+    if (characterIndex < 0 || characterIndex >= static_cast<int>(agentSlots.size())) {
+        return 0;
+    }
+    return agentSlots[characterIndex]->overruns;
 }
 
 void TurnBasedGameLoop::setGameState(const GameStateManager &state) { gameState = state; }
@@ -0,0 +1,133 @@
+#include "../../include/turn_profiler.h"
+#include "../../include/profile_clock.h"
+#include <cinttypes>
+#include <cstdio>
+#include <fstream>
+
+namespace {
+
+void appendCsvRow(std::string &out, const std::string &scope, const char *phase, const LatencyHistogram &histogram) {
+    char line[256];
+    std::snprintf(line, sizeof(line),
+                  "%s,%s,%" PRIu64 ",%" PRIu64 ",%.1f,%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 "\n",
+                  scope.c_str(), phase, histogram.getCount(), histogram.getMin(), histogram.getMean(),
+                  histogram.percentile(0.5), histogram.percentile(0.9), histogram.percentile(0.99),
+                  histogram.percentile(0.999), histogram.getMax());
+    out += line;
+}
+
+void appendJsonObject(std::string &out, const LatencyHistogram &histogram) {
+    char text[256];
+    std::snprintf(text, sizeof(text),
+                  "{\"count\": %" PRIu64 ", \"min_ns\": %" PRIu64 ", \"mean_ns\": %.1f, \"p50_ns\": %" PRIu64
+                  ", \"p90_ns\": %" PRIu64 ", \"p99_ns\": %" PRIu64 ", \"p999_ns\": %" PRIu64 ", \"max_ns\": %" PRIu64
+                  "}",
+                  histogram.getCount(), histogram.getMin(), histogram.getMean(), histogram.percentile(0.5),
+                  histogram.percentile(0.9), histogram.percentile(0.99), histogram.percentile(0.999),
+                  histogram.getMax());
+    out += text;
+}
+
+} // namespace
+
+const char *TurnProfiler::phaseName(Phase phase) {
+    switch (phase) {
+    case VISIBILITY:
+        return "visibility";
+    case DECISION:
+        return "decision";
+    case COLLECT:
+        return "collect";
+    case MANAGEMENT:
+        return "management";
+    case RECORDING:
+        return "recording";
+    case TURN:
+        return "turn";
+    default:
+        return "unknown";
+    }
+}
+
+void TurnProfiler::recordAgent(int agent, Phase phase, uint64_t nanos) {
+    if (agent >= static_cast<int>(agentDecision.size())) {
+        agentVisibility.resize(static_cast<size_t>(agent) + 1);
+        agentDecision.resize(static_cast<size_t>(agent) + 1);
+    }
+    phases[phase].record(nanos);
+    if (phase == VISIBILITY) {
+        agentVisibility[agent].record(nanos);
+    } else {
+        agentDecision[agent].record(nanos);
+    }
+}
+
+void TurnProfiler::merge(const TurnProfiler &other) {
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        phases[p].merge(other.phases[p]);
+    }
+    if (other.agentDecision.size() > agentDecision.size()) {
+        agentVisibility.resize(other.agentVisibility.size());
+        agentDecision.resize(other.agentDecision.size());
+    }
+    for (size_t i = 0; i < other.agentDecision.size(); ++i) {
+        agentVisibility[i].merge(other.agentVisibility[i]);
+        agentDecision[i].merge(other.agentDecision[i]);
+    }
+}
+
+void TurnProfiler::reset() {
+    for (auto &histogram : phases) {
+        histogram.reset();
+    }
+    agentVisibility.clear();
+    agentDecision.clear();
+}
+
+std::string TurnProfiler::toCsv() const {
+    std::string out = "scope,phase,count,min_ns,mean_ns,p50_ns,p90_ns,p99_ns,p999_ns,max_ns\n";
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        appendCsvRow(out, "turn", phaseName(static_cast<Phase>(p)), phases[p]);
+    }
+    for (int i = 0; i < getAgentCount(); ++i) {
+        std::string scope = "agent" + std::to_string(i);
+        appendCsvRow(out, scope, phaseName(VISIBILITY), agentVisibility[i]);
+        appendCsvRow(out, scope, phaseName(DECISION), agentDecision[i]);
+    }
+    return out;
+}
+
+std::string TurnProfiler::toJson() const {
+    std::string out = "{\n  \"clock\": \"";
+    out += ProfileClock::source();
+    out += "\",\n  \"turns\": " + std::to_string(getTurnCount()) + ",\n  \"phases\": {";
+    for (int p = 0; p < PHASE_COUNT; ++p) {
+        out += p == 0 ? "\n" : ",\n";
+        out += "    \"";
+        out += phaseName(static_cast<Phase>(p));
+        out += "\": ";
+        appendJsonObject(out, phases[p]);
+    }
+    out += "\n  },\n  \"agents\": [";
+    for (int i = 0; i < getAgentCount(); ++i) {
+        out += i == 0 ? "\n" : ",\n";
+        out += "    {\"index\": " + std::to_string(i) + ", \"visibility\": ";
+        appendJsonObject(out, agentVisibility[i]);
+        out += ", \"decision\": ";
+        appendJsonObject(out, agentDecision[i]);
+        out += "}";
+    }
+    out += getAgentCount() > 0 ? "\n  ]\n}\n" : "]\n}\n";
+    return out;
+}
+
+bool TurnProfiler::writeFile(const std::string &path) const {
+    bool csv = path.size() >= 4 && path.compare(path.size() - 4, 4, ".csv") == 0;
+    std::string text = csv ? toCsv() : toJson();
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    file.write(text.data(), static_cast<std::streamsize>(text.size()));
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,26 @@
+#include "../../include/visibility_cache.h"
+
+VisibilityCache::VisibilityCache(int r, int w, int h, const std::vector<bool> &cellIsWalkable)
+    : radius(r), width(w), height(h), windowSize(2 * r + 1) {
+    cellSlots.assign(cellIsWalkable.size(), -1);
+    int slotCount = 0;
+    for (size_t i = 0; i < cellIsWalkable.size(); ++i) {
+        if (cellIsWalkable[i]) {
+            cellSlots[i] = slotCount++;
+        }
+    }
+    masks.assign(static_cast<size_t>(slotCount) * windowSize, 0);
+}
+
+uint64_t *VisibilityCache::getMutableMasks(int x, int y) {
+    int slot = cellSlots[static_cast<size_t>(y) * width + x];
+    return slot < 0 ? nullptr : masks.data() + static_cast<size_t>(slot) * windowSize;
+}
+
+const uint64_t *VisibilityCache::findMasks(const Position &center) const {
+    if (center.x < 0 || center.x >= width || center.y < 0 || center.y >= height) {
+        return nullptr;
+    }
+    int slot = cellSlots[static_cast<size_t>(center.y) * width + center.x];
+    return slot < 0 ? nullptr : masks.data() + static_cast<size_t>(slot) * windowSize;
+}
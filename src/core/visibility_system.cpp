@@ -1,46 +1,20 @@
 #include "../../include/visibility_system.h"
+#include "../../include/bit_ops.h"
+#include "../../include/thread_pool.h"
+#include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
 
-VisibilitySystem::VisibilitySystem(int radius) : visibilityRadius(radius) {}
+namespace {
 
-VisibleArea VisibilitySystem::calculateVisibleArea(const Position &center, const GameMap &map,
-                                                   const std::vector<Character> &characters) const {
-    int size = 2 * visibilityRadius + 1;
-    VisibleArea visibleArea(size, size);
-
-    // 遍历可见区域范围内的所有位置
-    for (int dy = -visibilityRadius; dy <= visibilityRadius; ++dy) {
-        for (int dx = -visibilityRadius; dx <= visibilityRadius; ++dx) {
-            Position targetPos(center.x + dx, center.y + dy);
-
-            // 检查曼哈顿距离
-            if (manhattanDistance(center, targetPos) > visibilityRadius) {
-                visibleArea.setCell(dx + visibilityRadius, dy + visibilityRadius, VisibleArea::CellContent::UNKNOWN);
-                continue;
-            }
-
-            // 检查是否在地图范围内
-            if (!map.isInBounds(targetPos)) {
-                visibleArea.setCell(dx + visibilityRadius, dy + visibilityRadius, VisibleArea::CellContent::OVERBOUND);
-                continue;
-            }
-
-            // 检查视线是否被阻挡
-            if (!isVisible(center, targetPos, map)) {
-                visibleArea.setCell(dx + visibilityRadius, dy + visibilityRadius, VisibleArea::CellContent::UNKNOWN);
-                continue;
-            }
-
-            // 获取该位置的内容
-            VisibleArea::CellContent content = getCellContent(targetPos, map, characters);
-            visibleArea.setCell(dx + visibilityRadius, dy + visibilityRadius, content);
-        }
-    }
-
-    return visibleArea;
-}
-
-bool VisibilitySystem::isVisible(const Position &from, const Position &to, const GameMap &map) const {
+// 沿 Bresenham 路径依次访问视线需要检查的格子：不含起点和终点的中间点，
+// 以及每次对角移动时的两个相邻格子。isBlocked 返回 true 表示视线被阻挡
+template <typename BlockedFn> bool traceSightLine(const Position &from, const Position &to, BlockedFn isBlocked) {
     // Bresenham's line 算法
     int x0 = from.x, y0 = from.y;
     int x1 = to.x, y1 = to.y;
@@ -61,8 +35,7 @@ bool VisibilitySystem::isVisible(const Position &from, const Position &to, const
 
         // 检查当前点是否是墙（但不检查起点和终点）
         if (!(x == x0 && y == y0) && !(x == x1 && y == y1)) {
-            Position currentPos(x, y);
-            if (map.isWall(currentPos)) {
+            if (isBlocked(x, y)) {
                 return false; // 被墙阻挡
             }
         }
@@ -83,37 +56,15 @@ bool VisibilitySystem::isVisible(const Position &from, const Position &to, const
 
         // 如果是对角移动，检查两个相邻格子是否有墙
         if (x != prev_x && y != prev_y) {
-            // 检查对角移动路径上的两个相邻格子
-            Position adjacent1(x, prev_y);
-            Position adjacent2(prev_x, y);
-
             // 如果任一相邻格子是墙，视线被阻挡
-            if (map.isWall(adjacent1) || map.isWall(adjacent2)) {
+            if (isBlocked(x, prev_y) || isBlocked(prev_x, y)) {
                 return false;
             }
         }
     }
 }
 
-int VisibilitySystem::manhattanDistance(const Position &a, const Position &b) const {
-    return std::abs(a.x - b.x) + std::abs(a.y - b.y);
-}
-
-VisibleArea::CellContent VisibilitySystem::getCellContent(const Position &pos, const GameMap &map,
-                                                          const std::vector<Character> &characters) const {
-    // 首先检查是否有角色在这个位置
-    for (const auto &character : characters) {
-        if (character.position == pos && character.isAlive) {
-            if (character.type == CharacterType::PACMAN) {
-                return VisibleArea::CellContent::PACMAN;
-            } else {
-                return VisibleArea::CellContent::MONSTER;
-            }
-        }
-    }
-
-    // 然后检查地图单元格类型
-    CellType cellType = map.getCell(pos);
+VisibleArea::CellContent toCellContent(CellType cellType) {
     switch (cellType) {
     case CellType::EMPTY:
         return VisibleArea::CellContent::EMPTY;
@@ -125,3 +76,292 @@ VisibleArea::CellContent VisibilitySystem::getCellContent(const Position &pos, c
         return VisibleArea::CellContent::EMPTY;
     }
 }
+
+} // namespace
+
+VisibilitySystem::VisibilitySystem(int radius) : visibilityRadius(radius) {
+    if (radius < 0 || radius > GameConfig::MAX_VISIBILITY_RADIUS) {
+        throw std::invalid_argument("VisibilitySystem: radius must be in [0, MAX_VISIBILITY_RADIUS]");
+    }
+    buildSightTable();
+}
+
+void VisibilitySystem::buildSightTable() {
+    int size = 2 * visibilityRadius + 1;
+    const Position localCenter(visibilityRadius, visibilityRadius);
+    std::vector<uint64_t> rowBits(size);
+    diamondRows.assign(size, 0);
+
+    for (int ty = 0; ty < size; ++ty) {
+        for (int tx = 0; tx < size; ++tx) {
+            if (std::abs(tx - visibilityRadius) + std::abs(ty - visibilityRadius) > visibilityRadius) {
+                continue;
+            }
+
+            // 路径与地图内容无关：把每个会被检查的格子记入掩码，并假装它不是墙让路径走完
+            std::fill(rowBits.begin(), rowBits.end(), 0);
+            traceSightLine(localCenter, Position(tx, ty), [&rowBits](int x, int y) {
+                rowBits[y] |= 1ULL << x;
+                return false;
+            });
+
+            diamondRows[ty] |= 1ULL << tx;
+
+            SightLine line;
+            line.localX = tx;
+            line.localY = ty;
+            line.maskBegin = static_cast<int>(sightMasks.size());
+            for (int row = 0; row < size; ++row) {
+                if (rowBits[row] != 0) {
+                    sightMasks.push_back(SightMask{row, rowBits[row]});
+                }
+            }
+            line.maskCount = static_cast<int>(sightMasks.size()) - line.maskBegin;
+            sightLines.push_back(line);
+        }
+    }
+}
+
+void VisibilitySystem::computeVisibleMasks(const Position &center, const GameMap &map, uint64_t *visibleRows) const {
+    int size = 2 * visibilityRadius + 1;
+
+    // 一次性取出视野范围内每行的墙壁位，之后的视线检测只做位运算
+    uint64_t wallWindow[2 * GameConfig::MAX_VISIBILITY_RADIUS + 1];
+    for (int row = 0; row < size; ++row) {
+        wallWindow[row] = map.extractWallBits(center.x - visibilityRadius, center.y - visibilityRadius + row, size);
+        visibleRows[row] = 0;
+    }
+
+    for (const SightLine &line : sightLines) {
+        // 检查是否在地图范围内
+        if (!map.isInBounds(center.x + line.localX - visibilityRadius, center.y + line.localY - visibilityRadius)) {
+            continue;
+        }
+
+        // 检查视线是否被阻挡：依赖的格子中只要有一个是墙就看不见
+        uint64_t blocked = 0;
+        const SightMask *masks = sightMasks.data() + line.maskBegin;
+        for (int i = 0; i < line.maskCount; ++i) {
+            blocked |= wallWindow[masks[i].row] & masks[i].bits;
+        }
+        if (blocked == 0) {
+            visibleRows[line.localY] |= 1ULL << line.localX;
+        }
+    }
+}
+
+void VisibilitySystem::fillVisibleArea(VisibleArea &visibleArea, const Position &center, const uint64_t *visibleRows,
+                                       const GameMap &map, const std::vector<Character> &characters,
+                                       const OccupancyGrid *occupancy) const {
+    int size = 2 * visibilityRadius + 1;
+    visibleArea.fill(VisibleArea::CellContent::UNKNOWN);
+
+    // 窗口中落在地图内的列区间 [firstColumn, lastColumn)
+    int firstColumn = std::max(0, visibilityRadius - center.x);
+    int lastColumn = std::min(size, map.getWidth() + visibilityRadius - center.x);
+    uint64_t inBoundsColumns =
+        firstColumn < lastColumn ? BitOps::lowMask(lastColumn) & ~BitOps::lowMask(firstColumn) : 0;
+
+    for (int row = 0; row < size; ++row) {
+        int y = center.y - visibilityRadius + row;
+        bool rowInBounds = y >= 0 && y < map.getHeight();
+
+        uint64_t outside = diamondRows[row] & ~(rowInBounds ? inBoundsColumns : 0);
+        while (outside != 0) {
+            visibleArea.setCell(BitOps::lowestSetBit(outside), row, VisibleArea::CellContent::OVERBOUND);
+            outside &= outside - 1;
+        }
+
+        uint64_t visible = visibleRows[row];
+        while (visible != 0) {
+            int column = BitOps::lowestSetBit(visible);
+            Position targetPos(center.x - visibilityRadius + column, y);
+            visibleArea.setCell(column, row, getCellContent(targetPos, map, characters, occupancy));
+            visible &= visible - 1;
+        }
+    }
+}
+
+void VisibilitySystem::buildCache(GameMap &map, ThreadPool *pool) const {
+    int width = map.getWidth();
+    int height = map.getHeight();
+    std::vector<bool> walkable(static_cast<size_t>(width) * height);
+    for (int y = 0; y < height; ++y) {
+        const CellType *row = map.getRow(y);
+        for (int x = 0; x < width; ++x) {
+            walkable[static_cast<size_t>(y) * width + x] = row[x] != CellType::WALL;
+        }
+    }
+
+    auto cache = std::make_shared<VisibilityCache>(visibilityRadius, width, height, walkable);
+    const GameMap &source = map;
+    VisibilityCache &target = *cache;
+
+    // 各行的槽位互不重叠，可以无锁并行写入
+    auto buildRows = [this, &source, &target](int beginRow, int endRow) {
+        for (int y = beginRow; y < endRow; ++y) {
+            for (int x = 0; x < source.getWidth(); ++x) {
+                uint64_t *masks = target.getMutableMasks(x, y);
+                if (masks != nullptr) {
+                    computeVisibleMasks(Position(x, y), source, masks);
+                }
+            }
+        }
+    };
+
+    if (pool != nullptr && pool->getThreadCount() > 1) {
+        // 本次构建的行块计数：帮手任务可能在构建结束后才开始运行，因此只通过共享指针持有计数，
+        // 领不到行块时直接退出，不会再碰地图和缓存
+        struct RowBatch {
+            std::atomic<int> nextChunk;
+            std::atomic<int> completed;
+            int chunkCount;
+            int chunkRows;
+            std::mutex mutex;
+            std::condition_variable finished;
+
+            RowBatch() : nextChunk(0), completed(0), chunkCount(0), chunkRows(1) {}
+        };
+        auto batch = std::make_shared<RowBatch>();
+        batch->chunkRows = std::max(1, height / (pool->getThreadCount() * 4));
+        batch->chunkCount = (height + batch->chunkRows - 1) / batch->chunkRows;
+
+        auto runChunks = [buildRows, height](RowBatch &rows) {
+            for (;;) {
+                int chunk = rows.nextChunk.fetch_add(1);
+                if (chunk >= rows.chunkCount) {
+                    return;
+                }
+                int beginRow = chunk * rows.chunkRows;
+                buildRows(beginRow, std::min(height, beginRow + rows.chunkRows));
+                if (rows.completed.fetch_add(1) + 1 == rows.chunkCount) {
+                    std::lock_guard<std::mutex> lock(rows.mutex);
+                    rows.finished.notify_all();
+                }
+            }
+        };
+
+        // 调用线程自己也领取行块，帮手数量比行块数少一个即可
+        int helpers = std::min(pool->getThreadCount(), batch->chunkCount - 1);
+        for (int h = 0; h < helpers; ++h) {
+            pool->submit([runChunks, batch] { runChunks(*batch); });
+        }
+        runChunks(*batch);
+
+        std::unique_lock<std::mutex> lock(batch->mutex);
+        batch->finished.wait(lock, [&batch] { return batch->completed.load() == batch->chunkCount; });
+    } else {
+        buildRows(0, height);
+    }
+
+    map.attachVisibilityCache(std::move(cache));
+}
+
+VisibleArea VisibilitySystem::calculateVisibleArea(const Position &center, const GameMap &map,
+                                                   const std::vector<Character> &characters) const {
+    VisibleArea visibleArea;
+    computeVisibleArea(center, map, characters, nullptr, visibleArea);
+    return visibleArea;
+}
+
+VisibleArea VisibilitySystem::calculateVisibleArea(const Position &center, const GameStateManager &gameState) const {
+    VisibleArea visibleArea;
+    calculateVisibleArea(center, gameState, visibleArea);
+    return visibleArea;
+}
+
+void VisibilitySystem::calculateVisibleArea(const Position &center, const GameStateManager &gameState,
+                                            VisibleArea &visibleArea) const {
+    computeVisibleArea(center, gameState.getMap(), gameState.getCharacters(), &gameState.getOccupancy(), visibleArea);
+}
+
+void VisibilitySystem::computeVisibleArea(const Position &center, const GameMap &map,
+                                          const std::vector<Character> &characters, const OccupancyGrid *occupancy,
+                                          VisibleArea &visibleArea) const {
+    int size = 2 * visibilityRadius + 1;
+    visibleArea.resize(size, size);
+
+    const VisibilityCache *cache = map.findVisibilityCache(visibilityRadius);
+    const uint64_t *cachedRows = cache != nullptr ? cache->findMasks(center) : nullptr;
+    if (cachedRows != nullptr) {
+        fillVisibleArea(visibleArea, center, cachedRows, map, characters, occupancy);
+    } else {
+        // 没有缓存，或中心在墙上、界外（缓存只覆盖可走格子）
+        uint64_t visibleRows[2 * GameConfig::MAX_VISIBILITY_RADIUS + 1];
+        computeVisibleMasks(center, map, visibleRows);
+        fillVisibleArea(visibleArea, center, visibleRows, map, characters, occupancy);
+    }
+}
+
+VisibleArea VisibilitySystem::calculateVisibleAreaReference(const Position &center, const GameMap &map,
+                                                            const std::vector<Character> &characters) const {
+    int size = 2 * visibilityRadius + 1;
+    VisibleArea visibleArea(size, size);
+
+    // 遍历可见区域范围内的所有位置
+    for (int dy = -visibilityRadius; dy <= visibilityRadius; ++dy) {
+        for (int dx = -visibilityRadius; dx <= visibilityRadius; ++dx) {
+            Position targetPos(center.x + dx, center.y + dy);
+
+            // 检查曼哈顿距离
+            if (manhattanDistance(center, targetPos) > visibilityRadius) {
+                visibleArea.setCell(dx + visibilityRadius, dy + visibilityRadius, VisibleArea::CellContent::UNKNOWN);
+                continue;
+            }
+
+            // 检查是否在地图范围内
+            if (!map.isInBounds(targetPos)) {
+                visibleArea.setCell(dx + visibilityRadius, dy + visibilityRadius, VisibleArea::CellContent::OVERBOUND);
+                continue;
+            }
+
+            // 检查视线是否被阻挡
+            if (!isVisible(center, targetPos, map)) {
+                visibleArea.setCell(dx + visibilityRadius, dy + visibilityRadius, VisibleArea::CellContent::UNKNOWN);
+                continue;
+            }
+
+            // 获取该位置的内容
+            VisibleArea::CellContent content = getCellContent(targetPos, map, characters);
+            visibleArea.setCell(dx + visibilityRadius, dy + visibilityRadius, content);
+        }
+    }
+
+    return visibleArea;
+}
+
+bool VisibilitySystem::isVisible(const Position &from, const Position &to, const GameMap &map) const {
+    return traceSightLine(from, to, [&map](int x, int y) { return map.isWall(Position(x, y)); });
+}
+
+int VisibilitySystem::manhattanDistance(const Position &a, const Position &b) const {
+    return std::abs(a.x - b.x) + std::abs(a.y - b.y);
+}
+
+VisibleArea::CellContent VisibilitySystem::getCellContent(const Position &pos, const GameMap &map,
+                                                          const std::vector<Character> &characters,
+                                                          const OccupancyGrid *occupancy) const {
+    // 首先检查是否有角色在这个位置（多个角色重叠时取列表中靠前的存活角色）
+    const Character *occupant = nullptr;
+    if (occupancy != nullptr) {
+        int index = occupancy->findAlive(pos, characters);
+        occupant = index >= 0 ? &characters[index] : nullptr;
+    } else {
+        for (const auto &character : characters) {
+            if (character.position == pos && character.isAlive) {
+                occupant = &character;
+                break;
+            }
+        }
+    }
+    if (occupant != nullptr) {
+        if (occupant->type == CharacterType::PACMAN) {
+            return VisibleArea::CellContent::PACMAN;
+        } else {
+            return VisibleArea::CellContent::MONSTER;
+        }
+    }
+
+    // 然后检查地图单元格类型
+    return toCellContent(map.getCell(pos));
+}
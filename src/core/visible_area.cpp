@@ -1,21 +1,52 @@
 #include "../../include/visible_area.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
 
-VisibleArea::VisibleArea(int w, int h) : width(w), height(h), centerPosition(w / 2, h / 2) {
-    grid.resize(height);
-    for (int y = 0; y < height; ++y) {
-        grid[y].resize(width, CellContent::EMPTY);
+VisibleArea::VisibleArea() : width(0), height(0), centerPosition(0, 0) {}
+
+VisibleArea::VisibleArea(int w, int h) : width(0), height(0) {
+    resize(w, h);
+    fill(CellContent::EMPTY);
+}
+
+VisibleArea::VisibleArea(const VisibleArea &other)
+    : width(other.width), height(other.height), centerPosition(other.centerPosition) {
+    std::memcpy(cells, other.cells, static_cast<size_t>(width) * height);
+}
+
+VisibleArea &VisibleArea::operator=(const VisibleArea &other) {
+    if (this != &other) {
+        width = other.width;
+        height = other.height;
+        centerPosition = other.centerPosition;
+        std::memcpy(cells, other.cells, static_cast<size_t>(width) * height);
     }
+    return *this;
+}
+
+void VisibleArea::resize(int w, int h) {
+    if (w < 0 || w > MAX_SIZE || h < 0 || h > MAX_SIZE) {
+        throw std::invalid_argument("VisibleArea: size must be in [0, MAX_SIZE]");
+    }
+    width = w;
+    height = h;
+    centerPosition = Position(width / 2, height / 2);
 }
 
 VisibleArea::CellContent VisibleArea::getCell(int x, int y) const {
     if (x >= 0 && x < width && y >= 0 && y < height) {
-        return grid[y][x];
+        return cells[y * width + x];
     }
     return CellContent::WALL;
 }
 
 void VisibleArea::setCell(int x, int y, CellContent content) {
     if (x >= 0 && x < width && y >= 0 && y < height) {
-        grid[y][x] = content;
+        cells[y * width + x] = content;
     }
 }
+
+void VisibleArea::fill(CellContent content) {
+    std::fill(cells, cells + width * height, content);
+}
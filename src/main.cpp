@@ -1,17 +1,22 @@
 #include "../include/config.h"
 #include "../include/game_map.h"
-#include "../include/management_system.h"
+#include "../include/match_runner.h"
+#include "../include/match_seed.h"
 #include "../include/monster_ai.h"
 #include "../include/pacman_ai.h"
-#include "../include/random_map_generator.h"
 #include "../include/renderer.h"
+#include "../include/thread_pool.h"
+#include "../include/trace_recorder.h"
 #include "../include/turn_based_game_loop.h"
 #include "../include/unicode_helper.h"
-#include <algorithm>
+#include <cstdint>
 #include <memory>
 #include <random>
+#include <string>
 #include <windows.h>
 
+#include <shellapi.h> // CommandLineToArgvW，依赖 windows.h 中的类型
+
 // 全局变量
 std::unique_ptr<TurnBasedGameLoop> gameLoop;
 std::unique_ptr<Renderer> renderer;
@@ -19,6 +24,14 @@ HWND g_hwnd = nullptr;
 bool gameRunning = true;
 int frameCounter = 0;
 const int FRAMES_PER_TURN = 30; // 每30帧执行一个回合（约0.5秒一回合）
+std::unique_ptr<TraceRecorder> traceRecorder; // 命令行指定 --trace FILE 时记录时间线，退出时写出
+std::string traceFile;
+bool visibilityCache = false; // 命令行指定 --visibility-cache 时开局预计算视野缓存
+bool fixedSeed = false;       // 命令行指定 --seed N 时用 N 作为对局种子，否则随机选取
+uint64_t matchSeedOption = 0;
+
+// 解析命令行 [--visibility-cache] [--trace FILE] [--seed N]
+bool ParseCommandLine(std::wstring &error);
 
 // 窗口过程函数
 LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam);
@@ -32,7 +45,22 @@ void UpdateGame();
 // 游戏渲染
 void RenderGame();
 
-int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine, int nCmdShow) {
+int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR /*lpCmdLine*/, int nCmdShow) {
+    std::wstring commandLineError;
+    if (!ParseCommandLine(commandLineError)) {
+        std::wstring message =
+            commandLineError + L"\n\nUsage: pacman_game [--visibility-cache] [--trace FILE] [--seed N]";
+        MessageBoxW(nullptr, message.c_str(), L"Command Line Error", MB_OK | MB_ICONERROR);
+        return 1;
+    }
+
+    // --trace FILE：记录每个回合、各阶段和渲染的时间线，退出时写成 Chrome trace-event JSON
+    if (!traceFile.empty()) {
+        traceRecorder = std::make_unique<TraceRecorder>();
+        TraceRecorder::install(traceRecorder.get());
+        traceRecorder->setThreadName("ui");
+    }
+
     // 注册窗口类
     const wchar_t CLASS_NAME[] = L"PacmanGameWindow";
 
@@ -80,9 +108,57 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR lpCmdLine
         DispatchMessage(&msg);
     }
 
+    // 先销毁游戏循环（等待仍在运行的限时决策），再写出时间线
+    gameLoop.reset();
+    if (traceRecorder) {
+        TraceRecorder::install(nullptr);
+        traceRecorder->writeFile(traceFile);
+    }
+
     return 0;
 }
 
+bool ParseCommandLine(std::wstring &error) {
+    // 按 Windows 的规则切分命令行（支持带引号和空格的路径），选项顺序任意
+    int argc = 0;
+    LPWSTR *argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+    if (argv == nullptr) {
+        error = L"Cannot parse command line";
+        return false;
+    }
+
+    bool ok = true;
+    for (int i = 1; i < argc && ok; ++i) {
+        std::wstring arg = argv[i];
+        if (arg == L"--visibility-cache") {
+            visibilityCache = true;
+        } else if (arg == L"--trace") {
+            if (i + 1 < argc && argv[i + 1][0] != L'\0') {
+                traceFile = WideToGbk(argv[++i]);
+            } else {
+                error = L"--trace requires a file name";
+                ok = false;
+            }
+        } else if (arg == L"--seed") {
+            // 与 pacman_sim 的 --seed 相同（见 parseMatchSeed）；非 ASCII 字符一律换成非法字符
+            std::string text;
+            for (const wchar_t *c = i + 1 < argc ? argv[++i] : L""; *c != L'\0'; ++c) {
+                text += *c < 0x80 ? static_cast<char>(*c) : '?';
+            }
+            fixedSeed = parseMatchSeed(text, matchSeedOption);
+            if (!fixedSeed) {
+                error = L"--seed requires a decimal or 0x-prefixed hexadecimal integer";
+                ok = false;
+            }
+        } else {
+            error = L"Unrecognized argument: " + arg;
+            ok = false;
+        }
+    }
+    LocalFree(argv);
+    return ok;
+}
+
 LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam) {
     switch (uMsg) {
     case WM_DESTROY:
@@ -165,75 +241,49 @@ LRESULT CALLBACK WindowProc(HWND hwnd, UINT uMsg, WPARAM wParam, LPARAM lParam)
 }
 
 void InitializeGame(HWND hwnd) {
-    // 生成随机地图
-    RandomMapGenerator mapGenerator(GameConfig::MAP_WIDTH, GameConfig::MAP_HEIGHT, GameConfig::DOT_RATIO);
-    GameMap map = mapGenerator.generateMap();
-
-    // 创建角色
-    std::vector<Character> characters;
-
-    // 手动查找空地位置来放置角色
-    std::vector<Position> validPositions;
-    for (int y = 1; y < map.getHeight() - 1; ++y) {
-        for (int x = 1; x < map.getWidth() - 1; ++x) {
-            Position pos(x, y);
-            if (map.isEmpty(pos)) {
-                validPositions.push_back(pos);
-            }
-        }
+    // 本局唯一的随机来源：地图、出生点和 AI 的种子全部由对局种子派生
+    uint64_t matchSeed = matchSeedOption;
+    if (!fixedSeed) {
+        std::random_device rd;
+        matchSeed = (static_cast<uint64_t>(rd()) << 32) | rd();
     }
 
-    // 检查是否有足够的位置（1个吃豆人 + N个怪物）
-    int totalCharacters = 1 + GameConfig::MONSTER_COUNT;
-    if (validPositions.size() < static_cast<size_t>(totalCharacters)) {
-        std::wstring errorMsg = L"Not enough empty spaces on map. Found: " + std::to_wstring(validPositions.size()) +
-                                L", Required: " + std::to_wstring(totalCharacters);
+    // 在标题栏显示种子，用 --seed 传回即可重现同一局
+    std::wstring title = L"Collaborative Pac-Man - seed " + std::to_wstring(matchSeed);
+    SetWindowTextW(hwnd, title.c_str());
+
+    MatchConfig config;
+    // 随机开局时限制 AI 思考时间，超时按 STAY 处理，过慢的 AI 最多让一个回合等待这么久；
+    // 限时的结果取决于实际耗时，指定 --seed 重现对局时不限时，与 pacman_sim 的默认行为一致
+    config.thinkTimeMs = fixedSeed ? 0 : GameConfig::AI_THINK_TIME_MS;
+    config.visibilityCache = visibilityCache; // 墙壁在对局中不变，指定时开局并行预计算视野缓存
+    MatchSeeds seeds = deriveMatchSeeds(matchSeed, 1 + config.monsterCount);
+
+    std::unique_ptr<ThreadPool> pool;
+    if (config.visibilityCache) {
+        pool = std::make_unique<ThreadPool>();
+    }
+    GameMap map = generateMatchMap(config, seeds, pool.get());
+    pool.reset();
+
+    // 放置角色（1个吃豆人 + N个怪物）并装配 AI 和管理系统
+    AgentFactory pacmanFactory = [](unsigned int seed) -> std::unique_ptr<AIInterface> {
+        return std::make_unique<PacmanAI>(seed);
+    };
+    AgentFactory monsterFactory = [](unsigned int seed) -> std::unique_ptr<AIInterface> {
+        return std::make_unique<MonsterAI>(seed);
+    };
+    gameLoop = createMatch(map, config, seeds, pacmanFactory, monsterFactory);
+
+    // 检查是否有足够的位置
+    if (!gameLoop) {
+        int totalCharacters = 1 + config.monsterCount;
+        std::wstring errorMsg = L"Not enough empty spaces on map. Required: " + std::to_wstring(totalCharacters);
         MessageBoxW(g_hwnd, errorMsg.c_str(), L"Initialization Error", MB_OK | MB_ICONERROR);
         PostQuitMessage(1);
         return;
     }
 
-    // 随机选择位置
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::shuffle(validPositions.begin(), validPositions.end(), gen);
-
-    int posIndex = 0;
-
-    // 创建吃豆人
-    Character pacman;
-    pacman.type = CharacterType::PACMAN;
-    pacman.position = validPositions[posIndex++];
-    pacman.id = 0;
-    characters.push_back(pacman);
-
-    // 创建怪物
-    for (int i = 0; i < GameConfig::MONSTER_COUNT; ++i) {
-        Character monster;
-        monster.type = CharacterType::MONSTER;
-        monster.position = validPositions[posIndex++];
-        monster.id = 1 + i;
-        characters.push_back(monster);
-    }
-
-    // 创建游戏循环
-    gameLoop = std::make_unique<TurnBasedGameLoop>(map, characters);
-
-    // 设置AI代理
-    gameLoop->setAIAgent(0, std::make_unique<PacmanAI>()); // 吃豆人
-    for (int i = 0; i < GameConfig::MONSTER_COUNT; ++i) {
-        gameLoop->setAIAgent(1 + i, std::make_unique<MonsterAI>()); // 怪物
-    }
-
-    // 设置管理系统
-    gameLoop->setManagementSystem(std::make_unique<ManagementSystem>());
-
-    // 启动游戏
-    gameLoop->start();
-
-    // 记录初始状态（第0回合）
-    gameLoop->getControlSystem().recordState(gameLoop->getGameState());
-
     // 创建渲染器
     int horizontalMargin = 40; // 左右各20像素
     int windowWidth = GameConfig::MAP_WIDTH * GameConfig::CELL_SIZE + horizontalMargin;
@@ -277,6 +327,7 @@ void UpdateGame() {
 
 void RenderGame() {
     if (renderer && gameLoop) {
+        TraceSpan renderSpan("render", "ui", "turn", gameLoop->getCurrentTurn());
         renderer->render(gameLoop->getGameState(), gameLoop->getControlSystem());
         renderer->present();
     }
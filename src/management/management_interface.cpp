@@ -26,3 +26,19 @@ Position ManagementInterface::getNewPosition(const Position &currentPos, Directi
 
     return newPos;
 }
+
+int ManagementInterface::findCharacterAt(const GameStateManager &gameState, const Position &pos) const {
+    return gameState.findCharacterAt(pos);
+}
+
+bool ManagementInterface::hasCharacterOfType(const GameStateManager &gameState, const Position &pos,
+                                             CharacterType type) const {
+    const OccupancyGrid &occupancy = gameState.getOccupancy();
+    const std::vector<Character> &characters = gameState.getCharacters();
+    for (int index = occupancy.firstAt(pos); index != -1; index = occupancy.nextAt(index)) {
+        if (characters[index].isAlive && characters[index].type == type) {
+            return true;
+        }
+    }
+    return false;
+}
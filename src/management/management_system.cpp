@@ -1,7 +1,8 @@
 #include "../../include/management_system.h"
 
 bool ManagementSystem::processActions(const std::vector<Action> &actions, GameStateManager &gameState) {
-    auto characters = gameState.getCharacters();
+    // 复制到跨回合复用的缓冲区，容量足够时不分配内存
+    characters = gameState.getCharacters();
 
     // 确保行动数量与角色数量匹配
     if (actions.size() != characters.size()) {
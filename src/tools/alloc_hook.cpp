@@ -0,0 +1,90 @@
+#include "../../include/alloc_counter.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+// 替换全局 operator new/delete，统计堆分配次数和字节数
+// 计数器使用 relaxed 原子操作，多线程下开销只有一次原子加法
+
+namespace {
+std::atomic<uint64_t> g_allocationCount{0};
+std::atomic<uint64_t> g_allocatedBytes{0};
+
+void *countedAlloc(std::size_t size) {
+    g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    g_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+    return std::malloc(size == 0 ? 1 : size);
+}
+
+void *countedAlignedAlloc(std::size_t size, std::size_t alignment) {
+    g_allocationCount.fetch_add(1, std::memory_order_relaxed);
+    g_allocatedBytes.fetch_add(size, std::memory_order_relaxed);
+#ifdef _MSC_VER
+    return _aligned_malloc(size == 0 ? 1 : size, alignment);
+#else
+    // aligned_alloc 要求大小是对齐值的整数倍
+    std::size_t rounded = ((size == 0 ? 1 : size) + alignment - 1) / alignment * alignment;
+    return std::aligned_alloc(alignment, rounded);
+#endif
+}
+
+void alignedFree(void *ptr) {
+#ifdef _MSC_VER
+    _aligned_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+} // namespace
+
+uint64_t AllocCounter::allocationCount() { return g_allocationCount.load(std::memory_order_relaxed); }
+
+uint64_t AllocCounter::allocatedBytes() { return g_allocatedBytes.load(std::memory_order_relaxed); }
+
+void *operator new(std::size_t size) {
+    void *ptr = countedAlloc(size);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void *operator new[](std::size_t size) {
+    void *ptr = countedAlloc(size);
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept { return countedAlloc(size); }
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept { return countedAlloc(size); }
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+    void *ptr = countedAlignedAlloc(size, static_cast<std::size_t>(alignment));
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+    void *ptr = countedAlignedAlloc(size, static_cast<std::size_t>(alignment));
+    if (!ptr) throw std::bad_alloc();
+    return ptr;
+}
+
+void operator delete(void *ptr) noexcept { std::free(ptr); }
+
+void operator delete[](void *ptr) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+void operator delete[](void *ptr, std::size_t) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+
+void operator delete[](void *ptr, const std::nothrow_t &) noexcept { std::free(ptr); }
+
+void operator delete(void *ptr, std::align_val_t) noexcept { alignedFree(ptr); }
+
+void operator delete[](void *ptr, std::align_val_t) noexcept { alignedFree(ptr); }
+
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept { alignedFree(ptr); }
+
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept { alignedFree(ptr); }
@@ -0,0 +1,1931 @@
+#include "../../include/alloc_counter.h"
+#include "../../include/binary_io.h"
+#include "../../include/bit_ops.h"
+#include "../../include/game_control_system.h"
+#include "../../include/latency_histogram.h"
+#include "../../include/management_system.h"
+#include "../../include/map_batch_generator.h"
+#include "../../include/map_connectivity.h"
+#include "../../include/map_pack.h"
+#include "../../include/map_text.h"
+#include "../../include/match_runner.h"
+#include "../../include/match_seed.h"
+#include "../../include/occupancy_grid.h"
+#include "../../include/random_map_generator.h"
+#include "../../include/replay.h"
+#include "../../include/state_codec.h"
+#include "../../include/thread_pool.h"
+#include "../../include/trace_recorder.h"
+#include "../../include/turn_profiler.h"
+#include "../../include/visibility_system.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// 每回合热点路径的微基准测试
+// 用法：pacman_bench [--filter SUBSTR] [--min-time SEC] [--quick] [--verify]
+// 结果以 JSON 输出到标准输出：每项给出 ns/op、allocs/op 和 bytes/op，便于长期跟踪回归
+// --verify 不计时，只做优化实现与参照实现的穷举差分检查，发现不一致时返回非零
+
+namespace {
+
+using BenchParams = std::vector<std::pair<std::string, int>>;
+
+struct BenchOptions {
+    std::string filter;
+    double minTime;
+    bool quick;
+    bool verify;
+
+    BenchOptions() : minTime(0.2), quick(false), verify(false) {}
+};
+
+struct BenchResult {
+    std::string name;
+    BenchParams params;
+    long long iterations;
+    int itemsPerIteration;
+    double nsPerOp;
+    double allocsPerOp;
+    double bytesPerOp;
+};
+
+// 防止编译器把被测代码当作无用代码删除
+volatile uint64_t g_sink = 0;
+
+template <typename T> void consume(const T &value) { g_sink = g_sink + static_cast<uint64_t>(value); }
+
+class BenchRunner {
+  private:
+    BenchOptions options;
+    std::vector<BenchResult> results;
+
+  public:
+    explicit BenchRunner(const BenchOptions &benchOptions) : options(benchOptions) {}
+
+    const BenchOptions &getOptions() const { return options; }
+
+    bool isSelected(const std::string &name) const {
+        return options.filter.empty() || name.find(options.filter) != std::string::npos;
+    }
+
+    // 运行一项基准：fn 每调用一次处理 itemsPerIteration 个操作
+    // 迭代次数翻倍直到单次测量超过 minTime，最后一次测量作为结果
+    template <typename Fn> void run(const std::string &name, const BenchParams &params, int itemsPerIteration, Fn fn) {
+        if (!isSelected(name)) return;
+
+        fn(); // 预热
+
+        long long iterations = 1;
+        while (true) {
+            uint64_t allocsBefore = AllocCounter::allocationCount();
+            uint64_t bytesBefore = AllocCounter::allocatedBytes();
+            auto start = std::chrono::steady_clock::now();
+
+            for (long long i = 0; i < iterations; ++i) {
+                fn();
+            }
+
+            auto end = std::chrono::steady_clock::now();
+            uint64_t allocs = AllocCounter::allocationCount() - allocsBefore;
+            uint64_t bytes = AllocCounter::allocatedBytes() - bytesBefore;
+            double elapsed = std::chrono::duration<double>(end - start).count();
+
+            if (elapsed >= options.minTime || iterations >= (1LL << 40)) {
+                double ops = static_cast<double>(iterations) * itemsPerIteration;
+                BenchResult result;
+                result.name = name;
+                result.params = params;
+                result.iterations = iterations;
+                result.itemsPerIteration = itemsPerIteration;
+                result.nsPerOp = elapsed * 1e9 / ops;
+                result.allocsPerOp = static_cast<double>(allocs) / ops;
+                result.bytesPerOp = static_cast<double>(bytes) / ops;
+                results.push_back(result);
+
+                std::fprintf(stderr, "%-40s %-28s %12.1f ns/op %8.2f allocs/op\n", name.c_str(),
+                             formatParams(params).c_str(), result.nsPerOp, result.allocsPerOp);
+                return;
+            }
+
+            // 按已测得的耗时估算达到 minTime 所需的次数，至少翻倍
+            double scale = elapsed > 0.0 ? options.minTime / elapsed * 1.2 : 10.0;
+            long long next = static_cast<long long>(iterations * scale);
+            iterations = next > iterations * 2 ? next : iterations * 2;
+        }
+    }
+
+    static std::string formatParams(const BenchParams &params) {
+        std::string text;
+        for (const auto &param : params) {
+            if (!text.empty()) text += ' ';
+            text += param.first + "=" + std::to_string(param.second);
+        }
+        return text;
+    }
+
+    void printJson() const {
+        std::printf("{\n  \"context\": {\"min_time_sec\": %.3f, \"quick\": %s, \"popcount_impl\": \"%s\"},\n"
+                    "  \"benchmarks\": [\n",
+                    options.minTime, options.quick ? "true" : "false", BitOps::activeImplementation());
+        for (size_t i = 0; i < results.size(); ++i) {
+            const BenchResult &result = results[i];
+            std::printf("    {\"name\": \"%s\", \"params\": {", result.name.c_str());
+            for (size_t p = 0; p < result.params.size(); ++p) {
+                std::printf("%s\"%s\": %d", p == 0 ? "" : ", ", result.params[p].first.c_str(),
+                            result.params[p].second);
+            }
+            std::printf("}, \"iterations\": %lld, \"items_per_iteration\": %d, \"ns_per_op\": %.3f, "
+                        "\"allocs_per_op\": %.4f, \"bytes_per_op\": %.2f}%s\n",
+                        result.iterations, result.itemsPerIteration, result.nsPerOp, result.allocsPerOp,
+                        result.bytesPerOp, i + 1 < results.size() ? "," : "");
+        }
+        std::printf("  ]\n}\n");
+    }
+};
+
+constexpr uint64_t BENCH_SEED = 20240601;
+
+MatchConfig makeConfig(int size, int agents) {
+    MatchConfig config;
+    config.mapWidth = size;
+    config.mapHeight = size;
+    config.monsterCount = agents - 1;
+    config.visibilityCache = true; // 基准测试的地图都不大，按带缓存的热路径计时
+    return config;
+}
+
+std::vector<Position> walkablePositions(const GameMap &map) {
+    std::vector<Position> positions;
+    for (int y = 0; y < map.getHeight(); ++y) {
+        for (int x = 0; x < map.getWidth(); ++x) {
+            if (!map.isWall(Position(x, y))) {
+                positions.push_back(Position(x, y));
+            }
+        }
+    }
+    return positions;
+}
+
+void benchVisibility(BenchRunner &runner, const std::vector<int> &sizes, const std::vector<int> &agentCounts) {
+    const int radii[] = {GameConfig::PACMAN_VISIBILITY_RADIUS, GameConfig::MONSTER_VISIBILITY_RADIUS};
+
+    for (int size : sizes) {
+        for (int agents : agentCounts) {
+            MatchConfig config = makeConfig(size, agents);
+            MatchSeeds seeds = deriveMatchSeeds(BENCH_SEED, agents);
+            GameMap map = generateMatchMap(config, seeds);
+            std::vector<Character> characters = createMatchCharacters(map, agents - 1, seeds.spawnSeed);
+            if (characters.empty()) continue;
+
+            std::vector<Position> centers = walkablePositions(map);
+            GameMap uncachedMap = map;
+            uncachedMap.dropVisibilityCaches();
+
+            for (int radius : radii) {
+                VisibilitySystem visibility(radius);
+                size_t next = 0;
+                for (int cached = 0; cached <= 1; ++cached) {
+                    const GameMap &target = cached ? map : uncachedMap;
+                    runner.run("visibility.calculateVisibleArea",
+                               {{"radius", radius}, {"size", size}, {"agents", agents}, {"cached", cached}}, 1, [&] {
+                                   VisibleArea area =
+                                       visibility.calculateVisibleArea(centers[next], target, characters);
+                                   next = (next + 1) % centers.size();
+                                   consume(static_cast<int>(area.getCell(radius, radius)));
+                               });
+                }
+                GameStateManager gameState(map, characters);
+                runner.run("visibility.calculateVisibleArea.occupancy",
+                           {{"radius", radius}, {"size", size}, {"agents", agents}}, 1, [&] {
+                               VisibleArea area = visibility.calculateVisibleArea(centers[next], gameState);
+                               next = (next + 1) % centers.size();
+                               consume(static_cast<int>(area.getCell(radius, radius)));
+                           });
+                runner.run("visibility.reference", {{"radius", radius}, {"size", size}, {"agents", agents}}, 1, [&] {
+                    VisibleArea area = visibility.calculateVisibleAreaReference(centers[next], map, characters);
+                    next = (next + 1) % centers.size();
+                    consume(static_cast<int>(area.getCell(radius, radius)));
+                });
+            }
+        }
+    }
+
+    // 视野缓存的构建开销：串行与线程池并行
+    ThreadPool pool;
+    for (int size : sizes) {
+        MatchConfig config = makeConfig(size, 2);
+        config.visibilityCache = false;
+        GameMap map = generateMatchMap(config, deriveMatchSeeds(BENCH_SEED, 2));
+        VisibilitySystem visibility(GameConfig::PACMAN_VISIBILITY_RADIUS);
+        std::vector<int> threadCounts = {1};
+        if (pool.getThreadCount() > 1) threadCounts.push_back(pool.getThreadCount());
+        for (int threads : threadCounts) {
+            runner.run("visibility.buildCache", {{"size", size}, {"threads", threads}}, 1, [&] {
+                visibility.buildCache(map, threads > 1 ? &pool : nullptr);
+                consume(map.findVisibilityCache(GameConfig::PACMAN_VISIBILITY_RADIUS)->getSlotCount());
+            });
+        }
+    }
+}
+
+void benchMap(BenchRunner &runner, const std::vector<int> &sizes) {
+    for (int size : sizes) {
+        MatchConfig config = makeConfig(size, 2);
+        GameMap map = generateMatchMap(config, deriveMatchSeeds(BENCH_SEED, 2));
+        int cells = map.getWidth() * map.getHeight();
+        BenchParams params = {{"size", size}};
+
+        runner.run("map.getCell", params, cells, [&] {
+            int sum = 0;
+            for (int y = 0; y < map.getHeight(); ++y) {
+                for (int x = 0; x < map.getWidth(); ++x) {
+                    sum += static_cast<int>(map.getCell(x, y));
+                }
+            }
+            consume(sum);
+        });
+
+        runner.run("map.countDots", params, 1, [&] { consume(map.countDots()); });
+
+        // 快照：复制整张地图后改动一个格子，写时复制只拷贝被改动的分块
+        std::vector<Position> walkable = walkablePositions(map);
+        size_t next = 0;
+        runner.run("map.snapshotAndWrite", params, 1, [&] {
+            GameMap snapshot = map;
+            snapshot.setCell(walkable[next], CellType::EMPTY);
+            next = (next + 1) % walkable.size();
+            consume(snapshot.getTileCount());
+        });
+
+        runner.run("map.saveToString", params, 1, [&] { consume(map.saveToString().size()); });
+
+        std::string text = map.saveToString();
+        GameMap loaded(0, 0);
+        runner.run("map.loadFromString", params, 1, [&] {
+            loaded.loadFromString(text);
+            consume(loaded.getTotalDots());
+        });
+
+        // 按字节计时，ns/op 的倒数即吞吐量
+        int bytes = static_cast<int>(text.size());
+        std::string buffer;
+        runner.run("map.text.serialize", params, bytes, [&] {
+            MapText::serialize(map, buffer);
+            consume(buffer.size());
+        });
+        runner.run("map.text.parse", params, bytes, [&] { consume(MapText::parse(text, loaded) ? 1 : 0); });
+    }
+}
+
+// 位平面统计：impl=0 逐格扫描单元格数组（对照组），1 可移植 popcount，2 AVX2 popcount
+void benchBitplanes(BenchRunner &runner, const std::vector<int> &sizes) {
+    for (int size : sizes) {
+        // 直接随机填充，避免大尺寸下迷宫生成耗时
+        GameMap map(size, size);
+        std::mt19937 randomEngine(static_cast<unsigned int>(BENCH_SEED));
+        for (int y = 1; y < size - 1; ++y) {
+            for (int x = 1; x < size - 1; ++x) {
+                unsigned int roll = randomEngine() % 10;
+                map.setCell(x, y, roll < 4 ? CellType::WALL : (roll < 7 ? CellType::EMPTY : CellType::DOT));
+            }
+        }
+
+        // 地图按分块存放，位平面内核的基准使用拼接成一整块的豆子位平面
+        std::vector<uint64_t> dotPlane;
+        for (int y = 0; y < size; ++y) {
+            dotPlane.insert(dotPlane.end(), map.getDotBitsRow(y), map.getDotBitsRow(y) + map.getWordsPerRow());
+        }
+        const uint64_t *dotWords = dotPlane.data();
+        size_t wordCount = dotPlane.size();
+
+        runner.run("bitplane.countDots", {{"size", size}, {"impl", 0}}, 1, [&] {
+            int count = 0;
+            for (int y = 0; y < size; ++y) {
+                const CellType *row = map.getRow(y);
+                for (int x = 0; x < size; ++x) {
+                    count += row[x] == CellType::DOT ? 1 : 0;
+                }
+            }
+            consume(count);
+        });
+        runner.run("bitplane.countDots", {{"size", size}, {"impl", 1}}, 1,
+                   [&] { consume(BitOps::popcountPortable(dotWords, wordCount)); });
+        if (BitOps::hasAvx2()) {
+            runner.run("bitplane.countDots", {{"size", size}, {"impl", 2}}, 1,
+                       [&] { consume(BitOps::popcountAvx2(dotWords, wordCount)); });
+        }
+
+        runner.run("bitplane.countEmptyCells", {{"size", size}}, 1, [&] { consume(map.countEmptyCells()); });
+        runner.run("bitplane.validate", {{"size", size}}, 1, [&] { consume(map.validate() ? 1 : 0); });
+
+        MapConnectivity connectivity;
+        runner.run("map.connectivity", {{"size", size}}, 1, [&] {
+            connectivity.analyze(map);
+            consume(connectivity.getComponentCount());
+        });
+    }
+}
+
+void benchManagement(BenchRunner &runner, const std::vector<int> &agentCounts) {
+    for (int agents : agentCounts) {
+        MatchConfig config = makeConfig(GameConfig::MAP_WIDTH * 2 + 1, agents);
+        MatchSeeds seeds = deriveMatchSeeds(BENCH_SEED, agents);
+        GameMap map = generateMatchMap(config, seeds);
+        std::vector<Character> characters = createMatchCharacters(map, agents - 1, seeds.spawnSeed);
+        if (characters.empty()) continue;
+
+        GameStateManager initialState(map, characters);
+        GameStateManager gameState = initialState;
+        ManagementSystem management;
+
+        // 预先生成若干组随机行动，循环使用
+        std::mt19937 randomEngine(seeds.spawnSeed);
+        std::vector<std::vector<Action>> actionSets(64, std::vector<Action>(characters.size()));
+        for (auto &actions : actionSets) {
+            for (auto &action : actions) {
+                action.direction = static_cast<Direction>(randomEngine() % 5);
+            }
+        }
+
+        size_t next = 0;
+        runner.run("management.processActions", {{"agents", agents}}, 1, [&] {
+            if (next == 0) gameState = initialState; // 定期复位，避免角色漂出地图
+            consume(management.processActions(actionSets[next], gameState) ? 1 : 0);
+            next = (next + 1) % actionSets.size();
+        });
+    }
+}
+
+void benchControl(BenchRunner &runner, const std::vector<int> &sizes) {
+    for (int size : sizes) {
+        auto gameLoop = createMatch(makeConfig(size, 2), BENCH_SEED);
+        if (!gameLoop) continue;
+
+        // 复制游戏状态：地图按块共享，占用索引只与角色数有关，耗时不应随地图面积增长
+        runner.run("state.copy", {{"size", size}}, 1, [&] {
+            GameStateManager copy = gameLoop->getGameState();
+            consume(copy.getRemainingDots());
+        });
+
+        GameControlSystem controlSystem;
+        const GameStateManager &gameState = gameLoop->getGameState();
+        runner.run("control.recordState", {{"size", size}}, 1, [&] {
+            controlSystem.recordState(gameState);
+            consume(controlSystem.canUndo() ? 1 : 0);
+        });
+    }
+}
+
+void benchReplay(BenchRunner &runner, const std::vector<int> &sizes) {
+    for (int size : sizes) {
+        auto gameLoop = createMatch(makeConfig(size, 4), BENCH_SEED);
+        if (!gameLoop) continue;
+
+        constexpr int turns = 10000;
+        ReplayRecorder recorder(BENCH_SEED);
+        gameLoop->setReplayRecorder(&recorder);
+        for (int turn = 0; turn < turns; ++turn) {
+            gameLoop->executeTurn();
+        }
+        gameLoop->setReplayRecorder(nullptr);
+
+        ReplayPlayer player;
+        player.loadFromBuffer(recorder.serialize());
+        GameStateManager gameState;
+        std::mt19937 rng(BENCH_SEED);
+        runner.run("replay.seek", {{"size", size}, {"turns", turns}}, 1, [&] {
+            consume(player.seek(static_cast<int>(rng() % (turns + 1)), gameState) ? gameState.getMonsterScore() : 0);
+        });
+    }
+}
+
+void benchSave(BenchRunner &runner, const std::vector<int> &sizes) {
+    for (int size : sizes) {
+        auto gameLoop = createMatch(makeConfig(size, 8), BENCH_SEED);
+        if (!gameLoop) continue;
+        for (int turn = 0; turn < 50; ++turn) gameLoop->executeTurn();
+
+        const GameStateManager &gameState = gameLoop->getGameState();
+        runner.run("save.encode", {{"size", size}}, 1,
+                   [&] { consume(StateCodec::encodeSaveFile(gameState).size()); });
+
+        std::vector<uint8_t> bytes = StateCodec::encodeSaveFile(gameState);
+        GameStateManager loaded;
+        runner.run("save.decode", {{"size", size}}, 1, [&] {
+            consume(StateCodec::decodeSaveFile(bytes.data(), bytes.size(), loaded) ? loaded.getTurnCount() : 0);
+        });
+
+        std::string filename = "pacman_bench_save.tmp";
+        GameControlSystem control;
+        control.saveGame(gameState, filename);
+        runner.run("control.loadGame", {{"size", size}}, 1,
+                   [&] { consume(control.loadGame(loaded, filename) ? loaded.getTurnCount() : 0); });
+        std::remove(filename.c_str());
+    }
+}
+
+void benchMapPack(BenchRunner &runner, const std::vector<int> &sizes) {
+    const int mapCount = 64;
+    for (int size : sizes) {
+        if (!runner.isSelected("map.pack")) return;
+
+        std::string filename = "pacman_bench_pack.tmp";
+        MapPackWriter writer;
+        writer.open(filename);
+        for (int i = 0; i < mapCount; ++i) {
+            writer.add(BENCH_SEED + i, generateMatchMap(makeConfig(size, 2), deriveMatchSeeds(BENCH_SEED + i, 2)));
+        }
+        writer.finish();
+
+        MapPack pack;
+        if (!pack.open(filename)) continue;
+        uint64_t next = 0;
+        runner.run("map.pack.find", {{"size", size}, {"maps", mapCount}}, 1, [&] {
+            consume(pack.find(BENCH_SEED + next % mapCount));
+            ++next;
+        });
+        runner.run("map.pack.view", {{"size", size}}, 1, [&] {
+            MapView view = pack.view(static_cast<int>(next++ % mapCount));
+            consume(view.getTotalDots() + static_cast<int>(view.getCell(1, 1)));
+        });
+        GameMap loaded(0, 0);
+        runner.run("map.pack.toGameMap", {{"size", size}}, 1, [&] {
+            pack.view(static_cast<int>(next++ % mapCount)).toGameMap(loaded);
+            consume(loaded.getTotalDots());
+        });
+        pack.close();
+        std::remove(filename.c_str());
+    }
+}
+
+void benchGenerator(BenchRunner &runner, const std::vector<int> &sizes) {
+    for (int size : sizes) {
+        RandomMapGenerator generator(size, size, GameConfig::DOT_RATIO, static_cast<unsigned int>(BENCH_SEED));
+        runner.run("generator.generateMap", {{"size", size}}, 1, [&] { consume(generator.generateMap().getTotalDots()); });
+
+        // 迷宫上的常规放置，以及没有内墙的空地图上要求放下远多于可能数量的角色（候选全部被抽完）
+        GameMap maze = generator.generateMap();
+        GameMap open(size, size);
+        for (int y = 1; y < size - 1; ++y) {
+            for (int x = 1; x < size - 1; ++x) open.setCell(x, y, CellType::EMPTY);
+        }
+        for (int agents : {8, size * size}) {
+            runner.run("generator.characterPositions", {{"size", size}, {"agents", agents}, {"open", 0}}, 1,
+                       [&] { consume(generator.generateCharacterPositions(maze, agents).size()); });
+            runner.run("generator.characterPositions", {{"size", size}, {"agents", agents}, {"open", 1}}, 1,
+                       [&] { consume(generator.generateCharacterPositions(open, agents).size()); });
+        }
+    }
+}
+
+void benchTurn(BenchRunner &runner, const std::vector<int> &sizes, const std::vector<int> &agentCounts) {
+    for (int size : sizes) {
+        for (int agents : agentCounts) {
+            auto gameLoop = createMatch(makeConfig(size, agents), BENCH_SEED);
+            if (!gameLoop) continue;
+
+            runner.run("loop.executeTurn", {{"size", size}, {"agents", agents}}, 1,
+                       [&] { consume(gameLoop->executeTurn() ? 1 : 0); });
+        }
+    }
+}
+
+// 直方图记录一个样本的开销，以及启用剖析时整回合的开销（与 loop.executeTurn 对比）
+void benchProfiler(BenchRunner &runner, const std::vector<int> &sizes) {
+    LatencyHistogram histogram;
+    uint64_t value = 1;
+    runner.run("profile.histogramRecord", {}, 1, [&] {
+        value = value * 6364136223846793005ULL + 1442695040888963407ULL;
+        histogram.record(value >> 40);
+    });
+    consume(static_cast<int>(histogram.getCount() & 1));
+
+    if (!TurnProfiler::ENABLED) return;
+    for (int size : sizes) {
+        auto gameLoop = createMatch(makeConfig(size, 8), BENCH_SEED);
+        if (!gameLoop) continue;
+        TurnProfiler profiler;
+        gameLoop->setProfiler(&profiler);
+        runner.run("loop.executeTurnProfiled", {{"size", size}, {"agents", 8}}, 1,
+                   [&] { consume(gameLoop->executeTurn() ? 1 : 0); });
+    }
+}
+
+// 模拟搜索型 AI：每次决策先忙等 thinkTime，再交给内置 AI 决定方向
+class ThinkingAgent : public AIInterface {
+  private:
+    std::unique_ptr<AIInterface> inner;
+    std::chrono::microseconds thinkTime;
+
+  public:
+    ThinkingAgent(std::unique_ptr<AIInterface> agent, int thinkMicros)
+        : inner(std::move(agent)), thinkTime(thinkMicros) {}
+
+    Action getAction(const VisibleArea &visibleArea) override {
+        auto until = std::chrono::steady_clock::now() + thinkTime;
+        while (std::chrono::steady_clock::now() < until) {
+        }
+        return inner->getAction(visibleArea);
+    }
+};
+
+AgentFactory thinkingFactory(AgentFactory factory, int thinkMicros) {
+    return [factory, thinkMicros](unsigned int seed) -> std::unique_ptr<AIInterface> {
+        return std::make_unique<ThinkingAgent>(factory(seed), thinkMicros);
+    };
+}
+
+// 每个 AI 思考固定时间时，串行决策的回合耗时是各 AI 之和，并行决策接近单个 AI 的耗时（受核心数限制）
+void benchDecisions(BenchRunner &runner) {
+    const int agents = 8;
+    const int thinkMicros = 200;
+    MatchConfig config = makeConfig(31, agents);
+    MatchSeeds seeds = deriveMatchSeeds(BENCH_SEED, agents);
+    GameMap map = generateMatchMap(config, seeds);
+    ThreadPool pool(agents - 1);
+    for (int threads : {0, agents - 1}) {
+        auto gameLoop = createMatch(map, config, seeds, thinkingFactory(defaultPacmanFactory(), thinkMicros),
+                                    thinkingFactory(defaultMonsterFactory(), thinkMicros));
+        if (!gameLoop) continue;
+        gameLoop->setDecisionPool(threads > 0 ? &pool : nullptr);
+        runner.run("loop.thinkingTurn", {{"agents", agents}, {"think_us", thinkMicros}, {"threads", threads}}, 1,
+                   [&] { consume(gameLoop->executeTurn() ? 1 : 0); });
+    }
+}
+
+bool sameVisibleArea(const VisibleArea &a, const VisibleArea &b) {
+    if (a.getWidth() != b.getWidth() || a.getHeight() != b.getHeight()) return false;
+    for (int y = 0; y < a.getHeight(); ++y) {
+        for (int x = 0; x < a.getWidth(); ++x) {
+            if (a.getCell(x, y) != b.getCell(x, y)) return false;
+        }
+    }
+    return true;
+}
+
+// 以地图内外一圈半径范围内的每个位置（包括墙上和界外）为中心，比较查表结果与参照实现
+// 依次检查不带缓存的查表路径和带缓存的路径
+int verifyVisibilityOnMap(const GameMap &sourceMap, const std::vector<Character> &characters, int radius) {
+    VisibilitySystem visibility(radius);
+    int r = visibility.getRadius();
+    int mismatches = 0;
+
+    GameMap map = sourceMap;
+    map.dropVisibilityCaches();
+    for (int cached = 0; cached <= 1; ++cached) {
+        if (cached) visibility.buildCache(map);
+        // 经由游戏状态的占用索引查角色的路径也必须一致
+        GameStateManager gameState(map, characters);
+        for (int y = -r; y < map.getHeight() + r; ++y) {
+            for (int x = -r; x < map.getWidth() + r; ++x) {
+                Position center(x, y);
+                VisibleArea reference = visibility.calculateVisibleAreaReference(center, map, characters);
+                if (!sameVisibleArea(visibility.calculateVisibleArea(center, map, characters), reference) ||
+                    !sameVisibleArea(visibility.calculateVisibleArea(center, gameState), reference)) {
+                    if (mismatches == 0) {
+                        std::fprintf(stderr, "visibility mismatch: map %dx%d radius %d cached %d center (%d,%d)\n",
+                                     map.getWidth(), map.getHeight(), radius, cached, x, y);
+                    }
+                    ++mismatches;
+                }
+            }
+        }
+    }
+    return mismatches;
+}
+
+// 写时复制：副本的写入不能影响原地图，未改动的分块继续共享
+int verifyCopyOnWrite() {
+    GameMap map = generateMatchMap(makeConfig(63, 2), deriveMatchSeeds(BENCH_SEED, 2));
+    std::string before = map.saveToString();
+    int failures = 0;
+
+    GameMap copy = map;
+    Position target(5, 40);
+    copy.setCell(target, copy.getCell(target) == CellType::DOT ? CellType::EMPTY : CellType::DOT);
+    if (map.saveToString() != before || copy.saveToString() == before) ++failures;
+    for (int tile = 0; tile < map.getTileCount(); ++tile) {
+        bool shouldShare = tile != target.y / GameMap::TILE_ROWS;
+        if (map.sharesTile(copy, tile) != shouldShare) ++failures;
+    }
+
+    if (failures != 0) std::fprintf(stderr, "map copy-on-write: %d failures\n", failures);
+    return failures;
+}
+
+// 宽为 0、高大于 0 的地图保留高度，按行访问、整行写入、复制和统计都不能越界；负的尺寸按 0 处理
+int verifyEmptyRowMaps() {
+    int failures = 0;
+    GameMap map(0, 5);
+    if (map.getWidth() != 0 || map.getHeight() != 5 || map.getWordsPerRow() != 0) ++failures;
+    for (int y = 0; y < map.getHeight(); ++y) {
+        map.setRow(y, map.getRow(y));
+        map.getWallBitsRow(y);
+        map.getDotBitsRow(y);
+    }
+    map.setCell(0, 0, CellType::DOT);
+    GameMap copy = map;
+    copy.clear();
+    if (map.countDots() != 0 || map.countEmptyCells() != 0 || map.validate() || copy.getHeight() != 5) ++failures;
+    if (map.saveToString() != "0 5\n\n\n\n\n\n") ++failures;
+
+    GameMap negative(-3, 4);
+    if (negative.getWidth() != 0 || negative.getHeight() != 4 || negative.getTileCount() != 1) ++failures;
+    GameMap flat(7, -1);
+    if (flat.getWidth() != 7 || flat.getHeight() != 0 || flat.getTileCount() != 0) ++failures;
+
+    if (failures != 0) std::fprintf(stderr, "empty-row maps: %d failures\n", failures);
+    return failures;
+}
+
+// 在共用的线程池上并行构建缓存：池中另有未结束的任务时不能等它，在池的工作线程内调用也不能死锁；
+// 结果必须与串行构建一致
+int verifyParallelCacheBuild() {
+    GameMap serial = generateMatchMap(makeConfig(63, 2), deriveMatchSeeds(BENCH_SEED, 2));
+    serial.dropVisibilityCaches();
+    VisibilitySystem visibility(GameConfig::PACMAN_VISIBILITY_RADIUS);
+    visibility.buildCache(serial);
+
+    ThreadPool pool(2);
+    std::atomic<bool> release(false);
+    pool.submit([&release] {
+        while (!release.load()) std::this_thread::yield();
+    });
+    GameMap fromCaller = serial;
+    fromCaller.dropVisibilityCaches();
+    visibility.buildCache(fromCaller, &pool);
+    release.store(true);
+
+    GameMap fromWorker = serial;
+    fromWorker.dropVisibilityCaches();
+    pool.submit([&] { visibility.buildCache(fromWorker, &pool); });
+    pool.waitIdle();
+
+    int failures = 0;
+    std::vector<Character> noCharacters;
+    for (const GameMap *map : {&fromCaller, &fromWorker}) {
+        if (map->findVisibilityCache(visibility.getRadius()) == nullptr) {
+            ++failures;
+            continue;
+        }
+        for (const Position &center : walkablePositions(serial)) {
+            if (!sameVisibleArea(visibility.calculateVisibleArea(center, *map, noCharacters),
+                                 visibility.calculateVisibleArea(center, serial, noCharacters))) {
+                ++failures;
+            }
+        }
+    }
+    if (failures != 0) std::fprintf(stderr, "parallel cache build: %d failures\n", failures);
+    return failures;
+}
+
+// 改动墙壁后缓存必须失效，改动豆子不影响缓存
+int verifyCacheInvalidation() {
+    MatchConfig config = makeConfig(21, 2);
+    GameMap map = generateMatchMap(config, deriveMatchSeeds(BENCH_SEED, 2));
+    int failures = 0;
+    const int radius = GameConfig::PACMAN_VISIBILITY_RADIUS;
+
+    std::vector<Position> walkable = walkablePositions(map);
+    if (map.findVisibilityCache(radius) == nullptr || walkable.empty()) return 1;
+
+    GameMap copy = map;
+    copy.setCell(walkable[0], CellType::EMPTY);
+    copy.setCell(walkable[0], CellType::DOT);
+    if (copy.findVisibilityCache(radius) == nullptr) ++failures;
+
+    copy.setCell(walkable[0], CellType::WALL);
+    if (copy.findVisibilityCache(radius) != nullptr) ++failures;
+    if (map.findVisibilityCache(radius) == nullptr) ++failures; // 副本的修改不影响原地图
+
+    if (failures != 0) std::fprintf(stderr, "visibility cache invalidation: %d failures\n", failures);
+    return failures;
+}
+
+// 超出 [0, MAX_VISIBILITY_RADIUS] 的半径和超出 [0, MAX_SIZE] 的视野尺寸必须被拒绝，而不是截断
+int verifyVisibilityLimits() {
+    int failures = 0;
+    const int invalidRadii[] = {-1, GameConfig::MAX_VISIBILITY_RADIUS + 1, 1000};
+    for (int radius : invalidRadii) {
+        try {
+            VisibilitySystem visibility(radius);
+            ++failures;
+        } catch (const std::invalid_argument &) {
+        }
+    }
+    const int invalidSizes[][2] = {{-1, 1}, {VisibleArea::MAX_SIZE + 1, 1}, {1, VisibleArea::MAX_SIZE + 1}};
+    for (const auto &size : invalidSizes) {
+        try {
+            VisibleArea area(size[0], size[1]);
+            ++failures;
+        } catch (const std::invalid_argument &) {
+        }
+    }
+    try {
+        VisibleArea area(VisibleArea::MAX_SIZE, VisibleArea::MAX_SIZE);
+        if (area.getWidth() != VisibleArea::MAX_SIZE || area.getHeight() != VisibleArea::MAX_SIZE) ++failures;
+    } catch (const std::invalid_argument &) {
+        ++failures;
+    }
+    if (failures != 0) std::fprintf(stderr, "visibility limits: %d failures\n", failures);
+    return failures;
+}
+
+int verifyVisibility(bool quick) {
+    std::vector<int> radii;
+    for (int radius = 0; radius <= 8; ++radius) radii.push_back(radius);
+    radii.push_back(GameConfig::MAX_VISIBILITY_RADIUS);
+
+    int mismatches = 0;
+    int checkedMaps = 0;
+
+    // 生成器地图：走廊结构，带角色
+    const int sizes[] = {7, 15, 31, 63};
+    for (int size : sizes) {
+        for (int seedIndex = 0; seedIndex < (quick ? 2 : 8); ++seedIndex) {
+            MatchSeeds seeds = deriveMatchSeeds(BENCH_SEED + seedIndex, 4);
+            GameMap map = generateMatchMap(makeConfig(size, 4), seeds);
+            std::vector<Character> characters = createMatchCharacters(map, 3, seeds.spawnSeed);
+            for (int radius : radii) mismatches += verifyVisibilityOnMap(map, characters, radius);
+            ++checkedMaps;
+        }
+    }
+
+    // 随机墙壁地图：覆盖生成器不会产生的墙壁组合，包括非正方形和宽于 64 列的地图
+    std::mt19937 rng(BENCH_SEED);
+    const int shapes[][2] = {{5, 9}, {17, 11}, {40, 40}, {70, 13}};
+    const int densities[] = {10, 30, 50, 70};
+    for (const auto &shape : shapes) {
+        for (int density : densities) {
+            GameMap map(shape[0], shape[1]);
+            for (int y = 0; y < map.getHeight(); ++y) {
+                for (int x = 0; x < map.getWidth(); ++x) {
+                    map.setCell(x, y, static_cast<int>(rng() % 100) < density ? CellType::WALL : CellType::DOT);
+                }
+            }
+            std::vector<Character> characters;
+            for (int i = 0; i < 4; ++i) {
+                Position pos(static_cast<int>(rng() % shape[0]), static_cast<int>(rng() % shape[1]));
+                Character character(pos, i == 0 ? CharacterType::PACMAN : CharacterType::MONSTER);
+                character.id = i;
+                character.isAlive = i != 3; // 死亡角色不应出现在视野中
+                characters.push_back(character);
+            }
+            for (int radius : radii) mismatches += verifyVisibilityOnMap(map, characters, radius);
+            ++checkedMaps;
+        }
+    }
+
+    std::fprintf(stderr, "visibility: %d maps, %zu radii, %d mismatches\n", checkedMaps, radii.size(), mismatches);
+    return mismatches + verifyCacheInvalidation() + verifyParallelCacheBuild() + verifyCopyOnWrite() +
+           verifyEmptyRowMaps() + verifyVisibilityLimits();
+}
+
+// 边跑对局边记录历史，并保存每条记录的完整状态指纹作为参照；期间穿插吃豆、改墙和回退后重新记录，
+// 最后逐条重建历史并比较指纹，同时检查单步前进/后退
+int verifyHistoryConfig(int mapSize, int maxHistory, int keyframeInterval, int turns) {
+    auto gameLoop = createMatch(makeConfig(mapSize, 4), BENCH_SEED);
+    if (!gameLoop) return 1;
+
+    GameStateManager &gameState = gameLoop->getGameState();
+    GameControlSystem control(maxHistory, keyframeInterval);
+    std::vector<uint64_t> expected;
+    std::mt19937 rng(BENCH_SEED);
+    int failures = 0;
+
+    control.recordState(gameState);
+    expected.push_back(hashGameState(gameState));
+    for (int turn = 1; turn <= turns; ++turn) {
+        gameLoop->executeTurn();
+        gameState.consumeDot(gameState.getPacman().position);
+        if (turn % 97 == 0) {
+            // 改动墙壁（会丢弃视野缓存，并产生墙壁类型的格子增量）
+            Position pos(static_cast<int>(rng() % mapSize), static_cast<int>(rng() % mapSize));
+            GameState state = gameState.getCurrentState();
+            state.map.setCell(pos, state.map.isWall(pos) ? CellType::EMPTY : CellType::WALL);
+            gameState.restoreState(state);
+        }
+        if (turn % 500 == 0 && control.getHistorySize() > 10) {
+            // 回退若干步后继续记录，后面的历史应被截断
+            for (int i = 0; i < 7; ++i) control.stepBackward();
+            size_t kept = expected.size() - (control.getHistorySize() - 1 - control.getCurrentHistoryIndex());
+            expected.resize(kept);
+        }
+        control.recordState(gameState);
+        expected.push_back(hashGameState(gameState));
+    }
+
+    int size = control.getHistorySize();
+    size_t offset = expected.size() - size;
+    for (int i = size - 1; i >= 0; --i) {
+        if (hashGameState(control.getHistoryState(i)) != expected[offset + i]) ++failures;
+    }
+    if (hashGameState(control.restartFromBeginning()) != expected[offset]) ++failures;
+    for (int i = 1; i < size; ++i) {
+        if (hashGameState(control.stepForward()) != expected[offset + i]) ++failures;
+    }
+    for (int i = size - 2; i >= 0; --i) {
+        if (hashGameState(control.stepBackward()) != expected[offset + i]) ++failures;
+    }
+
+    if (failures != 0) {
+        std::fprintf(stderr, "history mismatch: max %d keyframe %d: %d failures\n", maxHistory, keyframeInterval,
+                     failures);
+    }
+    return failures;
+}
+
+int verifyHistory(bool quick) {
+    int turns = quick ? 1500 : 5000;
+    int failures = 0;
+    failures += verifyHistoryConfig(31, 0, GameControlSystem::DEFAULT_KEYFRAME_INTERVAL, turns);
+    failures += verifyHistoryConfig(31, 100, GameControlSystem::DEFAULT_KEYFRAME_INTERVAL, turns);
+    failures += verifyHistoryConfig(31, 50, 7, turns);
+    // 小地图上关键帧很便宜，段很短，覆盖整段淘汰和频繁开新段的路径
+    failures += verifyHistoryConfig(9, 30, 1, turns);
+
+    // 完整历史的内存占用
+    auto gameLoop = createMatch(makeConfig(255, 4), BENCH_SEED);
+    if (gameLoop) {
+        int longTurns = quick ? 10000 : 100000;
+        GameControlSystem control(0);
+        for (int turn = 0; turn < longTurns; ++turn) {
+            gameLoop->executeTurn();
+            control.recordState(gameLoop->getGameState());
+        }
+        std::fprintf(stderr, "history: %d turns on 255x255 stored in %.2f MB\n", control.getHistorySize(),
+                     control.getHistoryMemoryBytes() / (1024.0 * 1024.0));
+    }
+
+    std::fprintf(stderr, "history: %d failures\n", failures);
+    return failures;
+}
+
+// 录制对局的行动日志，保存每回合的状态指纹作为参照，然后以随机顺序跳转到每一回合比较指纹
+int verifyReplayConfig(int mapSize, int agents, int keyframeInterval, int turns) {
+    auto gameLoop = createMatch(makeConfig(mapSize, agents), BENCH_SEED);
+    if (!gameLoop) return 1;
+
+    ReplayRecorder recorder(BENCH_SEED, keyframeInterval);
+    gameLoop->setReplayRecorder(&recorder);
+    std::vector<uint64_t> expected;
+    expected.push_back(hashGameState(gameLoop->getGameState()));
+    for (int turn = 1; turn <= turns; ++turn) {
+        gameLoop->executeTurn();
+        expected.push_back(hashGameState(gameLoop->getGameState()));
+    }
+    gameLoop->setReplayRecorder(nullptr);
+
+    std::vector<uint8_t> bytes = recorder.serialize();
+    ReplayPlayer player;
+    if (!player.loadFromBuffer(bytes) || player.getTurnCount() != turns || player.getMatchSeed() != BENCH_SEED) {
+        std::fprintf(stderr, "replay: cannot load recorded replay (size %d)\n", mapSize);
+        return 1;
+    }
+
+    std::vector<int> order(turns + 1);
+    for (int i = 0; i <= turns; ++i) order[i] = i;
+    std::mt19937 rng(BENCH_SEED);
+    for (int i = turns; i > 0; --i) std::swap(order[i], order[rng() % (i + 1)]);
+
+    int failures = 0;
+    GameStateManager gameState;
+    for (int turn : order) {
+        if (!player.seek(turn, gameState) || hashGameState(gameState) != expected[turn]) ++failures;
+    }
+    if (player.seek(turns + 1, gameState)) ++failures;
+
+    // 截断的文件必须被拒绝
+    std::vector<uint8_t> truncated(bytes.begin(), bytes.begin() + bytes.size() / 2);
+    ReplayPlayer broken;
+    if (broken.loadFromBuffer(truncated)) ++failures;
+
+    if (failures != 0) {
+        std::fprintf(stderr, "replay mismatch: size %d agents %d keyframe %d: %d failures\n", mapSize, agents,
+                     keyframeInterval, failures);
+    }
+    return failures;
+}
+
+// 种子解析：前导 0 仍是十进制，0x 为十六进制；空白、符号、多余字符和溢出都必须拒绝
+int verifySeedParsing() {
+    struct SeedInput {
+        const char *text;
+        bool valid;
+        uint64_t seed;
+    };
+    const SeedInput inputs[] = {
+        {"0", true, 0},
+        {"010", true, 10},
+        {"0x1F", true, 31},
+        {"0XfF", true, 255},
+        {"18446744073709551615", true, UINT64_MAX},
+        {"0xFFFFFFFFFFFFFFFF", true, UINT64_MAX},
+        {"18446744073709551616", false, 0},
+        {"99999999999999999999999", false, 0},
+        {"0x10000000000000000", false, 0},
+        {"", false, 0},
+        {"0x", false, 0},
+        {"-1", false, 0},
+        {" -1", false, 0},
+        {" 5", false, 0},
+        {"+5", false, 0},
+        {"5 ", false, 0},
+        {"1e3", false, 0},
+        {"0x1G", false, 0},
+    };
+    int failures = 0;
+    for (const auto &input : inputs) {
+        uint64_t seed = 0;
+        bool valid = parseMatchSeed(input.text, seed);
+        if (valid != input.valid || (valid && seed != input.seed)) {
+            std::fprintf(stderr, "seed parsing: \"%s\" parsed wrongly\n", input.text);
+            ++failures;
+        }
+    }
+    if (failures != 0) std::fprintf(stderr, "seed parsing: %d failures\n", failures);
+    return failures;
+}
+
+int verifyReplay(bool quick) {
+    int turns = quick ? 1000 : 4000;
+    int failures = 0;
+    failures += verifyReplayConfig(31, 4, ReplayFormat::DEFAULT_KEYFRAME_INTERVAL, turns);
+    failures += verifyReplayConfig(15, 9, 1, turns);
+    failures += verifyReplayConfig(63, 3, 0, quick ? 200 : 500); // 只有初始关键帧
+
+    // 长对局的文件大小
+    auto gameLoop = createMatch(makeConfig(255, 4), BENCH_SEED);
+    if (gameLoop) {
+        int longTurns = quick ? 10000 : 100000;
+        ReplayRecorder recorder(BENCH_SEED);
+        gameLoop->setReplayRecorder(&recorder);
+        for (int turn = 0; turn < longTurns; ++turn) {
+            gameLoop->executeTurn();
+        }
+        gameLoop->setReplayRecorder(nullptr);
+        std::fprintf(stderr, "replay: %d turns on 255x255 stored in %.2f MB\n", recorder.getTurnCount(),
+                     recorder.serialize().size() / (1024.0 * 1024.0));
+    }
+
+    std::fprintf(stderr, "replay: %d failures\n", failures);
+    return failures;
+}
+
+// 文本地图：往返必须逐格一致；格式错误必须报告正确的行列
+int verifyMapText() {
+    int failures = 0;
+    for (int size : {5, 31, 64, 65, 255}) {
+        GameMap map = generateMatchMap(makeConfig(size, 2), deriveMatchSeeds(BENCH_SEED, 2));
+        std::string text = MapText::serialize(map);
+        GameMap loaded(0, 0);
+        if (!MapText::parse(text, loaded) || MapText::serialize(loaded) != text ||
+            loaded.getTotalDots() != map.countDots() || hashGameState(GameStateManager(loaded, {})) !=
+                                                            hashGameState(GameStateManager(map, {}))) {
+            std::fprintf(stderr, "map text: round trip mismatch on %dx%d\n", size, size);
+            ++failures;
+        }
+
+        // Windows 换行、缺少末尾换行、末尾空行都应接受
+        std::string crlf;
+        for (char c : text) {
+            if (c == '\n') crlf += '\r';
+            crlf += c;
+        }
+        if (!MapText::parse(crlf, loaded) || MapText::serialize(loaded) != text) ++failures;
+        if (!MapText::parse(text.substr(0, text.size() - 1), loaded) || MapText::serialize(loaded) != text) ++failures;
+        if (!MapText::parse(text + "\n\n", loaded) || MapText::serialize(loaded) != text) ++failures;
+    }
+
+    // 宽为 0 的地图：每行都是空行，往返后保持原样
+    const std::string emptyRows = "0 5\n\n\n\n\n\n";
+    GameMap emptyRowMap(3, 3);
+    if (!MapText::parse(emptyRows, emptyRowMap) || emptyRowMap.getWidth() != 0 || emptyRowMap.getHeight() != 5 ||
+        MapText::serialize(emptyRowMap) != emptyRows || !emptyRowMap.loadFromString(emptyRows)) {
+        std::fprintf(stderr, "map text: 0x5 map not accepted\n");
+        ++failures;
+    }
+
+    struct BadInput {
+        const char *text;
+        int line;
+        int column;
+    };
+    const BadInput badInputs[] = {
+        {"", 1, 1},                                // 没有尺寸
+        {"3 x\n", 1, 3},                           // 高度不是数字
+        {"3 2 7\n###\n###\n", 1, 5},               // 尺寸行多余内容
+        {"3 2\n###\n", 3, 1},                      // 缺少一行
+        {"3 2\n###\n#\n", 3, 2},                   // 行太短
+        {"3 2\n####\n###\n", 2, 4},                // 行太长
+        {"3 2\n###\n#x#\n", 3, 2},                 // 非法字符
+        {"10 2\n##########\n###\t######\n", 3, 4}, // 按 8 字节分组比较时的非法字符
+        {"3 2\n###\n###\n\n  junk\n", 5, 3},       // 地图之后的多余数据
+        {"99999999 1\n#\n", 1, 1},                 // 尺寸过大
+        {"0 2\n\n#\n", 3, 1},                      // 宽为 0 时行必须为空
+    };
+    GameMap untouched(3, 3);
+    std::string before = untouched.saveToString();
+    for (const auto &input : badInputs) {
+        MapText::ParseError error;
+        if (MapText::parse(input.text, untouched, &error) || error.line != input.line ||
+            error.column != input.column || untouched.saveToString() != before) {
+            std::fprintf(stderr, "map text: bad input %s reported as %s\n", input.text,
+                         MapText::formatError(error).c_str());
+            ++failures;
+        }
+    }
+
+    std::fprintf(stderr, "map text: %d failures\n", failures);
+    return failures;
+}
+
+// 地图包：写入后逐张比较视图和原地图的单元格与位平面，并检查查找、CRC 和损坏检测
+int verifyMapPack() {
+    int failures = 0;
+    std::string filename = "pacman_bench_verify_pack.tmp";
+    std::vector<std::pair<uint64_t, GameMap>> maps;
+    const int sizes[] = {7, 31, 64, 65, 130};
+    for (int i = 0; i < 20; ++i) {
+        // 种子乱序写入，索引应按种子排序
+        uint64_t seed = splitMix64(BENCH_SEED + i);
+        int size = sizes[i % 5];
+        maps.emplace_back(seed, generateMatchMap(makeConfig(size, 2), deriveMatchSeeds(seed, 2)));
+    }
+
+    MapPackWriter writer;
+    if (!writer.open(filename)) return 1;
+    for (const auto &entry : maps) {
+        if (!writer.add(entry.first, entry.second)) ++failures;
+    }
+    if (writer.add(maps[0].first, maps[0].second)) ++failures; // 重复种子
+    if (writer.add(BENCH_SEED, GameMap(0, 5))) ++failures;     // 没有单元格
+    // 超出最大边长的地图读取时会整包拒绝，写入时就不能接受
+    if (writer.add(BENCH_SEED, GameMap(StateCodec::MAX_MAP_DIMENSION + 1, 3))) ++failures;
+    if (!writer.finish()) ++failures;
+
+    MapPack pack;
+    if (!pack.open(filename) || pack.size() != static_cast<int>(maps.size())) {
+        std::fprintf(stderr, "map pack: cannot open written pack\n");
+        return failures + 1;
+    }
+    for (const auto &entry : maps) {
+        int index = pack.find(entry.first);
+        if (index < 0 || pack.seedAt(index) != entry.first || !pack.verify(index)) {
+            ++failures;
+            continue;
+        }
+        const GameMap &map = entry.second;
+        MapView view = pack.view(index);
+        bool same = view.getWidth() == map.getWidth() && view.getHeight() == map.getHeight() &&
+                    view.getTotalDots() == map.getTotalDots();
+        for (int y = 0; same && y < map.getHeight(); ++y) {
+            same = std::memcmp(view.getRow(y), map.getRow(y), map.getWidth()) == 0 &&
+                   std::memcmp(view.getWallBitsRow(y), map.getWallBitsRow(y), map.getWordsPerRow() * 8) == 0 &&
+                   std::memcmp(view.getDotBitsRow(y), map.getDotBitsRow(y), map.getWordsPerRow() * 8) == 0;
+        }
+        GameMap loaded(0, 0);
+        if (!same || !view.toGameMap(loaded) || loaded.saveToString() != map.saveToString() ||
+            loaded.getTotalDots() != map.getTotalDots()) {
+            ++failures;
+        }
+    }
+    if (pack.find(BENCH_SEED) >= 0) ++failures;
+    pack.close();
+
+    // 记录内容损坏由 verify() 发现；索引损坏在打开时就被拒绝
+    std::vector<uint8_t> bytes;
+    readFileBytes(filename, bytes);
+    std::vector<uint8_t> corrupted = bytes;
+    corrupted[MapPackFormat::HEADER_BYTES + 3] ^= 1;
+    writeFileBytes(filename, corrupted);
+    if (!pack.open(filename)) {
+        ++failures;
+    } else {
+        bool anyBad = false;
+        for (int i = 0; i < pack.size(); ++i) anyBad |= !pack.verify(i);
+        if (!anyBad) ++failures;
+        pack.close();
+    }
+
+    // 单元格取值不合法的记录不能转成地图，loadMatchMap 退回按种子重新生成
+    corrupted = bytes;
+    corrupted[MapPackFormat::HEADER_BYTES + 3] = 0x7F;
+    writeFileBytes(filename, corrupted);
+    if (!pack.open(filename)) {
+        ++failures;
+    } else {
+        const GameMap &original = maps[0].second;
+        GameMap loaded(0, 0);
+        if (pack.view(pack.find(maps[0].first)).toGameMap(loaded)) ++failures;
+        MatchConfig config = makeConfig(original.getWidth(), 2);
+        GameMap fallback = loadMatchMap(config, deriveMatchSeeds(maps[0].first, 2), &pack);
+        if (fallback.saveToString() != original.saveToString()) ++failures;
+        pack.close();
+    }
+
+    // 墙翻成空地后单元格取值仍然合法，只有 CRC 能发现；loadMatchMap 必须校验后退回重新生成
+    corrupted = bytes;
+    if (corrupted[MapPackFormat::HEADER_BYTES + 3] != static_cast<uint8_t>(CellType::WALL)) ++failures;
+    corrupted[MapPackFormat::HEADER_BYTES + 3] = static_cast<uint8_t>(CellType::EMPTY);
+    writeFileBytes(filename, corrupted);
+    if (!pack.open(filename)) {
+        ++failures;
+    } else {
+        const GameMap &original = maps[0].second;
+        MatchConfig config = makeConfig(original.getWidth(), 2);
+        GameMap fallback = loadMatchMap(config, deriveMatchSeeds(maps[0].first, 2), &pack);
+        if (pack.verify(pack.find(maps[0].first)) || fallback.saveToString() != original.saveToString()) ++failures;
+        pack.close();
+    }
+    corrupted = bytes;
+    corrupted[bytes.size() - 5] ^= 1;
+    writeFileBytes(filename, corrupted);
+    if (pack.open(filename)) ++failures;
+    std::remove(filename.c_str());
+
+    std::fprintf(stderr, "map pack: %d failures\n", failures);
+    return failures;
+}
+
+// 连通性分析：与逐格广度优先搜索的参照实现比较区域编号、每个区域的格子数和豆子数
+int verifyConnectivityOnMap(const GameMap &map, MapConnectivity &connectivity) {
+    int width = map.getWidth();
+    int height = map.getHeight();
+    std::vector<int> labels(static_cast<size_t>(width) * height, -1);
+    std::vector<MapConnectivity::Component> components;
+    std::vector<Position> queue;
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            if (map.getCell(x, y) == CellType::WALL || labels[static_cast<size_t>(y) * width + x] >= 0) continue;
+            int id = static_cast<int>(components.size());
+            components.push_back(MapConnectivity::Component{0, 0});
+            labels[static_cast<size_t>(y) * width + x] = id;
+            queue.assign(1, Position(x, y));
+            for (size_t head = 0; head < queue.size(); ++head) {
+                Position current = queue[head];
+                components[id].cells++;
+                components[id].dots += map.getCell(current) == CellType::DOT ? 1 : 0;
+                const Position neighbors[] = {Position(current.x - 1, current.y), Position(current.x + 1, current.y),
+                                              Position(current.x, current.y - 1), Position(current.x, current.y + 1)};
+                for (const Position &next : neighbors) {
+                    if (!map.isInBounds(next) || map.getCell(next) == CellType::WALL) continue;
+                    int &label = labels[static_cast<size_t>(next.y) * width + next.x];
+                    if (label < 0) {
+                        label = id;
+                        queue.push_back(next);
+                    }
+                }
+            }
+        }
+    }
+
+    connectivity.analyze(map);
+    int failures = connectivity.getComponentCount() == static_cast<int>(components.size()) ? 0 : 1;
+    for (int id = 0; failures == 0 && id < static_cast<int>(components.size()); ++id) {
+        const MapConnectivity::Component &component = connectivity.getComponent(id);
+        if (component.cells != components[id].cells || component.dots != components[id].dots) ++failures;
+    }
+    for (int y = 0; failures == 0 && y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            if (connectivity.componentAt(x, y) != labels[static_cast<size_t>(y) * width + x]) ++failures;
+        }
+    }
+    if (connectivity.componentAt(-1, 0) != -1 || connectivity.componentAt(width, height - 1) != -1) ++failures;
+    if (failures > 0) {
+        std::fprintf(stderr, "connectivity: mismatch on %dx%d map\n", width, height);
+    }
+    return failures;
+}
+
+int verifyConnectivity(bool quick) {
+    int failures = 0;
+    MapConnectivity connectivity;
+    std::mt19937 randomEngine(static_cast<unsigned int>(BENCH_SEED));
+    const int sizes[] = {1, 2, 7, 63, 64, 65, 127, 128, 130};
+    // 墙壁密度覆盖全空、稀疏、接近渗流阈值和几乎全墙，边界也随机，检查跨字和行首行尾的行段
+    const int wallPercents[] = {0, 20, 40, 55, 90, 100};
+    int rounds = quick ? 1 : 4;
+    for (int round = 0; round < rounds; ++round) {
+        for (int width : sizes) {
+            for (int wallPercent : wallPercents) {
+                int height = sizes[randomEngine() % 9];
+                GameMap map(width, height);
+                for (int y = 0; y < height; ++y) {
+                    for (int x = 0; x < width; ++x) {
+                        int roll = static_cast<int>(randomEngine() % 100);
+                        CellType type = roll < wallPercent ? CellType::WALL : CellType::EMPTY;
+                        if (type == CellType::EMPTY && roll % 3 == 0) type = CellType::DOT;
+                        map.setCell(x, y, type);
+                    }
+                }
+                failures += verifyConnectivityOnMap(map, connectivity);
+            }
+        }
+    }
+
+    // 生成的迷宫总是连通的，必须通过验证
+    for (int size : {5, 31, 64, 65, 255}) {
+        GameMap map = generateMatchMap(makeConfig(size, 2), deriveMatchSeeds(BENCH_SEED + size, 2));
+        failures += verifyConnectivityOnMap(map, connectivity);
+        if (!map.validate() || connectivity.getComponentCount() != 1) ++failures;
+
+        // 在角落围出一个带豆子的孤立格后，该豆子不可达，验证失败
+        map.setCell(1, 2, CellType::WALL);
+        map.setCell(2, 1, CellType::WALL);
+        map.setCell(1, 1, CellType::DOT);
+        connectivity.analyze(map);
+        if (map.validate() || connectivity.countUnreachableDots(connectivity.getLargestComponent()) == 0) ++failures;
+    }
+
+    std::fprintf(stderr, "connectivity: %d failures\n", failures);
+    return failures;
+}
+
+// 出生点放置：检查每个点的活动空间和距离约束；点数不足时不能还有满足条件的候选被漏掉
+int verifySpawnPlacement(bool quick) {
+    int failures = 0;
+    const int relaxedDistance = 3;
+    for (int size : {5, 9, 15, 31, 64}) {
+        for (int wallPercent : {0, 30, 60}) {
+            GameMap map(size, size);
+            std::mt19937 randomEngine(static_cast<unsigned int>(BENCH_SEED + size + wallPercent));
+            for (int y = 1; y < size - 1; ++y) {
+                for (int x = 1; x < size - 1; ++x) {
+                    bool wall = static_cast<int>(randomEngine() % 100) < wallPercent;
+                    map.setCell(x, y, wall ? CellType::WALL : CellType::EMPTY);
+                }
+            }
+            for (int agents : {1, 2, 5, quick ? 50 : 400}) {
+                RandomMapGenerator generator(size, size, GameConfig::DOT_RATIO, static_cast<unsigned int>(agents));
+                std::vector<Position> positions = generator.generateCharacterPositions(map, agents);
+                generator.setSeed(static_cast<unsigned int>(agents));
+                if (positions.size() > static_cast<size_t>(agents) ||
+                    generator.generateCharacterPositions(map, agents) != positions) {
+                    ++failures;
+                }
+
+                auto hasRoom = [&map](const Position &pos) {
+                    int free = 0;
+                    for (int dy = -1; dy <= 1; ++dy) {
+                        for (int dx = -1; dx <= 1; ++dx) free += map.isWall(Position(pos.x + dx, pos.y + dy)) ? 0 : 1;
+                    }
+                    return !map.isWall(pos) && free >= 3;
+                };
+                for (size_t i = 0; i < positions.size(); ++i) {
+                    int minDistance = i < 2 ? GameConfig::MIN_DISTANCE_BETWEEN_CHARACTERS : relaxedDistance;
+                    if (!hasRoom(positions[i])) ++failures;
+                    for (size_t j = 0; j < i; ++j) {
+                        if (positions[i].manhattanDistance(positions[j]) < minDistance) ++failures;
+                    }
+                }
+
+                // 放宽之后点数仍不足，说明已经没有与所有点都保持距离的候选
+                if (positions.size() >= 2 && positions.size() < static_cast<size_t>(agents)) {
+                    for (int y = 1; y < size - 1; ++y) {
+                        for (int x = 1; x < size - 1; ++x) {
+                            Position pos(x, y);
+                            bool fits = hasRoom(pos);
+                            for (size_t j = 0; fits && j < positions.size(); ++j) {
+                                fits = pos.manhattanDistance(positions[j]) >= relaxedDistance;
+                            }
+                            if (fits) ++failures;
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    std::fprintf(stderr, "spawn placement: %d failures\n", failures);
+    return failures;
+}
+
+// 批量生成：拒绝分类和去重结果必须与逐张生成、检查并按完整内容去重的参照实现一致
+int verifyMapBatch(bool quick) {
+    int failures = 0;
+    MapBatchConfig config;
+    config.width = 5;
+    config.height = 5;
+    config.monsterCount = 1;
+    config.baseSeed = BENCH_SEED;
+    config.seedCount = quick ? 500 : 3000;
+    config.threadCount = 1;
+
+    std::vector<std::pair<uint64_t, std::string>> accepted;
+    MapBatchStats stats = MapBatchGenerator(config).run(
+        [&accepted](uint64_t seed, const GameMap &map) { accepted.emplace_back(seed, map.saveToString()); });
+
+    MapBatchStats expected;
+    std::vector<std::pair<uint64_t, std::string>> expectedAccepted;
+    std::set<std::string> seen;
+    MapConnectivity connectivity;
+    MatchConfig matchConfig = makeConfig(config.width, 1 + config.monsterCount);
+    matchConfig.mapHeight = config.height;
+    matchConfig.visibilityCache = false;
+    for (long long i = 0; i < config.seedCount; ++i) {
+        uint64_t seed = config.baseSeed + static_cast<uint64_t>(i);
+        MatchSeeds seeds = deriveMatchSeeds(seed, 1 + config.monsterCount);
+        GameMap map = generateMatchMap(matchConfig, seeds);
+        expected.generated++;
+        switch (checkMapQuality(map, config.monsterCount, seeds.spawnSeed, connectivity)) {
+        case MapRejection::NO_SPAWN:
+            expected.noSpawn++;
+            break;
+        case MapRejection::UNREACHABLE_DOTS:
+            expected.unreachableDots++;
+            break;
+        case MapRejection::UNREACHABLE_SPAWN:
+            expected.unreachableSpawns++;
+            break;
+        case MapRejection::NONE:
+            if (!seen.insert(map.saveToString()).second) {
+                expected.duplicates++;
+            } else {
+                expected.accepted++;
+                expectedAccepted.emplace_back(seed, map.saveToString());
+            }
+            break;
+        }
+    }
+
+    if (stats.generated != expected.generated || stats.accepted != expected.accepted ||
+        stats.noSpawn != expected.noSpawn || stats.unreachableDots != expected.unreachableDots ||
+        stats.unreachableSpawns != expected.unreachableSpawns || stats.duplicates != expected.duplicates ||
+        accepted != expectedAccepted) {
+        std::fprintf(stderr, "map batch: accepted %lld/%lld, duplicates %lld/%lld\n", stats.accepted,
+                     expected.accepted, stats.duplicates, expected.duplicates);
+        ++failures;
+    }
+    // 5x5 的地图种类很少，去重路径一定会被覆盖
+    if (expected.duplicates == 0) ++failures;
+
+    // 生成器产生的地图总是连通的，出生点不连通用一堵墙隔开的地图检查：左半边有一颗豆子
+    GameMap split(15, 7);
+    for (int y = 1; y < 6; ++y) {
+        for (int x = 1; x < 14; ++x) split.setCell(x, y, x == 7 ? CellType::WALL : CellType::EMPTY);
+    }
+    split.setCell(1, 1, CellType::DOT);
+    int rejections[4] = {};
+    for (unsigned int spawnSeed = 0; spawnSeed < 64; ++spawnSeed) {
+        std::vector<Character> characters = createMatchCharacters(split, 1, spawnSeed);
+        if (characters.size() != 2) {
+            ++failures;
+            continue;
+        }
+        bool pacmanLeft = characters[0].position.x < 7;
+        bool monsterLeft = characters[1].position.x < 7;
+        MapRejection expectedRejection = pacmanLeft != monsterLeft ? MapRejection::UNREACHABLE_SPAWN
+                                         : pacmanLeft              ? MapRejection::NONE
+                                                                   : MapRejection::UNREACHABLE_DOTS;
+        MapRejection rejection = checkMapQuality(split, 1, spawnSeed, connectivity);
+        if (rejection != expectedRejection) ++failures;
+        rejections[static_cast<int>(rejection)]++;
+    }
+    if (rejections[static_cast<int>(MapRejection::UNREACHABLE_SPAWN)] == 0 ||
+        rejections[static_cast<int>(MapRejection::UNREACHABLE_DOTS)] == 0) {
+        ++failures;
+    }
+
+    std::fprintf(stderr, "map batch: %d failures\n", failures);
+    return failures;
+}
+
+// 并行决策：每回合的状态指纹必须与串行决策完全一致；在决策线程池自己的工作线程里执行回合也不能死锁
+int verifyParallelDecisions(bool quick) {
+    int failures = 0;
+    int turns = quick ? 200 : 1000;
+    ThreadPool pool(4);
+    const int configs[][2] = {{15, 2}, {31, 4}, {63, 16}};
+    for (const auto &entry : configs) {
+        auto serial = createMatch(makeConfig(entry[0], entry[1]), BENCH_SEED);
+        auto parallel = createMatch(makeConfig(entry[0], entry[1]), BENCH_SEED);
+        if (!serial || !parallel) return failures + 1;
+        parallel->setDecisionPool(&pool);
+
+        int mismatches = 0;
+        pool.submit([&] {
+            for (int turn = 0; turn < turns; ++turn) {
+                serial->executeTurn();
+                parallel->executeTurn();
+                if (hashGameState(serial->getGameState()) != hashGameState(parallel->getGameState())) ++mismatches;
+            }
+        });
+        pool.waitIdle();
+        for (int turn = 0; turn < turns; ++turn) {
+            serial->executeTurn();
+            parallel->executeTurn();
+            if (hashGameState(serial->getGameState()) != hashGameState(parallel->getGameState())) ++mismatches;
+        }
+        if (mismatches > 0) {
+            std::fprintf(stderr, "parallel decisions: %d mismatched turns on %dx%d with %d agents\n", mismatches,
+                         entry[0], entry[0], entry[1]);
+            ++failures;
+        }
+    }
+
+    std::fprintf(stderr, "parallel decisions: %d failures\n", failures);
+    return failures;
+}
+
+// 不检查截止时间的慢 AI：每次决策睡眠固定时间后向右走
+class SleepyAgent : public AIInterface {
+  private:
+    std::chrono::milliseconds sleepTime;
+
+  public:
+    explicit SleepyAgent(int sleepMillis) : sleepTime(sleepMillis) {}
+
+    Action getAction(const VisibleArea &) override {
+        std::this_thread::sleep_for(sleepTime);
+        return Action(Direction::RIGHT);
+    }
+};
+
+// 思考时间预算：预算充足时结果与不限时完全一致；不守时的 AI 每回合记一次超时，回合耗时受预算约束，其他 AI 不受影响
+int verifyThinkBudget(bool quick) {
+    int failures = 0;
+    int turns = quick ? 100 : 500;
+    auto unlimited = createMatch(makeConfig(31, 4), BENCH_SEED);
+    auto budgeted = createMatch(makeConfig(31, 4), BENCH_SEED);
+    if (!unlimited || !budgeted) return 1;
+    budgeted->setThinkTimeBudget(10000);
+    for (int turn = 0; turn < turns; ++turn) {
+        unlimited->executeTurn();
+        budgeted->executeTurn();
+        if (hashGameState(unlimited->getGameState()) != hashGameState(budgeted->getGameState())) ++failures;
+    }
+    for (int i = 0; i < 4; ++i) failures += budgeted->getThinkOverruns(i) != 0 ? 1 : 0;
+
+    const int slowTurns = 5;
+    const int sleepMillis = 200;
+    auto slow = createMatch(makeConfig(31, 4), BENCH_SEED);
+    if (!slow) return failures + 1;
+    slow->setThinkTimeBudget(10);
+    slow->setAIAgent(0, std::make_unique<SleepyAgent>(sleepMillis));
+    Position pacmanStart = slow->getGameState().getCharacters()[0].position;
+    auto startTime = std::chrono::steady_clock::now();
+    for (int turn = 0; turn < slowTurns; ++turn) slow->executeTurn();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    // 第一回合超时，之后的回合上一次决策仍未返回而被跳过；吃豆人始终停在原地
+    if (slow->getThinkOverruns(0) != slowTurns || elapsed > slowTurns * sleepMillis / 2000.0) {
+        std::fprintf(stderr, "think budget: %d overruns in %.3f s for the slow agent\n", slow->getThinkOverruns(0),
+                     elapsed);
+        ++failures;
+    }
+    for (int i = 1; i < 4; ++i) {
+        if (slow->getThinkOverruns(i) != 0) {
+            std::fprintf(stderr, "think budget: agent %d overran %d times\n", i, slow->getThinkOverruns(i));
+            ++failures;
+        }
+    }
+    if (slow->getGameState().getCharacters()[0].position != pacmanStart) ++failures;
+
+    std::fprintf(stderr, "think budget: %d failures\n", failures);
+    return failures;
+}
+
+// 占用索引：随机放置、移动和增删角色（含越界和多人同格），每个格子上的角色链必须与逐个扫描的结果一致
+int verifyOccupancy(bool quick) {
+    int failures = 0;
+    std::mt19937 rng(BENCH_SEED);
+    const int width = 40;
+    const int height = 30;
+    OccupancyGrid grid(width, height);
+    std::vector<Character> characters;
+    auto randomPosition = [&rng]() {
+        return Position{static_cast<int>(rng() % (width + 4)) - 2, static_cast<int>(rng() % (height + 4)) - 2};
+    };
+
+    int rounds = quick ? 2000 : 20000;
+    for (int round = 0; round < rounds; ++round) {
+        int op = static_cast<int>(rng() % 10);
+        if (op == 0 || characters.empty()) {
+            // 角色数量变化，整体重建
+            characters.resize(rng() % 64);
+            for (auto &character : characters) character.position = randomPosition();
+            grid.update(characters);
+        } else if (op < 5) {
+            int index = static_cast<int>(rng() % characters.size());
+            characters[index].position = randomPosition();
+            grid.moveCharacter(index, characters[index].position);
+        } else {
+            // 扎堆到少数几个格子上，覆盖长链和探测冲突
+            for (auto &character : characters) {
+                if (rng() % 3 != 0) continue;
+                character.position = Position{static_cast<int>(rng() % 3), static_cast<int>(rng() % 2)};
+            }
+            grid.update(characters);
+        }
+
+        for (int y = -1; y <= height; ++y) {
+            for (int x = -1; x <= width; ++x) {
+                bool inside = x >= 0 && x < width && y >= 0 && y < height;
+                int index = grid.firstAt(x, y);
+                for (size_t i = 0; i < characters.size() && inside; ++i) {
+                    if (characters[i].position.x != x || characters[i].position.y != y) continue;
+                    if (index != static_cast<int>(i)) {
+                        ++failures;
+                        break;
+                    }
+                    index = grid.nextAt(index);
+                }
+                if (index != -1) ++failures;
+            }
+        }
+    }
+    std::fprintf(stderr, "occupancy: %d failures\n", failures);
+    return failures;
+}
+
+// 延迟直方图：桶边界首尾相接，分位数与精确排序结果的相对误差不超过 1/32，合并与整体记录一致；
+// 启用剖析时剖析器不改变对局结果，且每回合每个阶段恰好一个样本
+int verifyProfiling(bool quick) {
+    int failures = 0;
+    for (int i = 0; i + 1 < LatencyHistogram::BUCKET_COUNT; ++i) {
+        uint64_t lower = LatencyHistogram::bucketLowerBound(i);
+        uint64_t upper = LatencyHistogram::bucketUpperBound(i);
+        if (LatencyHistogram::bucketIndex(lower) != i || LatencyHistogram::bucketIndex(upper) != i ||
+            LatencyHistogram::bucketLowerBound(i + 1) != upper + 1) {
+            ++failures;
+        }
+    }
+
+    std::mt19937_64 rng(BENCH_SEED);
+    int samples = quick ? 20000 : 200000;
+    std::vector<uint64_t> values;
+    LatencyHistogram whole;
+    LatencyHistogram halves[2];
+    for (int i = 0; i < samples; ++i) {
+        // 对数均匀分布，覆盖从精确桶到 2^40 的全部分段
+        uint64_t value = rng() >> (24 + rng() % 40);
+        values.push_back(value);
+        whole.record(value);
+        halves[i & 1].record(value);
+    }
+    halves[0].merge(halves[1]);
+    std::sort(values.begin(), values.end());
+    if (whole.getCount() != values.size() || whole.getMin() != values.front() || whole.getMax() != values.back()) {
+        ++failures;
+    }
+    for (double quantile : {0.0, 0.1, 0.5, 0.9, 0.99, 0.999, 1.0}) {
+        size_t rank = std::max<size_t>(1, static_cast<size_t>(std::ceil(quantile * static_cast<double>(samples))));
+        uint64_t exact = values[rank - 1];
+        uint64_t estimate = whole.percentile(quantile);
+        if (estimate < exact || estimate - exact > exact / LatencyHistogram::SUB_BUCKET_COUNT) {
+            std::fprintf(stderr, "histogram: p%g estimate %llu, exact %llu\n", quantile * 100.0,
+                         static_cast<unsigned long long>(estimate), static_cast<unsigned long long>(exact));
+            ++failures;
+        }
+        if (halves[0].percentile(quantile) != estimate) ++failures;
+    }
+
+    if (TurnProfiler::ENABLED) {
+        int turns = quick ? 100 : 500;
+        auto plain = createMatch(makeConfig(31, 4), BENCH_SEED);
+        auto profiled = createMatch(makeConfig(31, 4), BENCH_SEED);
+        if (!plain || !profiled) return failures + 1;
+        TurnProfiler profiler;
+        profiled->setProfiler(&profiler);
+        int played = 0;
+        for (int turn = 0; turn < turns; ++turn) {
+            bool running = plain->executeTurn();
+            profiled->executeTurn();
+            ++played;
+            if (hashGameState(plain->getGameState()) != hashGameState(profiled->getGameState())) ++failures;
+            if (!running) break;
+        }
+        for (int phase = TurnProfiler::COLLECT; phase < TurnProfiler::PHASE_COUNT; ++phase) {
+            if (profiler.getPhase(static_cast<TurnProfiler::Phase>(phase)).getCount() !=
+                static_cast<uint64_t>(played)) {
+                ++failures;
+            }
+        }
+        if (profiler.getAgentCount() != 4 ||
+            profiler.getPhase(TurnProfiler::DECISION).getCount() != static_cast<uint64_t>(played) * 4) {
+            ++failures;
+        }
+    }
+
+    std::fprintf(stderr, "profiling: %d failures\n", failures);
+    return failures;
+}
+
+// 时间线追踪：安装追踪器不改变对局结果；并行决策时视野和决策区间分布在多个线程上，
+// 每回合恰好有 turn/collect/management/recording 各一个区间、每个角色各一个 view/decision 区间
+int verifyTrace(bool quick) {
+    int failures = 0;
+    int turns = quick ? 100 : 500;
+    const int agents = 4;
+    auto plain = createMatch(makeConfig(31, agents), BENCH_SEED);
+    auto traced = createMatch(makeConfig(31, agents), BENCH_SEED);
+    if (!plain || !traced) return 1;
+    ThreadPool pool(2);
+    traced->setDecisionPool(&pool);
+
+    TraceRecorder recorder;
+    TraceRecorder::install(&recorder);
+    int played = 0;
+    for (int turn = 0; turn < turns; ++turn) {
+        bool running = plain->executeTurn();
+        traced->executeTurn();
+        ++played;
+        if (hashGameState(plain->getGameState()) != hashGameState(traced->getGameState())) ++failures;
+        if (!running) break;
+    }
+    TraceRecorder::install(nullptr);
+    pool.waitIdle();
+
+    // 追踪器是全局的，两个游戏循环的回合都会被记录
+    size_t expected = 2 * static_cast<size_t>(played) * (4 + 2 * agents);
+    std::string json = recorder.toJson();
+    size_t spans = 0;
+    const std::string spanMarker = "\"ph\": \"X\"";
+    for (size_t pos = json.find(spanMarker); pos != std::string::npos; pos = json.find(spanMarker, pos + 1)) {
+        ++spans;
+    }
+    if (recorder.getEventCount() != expected || spans != expected || recorder.getDroppedCount() != 0) {
+        std::fprintf(stderr, "trace: %zu events, %zu spans in JSON, expected %zu\n", recorder.getEventCount(), spans,
+                     expected);
+        ++failures;
+    }
+
+    // 超出每线程上限的事件只计数
+    TraceRecorder small(10);
+    TraceRecorder::install(&small);
+    for (int i = 0; i < 15; ++i) TraceSpan span("span", "test");
+    TraceRecorder::install(nullptr);
+    if (small.getEventCount() != 10 || small.getDroppedCount() != 5) ++failures;
+
+    std::fprintf(stderr, "trace: %d failures\n", failures);
+    return failures;
+}
+
+// 吃豆并处理碰撞的管理系统：吃豆人吃掉所在格子的豆子，怪物撞上吃豆人时得分并退回原位，对局继续。
+// 吃豆会写入与历史记录共享的地图分块，触发写时复制
+class DotEatingManagement : public ManagementSystem {
+  private:
+    std::vector<Character> previous; // 本回合移动前的角色，跨回合复用
+
+  public:
+    bool processActions(const std::vector<Action> &actions, GameStateManager &gameState) override {
+        previous = gameState.getCharacters();
+        if (!ManagementSystem::processActions(actions, gameState)) return false;
+
+        const std::vector<Character> &characters = gameState.getCharacters();
+        for (size_t i = 0; i < characters.size(); ++i) {
+            if (characters[i].type != CharacterType::PACMAN) continue;
+            if (gameState.getMap().hasDot(characters[i].position)) {
+                gameState.consumeDot(characters[i].position);
+                gameState.incrementPacmanScore(1);
+            }
+            for (size_t j = 0; j < characters.size(); ++j) {
+                if (characters[j].type == CharacterType::MONSTER && characters[j].position == characters[i].position) {
+                    gameState.incrementMonsterScore(10);
+                    gameState.updateCharacterPosition(static_cast<int>(j), previous[j].position);
+                }
+            }
+        }
+        return true;
+    }
+};
+
+// 稳定回合的堆分配：历史记录的环形缓冲区预热之后，串行决策的回合一次都不分配。
+// 吃豆子的回合仍会写时复制被改动的分块，但复制用的是历史淘汰后回到地图分块池的空闲分块
+int verifyAllocationFreeTurns(bool quick) {
+    int failures = 0;
+    const int warmupTurns = 300;
+    int measuredTurns = quick ? 200 : 600;
+    for (int size : {63, 127}) {
+        for (int agents : {2, 8}) {
+            MatchConfig config = makeConfig(size, agents);
+            config.maxTurns = warmupTurns + measuredTurns;
+            auto gameLoop = createMatch(config, BENCH_SEED);
+            if (!gameLoop) {
+                ++failures;
+                continue;
+            }
+            gameLoop->setManagementSystem(std::make_unique<DotEatingManagement>());
+            for (int turn = 0; turn < warmupTurns; ++turn) gameLoop->executeTurn();
+
+            GameMap previousMap = gameLoop->getGameState().getMap();
+            int copiedTiles = 0;
+            int badTurns = 0;
+            for (int turn = 0; turn < measuredTurns; ++turn) {
+                previousMap = gameLoop->getGameState().getMap();
+                uint64_t before = AllocCounter::allocationCount();
+                gameLoop->executeTurn();
+                uint64_t allocs = AllocCounter::allocationCount() - before;
+
+                const GameMap &map = gameLoop->getGameState().getMap();
+                int changedTiles = 0;
+                for (int tile = 0; tile < map.getTileCount(); ++tile) {
+                    if (!map.sharesTile(previousMap, tile)) ++changedTiles;
+                }
+                copiedTiles += changedTiles;
+                if (allocs != 0) ++badTurns;
+            }
+            // 没有吃到任何豆子时写时复制路径没有被覆盖，同样算失败
+            if (badTurns != 0 || copiedTiles == 0) {
+                std::fprintf(stderr, "allocation-free turns: size %d, %d agents: %d bad turns, %d tile copies\n", size,
+                             agents, badTurns, copiedTiles);
+                ++failures;
+            }
+        }
+    }
+    std::fprintf(stderr, "allocation-free turns: %d failures\n", failures);
+    return failures;
+}
+
+// 按旧版存档格式写文件（size_t 长度 + 文本地图、分数、Character 结构体转储），用于检查兼容加载
+void writeLegacySave(const GameStateManager &gameState, const std::string &filename) {
+    std::ofstream file(filename, std::ios::binary);
+    std::string mapData = gameState.getMap().saveToString();
+    size_t mapSize = mapData.size();
+    file.write(reinterpret_cast<const char *>(&mapSize), sizeof(mapSize));
+    file.write(mapData.c_str(), mapSize);
+    int scores[3] = {gameState.getPacmanScore(), gameState.getMonsterScore(), gameState.getRemainingDots()};
+    file.write(reinterpret_cast<const char *>(scores), sizeof(scores));
+    size_t charCount = gameState.getCharacters().size();
+    file.write(reinterpret_cast<const char *>(&charCount), sizeof(charCount));
+    for (const auto &character : gameState.getCharacters()) {
+        file.write(reinterpret_cast<const char *>(&character), sizeof(Character));
+    }
+}
+
+// 存档往返后状态指纹（含回合数和剩余豆子）必须一致；任意翻转一个字节或截断都必须被拒绝
+int verifySave(bool quick) {
+    int failures = 0;
+    std::string filename = "pacman_bench_verify.tmp";
+    for (int size : {7, 31, 65, 96, 255}) {
+        auto gameLoop = createMatch(makeConfig(size, 4), BENCH_SEED);
+        if (!gameLoop) continue;
+        GameStateManager &gameState = gameLoop->getGameState();
+        for (int turn = 0; turn < 37; ++turn) {
+            gameLoop->executeTurn();
+            gameState.consumeDot(gameState.getPacman().position);
+        }
+        uint64_t expected = hashGameState(gameState);
+
+        GameControlSystem control;
+        GameStateManager loaded;
+        if (!control.saveGame(gameState, filename) || !control.loadGame(loaded, filename) ||
+            hashGameState(loaded) != expected) {
+            std::fprintf(stderr, "save: round trip mismatch on %dx%d\n", size, size);
+            ++failures;
+        }
+        // 解码时直接生成的位平面必须与逐格写入得到的一致
+        const GameMap &original = gameState.getMap();
+        const GameMap &decoded = loaded.getMap();
+        for (int y = 0; y < original.getHeight() && decoded.getHeight() == original.getHeight(); ++y) {
+            size_t rowBytes = static_cast<size_t>(original.getWordsPerRow()) * sizeof(uint64_t);
+            if (std::memcmp(original.getWallBitsRow(y), decoded.getWallBitsRow(y), rowBytes) != 0 ||
+                std::memcmp(original.getDotBitsRow(y), decoded.getDotBitsRow(y), rowBytes) != 0) {
+                ++failures;
+            }
+        }
+
+        std::vector<uint8_t> bytes = StateCodec::encodeSaveFile(gameState);
+        size_t step = quick ? bytes.size() / 64 + 1 : 1;
+        for (size_t i = 0; i < bytes.size(); i += step) {
+            std::vector<uint8_t> corrupted = bytes;
+            corrupted[i] ^= 0x20;
+            if (StateCodec::decodeSaveFile(corrupted.data(), corrupted.size(), loaded)) ++failures;
+        }
+        for (size_t length = 0; length < bytes.size(); length += step) {
+            if (StateCodec::decodeSaveFile(bytes.data(), length, loaded)) ++failures;
+        }
+
+        // 旧版存档不含回合数，只比较地图、角色和分数
+        writeLegacySave(gameState, filename);
+        if (!control.loadGame(loaded, filename) || loaded.getRemainingDots() != gameState.getRemainingDots() ||
+            loaded.getMap().saveToString() != gameState.getMap().saveToString() ||
+            loaded.getCharacters().size() != gameState.getCharacters().size() ||
+            loaded.getMonsterScore() != gameState.getMonsterScore()) {
+            std::fprintf(stderr, "save: legacy load mismatch on %dx%d\n", size, size);
+            ++failures;
+        }
+    }
+
+    // 宽为 0 的地图可以存档和录制，读回后尺寸不变；超出 MAX_MAP_DIMENSION 的地图写入时就被拒绝
+    GameControlSystem control;
+    GameStateManager emptyRows(GameMap(0, 5), {});
+    GameStateManager loaded;
+    if (!control.saveGame(emptyRows, filename) || !control.loadGame(loaded, filename) ||
+        loaded.getMap().getWidth() != 0 || loaded.getMap().getHeight() != 5) {
+        std::fprintf(stderr, "save: 0x5 map round trip failed\n");
+        ++failures;
+    }
+    ReplayRecorder recorder(BENCH_SEED);
+    recorder.begin(emptyRows);
+    ReplayPlayer player;
+    if (!recorder.isStarted() || !player.loadFromBuffer(recorder.serialize()) || !player.seek(0, loaded) ||
+        loaded.getMap().getHeight() != 5) {
+        std::fprintf(stderr, "save: 0x5 map replay failed\n");
+        ++failures;
+    }
+    GameStateManager oversized(GameMap(StateCodec::MAX_MAP_DIMENSION + 1, 1), {});
+    std::remove(filename.c_str());
+    recorder.begin(oversized);
+    if (control.saveGame(oversized, filename) || !StateCodec::encodeSaveFile(oversized).empty() ||
+        recorder.isStarted()) {
+        std::fprintf(stderr, "save: oversized map was written\n");
+        ++failures;
+    }
+    std::remove(filename.c_str());
+
+    std::fprintf(stderr, "save: %d failures\n", failures);
+    return failures;
+}
+
+void printUsage(const char *program) {
+    std::fprintf(stderr,
+                 "Usage: %s [options]\n"
+                 "  --filter SUBSTR  only run benchmarks whose name contains SUBSTR\n"
+                 "  --min-time SEC   minimum measured time per benchmark (default 0.2)\n"
+                 "  --quick          fewer parameter combinations\n"
+                 "  --verify         compare optimized paths against reference implementations and exit\n",
+                 program);
+}
+
+bool parseOptions(int argc, char **argv, BenchOptions &options) {
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        if (std::strcmp(arg, "--quick") == 0) {
+            options.quick = true;
+        } else if (std::strcmp(arg, "--verify") == 0) {
+            options.verify = true;
+        } else if (std::strcmp(arg, "--filter") == 0 && i + 1 < argc) {
+            options.filter = argv[++i];
+        } else if (std::strcmp(arg, "--min-time") == 0 && i + 1 < argc) {
+            options.minTime = std::atof(argv[++i]);
+            if (options.minTime <= 0.0) return false;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (options.verify) {
+        int failures = verifyVisibility(options.quick);
+        failures += verifyHistory(options.quick);
+        failures += verifyReplay(options.quick);
+        failures += verifySeedParsing();
+        failures += verifySave(options.quick);
+        failures += verifyOccupancy(options.quick);
+        failures += verifyMapText();
+        failures += verifyMapPack();
+        failures += verifyConnectivity(options.quick);
+        failures += verifySpawnPlacement(options.quick);
+        failures += verifyMapBatch(options.quick);
+        failures += verifyParallelDecisions(options.quick);
+        failures += verifyThinkBudget(options.quick);
+        failures += verifyProfiling(options.quick);
+        failures += verifyTrace(options.quick);
+        failures += verifyAllocationFreeTurns(options.quick);
+        return failures == 0 ? 0 : 1;
+    }
+
+    std::vector<int> sizes = options.quick ? std::vector<int>{15, 63} : std::vector<int>{15, 31, 63, 127, 255};
+    std::vector<int> agentCounts = options.quick ? std::vector<int>{2, 8} : std::vector<int>{2, 4, 8, 16, 64};
+
+    BenchRunner runner(options);
+    benchVisibility(runner, sizes, agentCounts);
+    benchMap(runner, sizes);
+    benchBitplanes(runner, options.quick ? std::vector<int>{15, 256} : std::vector<int>{15, 256, 4096});
+    benchManagement(runner, agentCounts);
+    benchControl(runner, sizes);
+    benchReplay(runner, sizes);
+    benchSave(runner, sizes);
+    benchMapPack(runner, sizes);
+    benchGenerator(runner, sizes);
+    benchTurn(runner, sizes, agentCounts);
+    benchProfiler(runner, sizes);
+    benchDecisions(runner);
+
+    runner.printJson();
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include "../../include/map_batch_generator.h"
+#include "../../include/state_codec.h"
+#include "../../include/trace_recorder.h"
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+// 批量地图生成：在线程池上并行生成、检查并去重，把通过检查的地图流式写入地图包
+// 用法：pacman_mapgen --output FILE [--count N] [--seed S] [--width W] [--height H] [--monsters M]
+//                     [--threads N] [--no-dedup] [--trace FILE]
+
+namespace {
+
+struct MapgenOptions {
+    std::string output;
+    MapBatchConfig batch;
+    std::string traceFile; // 非空时把各线程的生成、检查和汇总时间线写入该文件
+};
+
+void printUsage(const char *program) {
+    std::printf("Usage: %s --output FILE [options]\n"
+                "  --output FILE   map pack to write\n"
+                "  --count N       number of seeds to generate (default 1000)\n"
+                "  --seed S        first match seed, seed i is S + i (default 1)\n"
+                "  --width W       map width, 5 to %d (default %d)\n"
+                "  --height H      map height, 5 to %d (default %d)\n"
+                "  --monsters M    monster count used for the spawn check (default %d)\n"
+                "  --threads N     worker threads, 0 = all cores (default 0)\n"
+                "  --no-dedup      keep maps whose content repeats an earlier seed\n"
+                "  --trace FILE    write a Chrome trace-event timeline of the workers to FILE\n",
+                program, StateCodec::MAX_MAP_DIMENSION, GameConfig::MAP_WIDTH, StateCodec::MAX_MAP_DIMENSION,
+                GameConfig::MAP_HEIGHT, GameConfig::MONSTER_COUNT);
+}
+
+// 只接受 [minValue, maxValue] 内的十进制整数，超出范围时报错而不是截断
+bool parseInt(const char *text, long long minValue, long long maxValue, long long &value) {
+    char *end = nullptr;
+    value = std::strtoll(text, &end, 10);
+    return end != text && *end == '\0' && value >= minValue && value <= maxValue;
+}
+
+bool parseOptions(int argc, char **argv, MapgenOptions &options) {
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        if (std::strcmp(arg, "--no-dedup") == 0) {
+            options.batch.deduplicate = false;
+            continue;
+        }
+        if (std::strcmp(arg, "--help") == 0 || i + 1 >= argc) {
+            return false;
+        }
+
+        long long value = 0;
+        const char *text = argv[++i];
+        if (std::strcmp(arg, "--output") == 0) {
+            options.output = text;
+        } else if (std::strcmp(arg, "--count") == 0 && parseInt(text, 1, LLONG_MAX, value)) {
+            options.batch.seedCount = value;
+        } else if (std::strcmp(arg, "--seed") == 0 && parseInt(text, 0, LLONG_MAX, value)) {
+            options.batch.baseSeed = static_cast<uint64_t>(value);
+        } else if (std::strcmp(arg, "--width") == 0 && parseInt(text, 5, StateCodec::MAX_MAP_DIMENSION, value)) {
+            options.batch.width = static_cast<int>(value);
+        } else if (std::strcmp(arg, "--height") == 0 && parseInt(text, 5, StateCodec::MAX_MAP_DIMENSION, value)) {
+            options.batch.height = static_cast<int>(value);
+        } else if (std::strcmp(arg, "--monsters") == 0 && parseInt(text, 0, INT_MAX, value)) {
+            options.batch.monsterCount = static_cast<int>(value);
+        } else if (std::strcmp(arg, "--threads") == 0 && parseInt(text, 0, INT_MAX, value)) {
+            options.batch.threadCount = static_cast<int>(value);
+        } else if (std::strcmp(arg, "--trace") == 0) {
+            options.traceFile = text;
+        } else {
+            return false;
+        }
+    }
+    return !options.output.empty();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    MapgenOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    std::unique_ptr<TraceRecorder> tracer;
+    if (!options.traceFile.empty()) {
+        tracer = std::make_unique<TraceRecorder>();
+        TraceRecorder::install(tracer.get());
+        tracer->setThreadName("main");
+    }
+
+    MapBatchGenerator generator(options.batch);
+    MapBatchStats stats;
+    if (!generator.writePack(options.output, stats)) {
+        std::fprintf(stderr, "cannot write map pack %s\n", options.output.c_str());
+        return 1;
+    }
+
+    if (tracer) {
+        TraceRecorder::install(nullptr);
+        if (!tracer->writeFile(options.traceFile)) {
+            std::fprintf(stderr, "cannot write trace %s\n", options.traceFile.c_str());
+            return 1;
+        }
+    }
+
+    std::printf("mapgen generated=%lld accepted=%lld rejected_unreachable=%lld rejected_unreachable_spawn=%lld "
+                "rejected_no_spawn=%lld duplicates=%lld threads=%d elapsed_sec=%.3f maps_per_sec=%.1f\n",
+                stats.generated, stats.accepted, stats.unreachableDots, stats.unreachableSpawns, stats.noSpawn,
+                stats.duplicates, stats.threadCount, stats.elapsedSeconds, stats.mapsPerSecond());
+    return 0;
+}
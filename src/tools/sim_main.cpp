@@ -0,0 +1,456 @@
+#include "../../include/alloc_counter.h"
+#include "../../include/map_pack.h"
+#include "../../include/match_runner.h"
+#include "../../include/match_seed.h"
+#include "../../include/replay.h"
+#include "../../include/state_codec.h"
+#include "../../include/thread_pool.h"
+#include "../../include/tournament_runner.h"
+#include "../../include/trace_recorder.h"
+#include "../../include/turn_profiler.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+// 无界面模拟器：不经过窗口和定时器，直接驱动 TurnBasedGameLoop::executeTurn()
+// 用法：pacman_sim [--matches N] [--seed S] [--max-turns T] [--width W] [--height H] [--monsters M]
+//                  [--threads N] [--agent-threads N] [--think-ms N] [--quiet] [--record PREFIX]
+//                  [--map-pack FILE] [--profile FILE] [--trace FILE] [--count-allocs] [--visibility-cache]
+//       pacman_sim --replay FILE [--turn N]
+//       pacman_sim --write-map-pack FILE [--matches N] [--seed S] [--width W] [--height H]
+// 指定 --threads 时以锦标赛模式在线程池上并行运行，只输出汇总统计
+// --agent-threads 在顺序模式下把每回合各 AI 的决策放到线程池上并发执行，结果与串行决策一致
+// --record 为每局写一个行动日志回放文件；--replay 从回放文件重建第 N 回合并输出状态指纹
+// --profile 把所有对局各阶段、各角色的耗时直方图汇总写成 JSON（.csv 结尾时为 CSV），需要 PACMAN_ENABLE_PROFILING 构建
+// --trace 把每局、每回合及其各阶段的时间线写成 Chrome trace-event JSON（Perfetto 可直接打开），锦标赛模式也可用
+// --count-allocs 逐回合统计堆分配，并给出最后一个有分配的回合（预热结束的位置）
+// --visibility-cache 开局时预计算视野缓存，回合更快但每个可走格子多占约 136 字节
+// --write-map-pack 把这些种子的地图写成地图包后退出，之后用 --map-pack 直接读取而不必重新生成
+
+namespace {
+
+struct SimOptions {
+    int matches;
+    unsigned long long seed;
+    int threads;      // -1 表示顺序执行
+    int agentThreads; // -1 表示每回合串行决策
+    bool quiet;
+    bool countAllocs;
+    MatchConfig match;
+    std::string recordPrefix; // 非空时每局写入 PREFIX<种子>.replay
+    std::string replayFile;   // 非空时只回放该文件
+    int replayTurn;           // -1 表示最后一回合
+    std::string mapPackFile;  // 非空时优先从该地图包取地图
+    std::string writeMapPack; // 非空时只生成地图包
+    std::string profileFile;  // 非空时记录回合耗时并写入该文件
+    std::string traceFile;    // 非空时记录时间线并写入该文件
+
+    SimOptions() : matches(1), seed(1), threads(-1), agentThreads(-1), quiet(false), countAllocs(false), replayTurn(-1) {}
+};
+
+void printUsage(const char *program) {
+    std::printf("Usage: %s [options]\n"
+                "  --matches N     number of matches to play (default 1)\n"
+                "  --seed S        base match seed (decimal or 0x hex), match i uses S + i (default 1)\n"
+                "  --max-turns T   turn limit per match, reaching it is a draw (default 1000)\n"
+                "  --width W       map width, 5 to %d (default %d)\n"
+                "  --height H      map height, 5 to %d (default %d)\n"
+                "  --monsters M    monster count (default %d)\n"
+                "  --threads N     run as a parallel tournament on N worker threads (0 = all cores)\n"
+                "  --agent-threads N\n"
+                "                  decide all agents of a turn concurrently on N threads (0 = all cores,\n"
+                "                  sequential mode)\n"
+                "  --think-ms N    AI think-time budget per turn in ms, late decisions become STAY\n"
+                "                  (default: unlimited; results then depend on timing)\n"
+                "  --quiet         only print the summary line\n"
+                "  --count-allocs  count heap allocations per turn and report the last turn that allocated\n"
+                "                  (sequential mode)\n"
+                "  --visibility-cache\n"
+                "                  precompute visibility masks per map (faster turns, about 136 bytes per\n"
+                "                  walkable cell)\n"
+                "  --record PREFIX write an action-log replay per match to PREFIX<seed>.replay (sequential mode)\n"
+                "  --replay FILE   rebuild a turn from a replay file and print its state hash\n"
+                "  --turn N        turn to rebuild with --replay (default: last turn)\n"
+                "  --map-pack FILE take maps from a map pack when it has the match seed\n"
+                "  --profile FILE  write per-phase and per-agent turn latency histograms to FILE (JSON, or CSV\n"
+                "                  when FILE ends in .csv; sequential mode, needs PACMAN_ENABLE_PROFILING)\n"
+                "  --trace FILE    write a Chrome trace-event timeline of matches, turns and phases to FILE\n"
+                "                  (open it in Perfetto; also works with --threads)\n"
+                "  --write-map-pack FILE\n"
+                "                  write the maps of the selected seeds to a map pack and exit\n",
+                program, StateCodec::MAX_MAP_DIMENSION, GameConfig::MAP_WIDTH, StateCodec::MAX_MAP_DIMENSION,
+                GameConfig::MAP_HEIGHT, GameConfig::MONSTER_COUNT);
+}
+
+// 只接受 [minValue, maxValue] 内的十进制整数，超出范围时报错而不是截断
+bool parseInt(const char *text, long minValue, long maxValue, long &value) {
+    char *end = nullptr;
+    value = std::strtol(text, &end, 10);
+    return end != text && *end == '\0' && value >= minValue && value <= maxValue;
+}
+
+bool parseOptions(int argc, char **argv, SimOptions &options) {
+    for (int i = 1; i < argc; ++i) {
+        const char *arg = argv[i];
+        if (std::strcmp(arg, "--quiet") == 0) {
+            options.quiet = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--count-allocs") == 0) {
+            options.countAllocs = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--visibility-cache") == 0) {
+            options.match.visibilityCache = true;
+            continue;
+        }
+        if (std::strcmp(arg, "--help") == 0 || i + 1 >= argc) {
+            return false;
+        }
+
+        long value = 0;
+        uint64_t seed = 0;
+        const char *text = argv[++i];
+        if (std::strcmp(arg, "--matches") == 0 && parseInt(text, 1, INT_MAX, value)) {
+            options.matches = static_cast<int>(value);
+        } else if (std::strcmp(arg, "--seed") == 0 && parseMatchSeed(text, seed)) {
+            options.seed = seed;
+        } else if (std::strcmp(arg, "--max-turns") == 0 && parseInt(text, 1, INT_MAX, value)) {
+            options.match.maxTurns = static_cast<int>(value);
+        } else if (std::strcmp(arg, "--width") == 0 && parseInt(text, 5, StateCodec::MAX_MAP_DIMENSION, value)) {
+            options.match.mapWidth = static_cast<int>(value);
+        } else if (std::strcmp(arg, "--height") == 0 && parseInt(text, 5, StateCodec::MAX_MAP_DIMENSION, value)) {
+            options.match.mapHeight = static_cast<int>(value);
+        } else if (std::strcmp(arg, "--monsters") == 0 && parseInt(text, 0, INT_MAX, value)) {
+            options.match.monsterCount = static_cast<int>(value);
+        } else if (std::strcmp(arg, "--threads") == 0 && parseInt(text, 0, INT_MAX, value)) {
+            options.threads = static_cast<int>(value);
+        } else if (std::strcmp(arg, "--agent-threads") == 0 && parseInt(text, 0, INT_MAX, value)) {
+            options.agentThreads = static_cast<int>(value);
+        } else if (std::strcmp(arg, "--think-ms") == 0 && parseInt(text, 1, INT_MAX, value)) {
+            options.match.thinkTimeMs = static_cast<int>(value);
+        } else if (std::strcmp(arg, "--record") == 0) {
+            options.recordPrefix = text;
+        } else if (std::strcmp(arg, "--replay") == 0) {
+            options.replayFile = text;
+        } else if (std::strcmp(arg, "--turn") == 0 && parseInt(text, 0, INT_MAX, value)) {
+            options.replayTurn = static_cast<int>(value);
+        } else if (std::strcmp(arg, "--map-pack") == 0) {
+            options.mapPackFile = text;
+        } else if (std::strcmp(arg, "--write-map-pack") == 0) {
+            options.writeMapPack = text;
+        } else if (std::strcmp(arg, "--profile") == 0) {
+            options.profileFile = text;
+        } else if (std::strcmp(arg, "--trace") == 0) {
+            options.traceFile = text;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+int runWriteMapPack(const SimOptions &options) {
+    MapPackWriter writer;
+    if (!writer.open(options.writeMapPack)) {
+        std::fprintf(stderr, "cannot write map pack %s\n", options.writeMapPack.c_str());
+        return 1;
+    }
+
+    MatchConfig config = options.match;
+    config.visibilityCache = false;
+    auto startTime = std::chrono::steady_clock::now();
+    for (int i = 0; i < options.matches; ++i) {
+        uint64_t matchSeed = options.seed + static_cast<uint64_t>(i);
+        MatchSeeds seeds = deriveMatchSeeds(matchSeed, 1 + config.monsterCount);
+        writer.add(matchSeed, generateMatchMap(config, seeds));
+    }
+    if (!writer.finish()) {
+        std::fprintf(stderr, "cannot write map pack %s\n", options.writeMapPack.c_str());
+        return 1;
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    std::printf("map_pack maps=%d width=%d height=%d elapsed_sec=%.3f\n", writer.getMapCount(), config.mapWidth,
+                config.mapHeight, elapsed);
+    return 0;
+}
+
+int runTournament(const SimOptions &options, const MapPack *mapPack) {
+    TournamentConfig config;
+    config.baseSeed = options.seed;
+    config.seedCount = options.matches;
+    config.threadCount = options.threads;
+    config.match = options.match;
+    config.mapPack = mapPack;
+
+    TournamentRunner runner(config);
+    TournamentResult result = runner.run();
+
+    for (const auto &stats : result.pairings) {
+        double matches = stats.matches > 0 ? static_cast<double>(stats.matches) : 1.0;
+        std::printf("pairing pacman=%s monster=%s matches=%d pacman_wins=%d monster_wins=%d draws=%d failed=%d "
+                    "avg_turns=%.1f min_turns=%d max_turns=%d avg_pacman_score=%.1f avg_monster_score=%.1f\n",
+                    stats.pacmanAgent.c_str(), stats.monsterAgent.c_str(), stats.matches, stats.pacmanWins,
+                    stats.monsterWins, stats.draws, stats.failedSetups, stats.totalTurns / matches, stats.minTurns,
+                    stats.maxTurns, stats.totalPacmanScore / matches, stats.totalMonsterScore / matches);
+        if (options.match.thinkTimeMs > 0) {
+            std::printf("think_overruns pacman=%s monster=%s pacman_turns=%lld monster_turns=%lld\n",
+                        stats.pacmanAgent.c_str(), stats.monsterAgent.c_str(), stats.pacmanThinkOverruns,
+                        stats.monsterThinkOverruns);
+        }
+    }
+
+    std::printf("summary matches=%d threads=%d turns=%lld elapsed_sec=%.3f matches_per_sec=%.1f turns_per_sec=%.0f\n",
+                result.totalMatches, result.threadCount, result.totalTurns, result.elapsedSeconds,
+                result.matchesPerSecond(),
+                result.elapsedSeconds > 0.0 ? static_cast<double>(result.totalTurns) / result.elapsedSeconds : 0.0);
+
+    return 0;
+}
+
+int runReplay(const SimOptions &options) {
+    ReplayPlayer player;
+    if (!player.loadFromFile(options.replayFile)) {
+        std::fprintf(stderr, "cannot load replay %s\n", options.replayFile.c_str());
+        return 1;
+    }
+
+    int turn = options.replayTurn < 0 ? player.getTurnCount() : options.replayTurn;
+    GameStateManager gameState;
+    auto startTime = std::chrono::steady_clock::now();
+    if (!player.seek(turn, gameState)) {
+        std::fprintf(stderr, "turn %d is outside the replay (0..%d)\n", turn, player.getTurnCount());
+        return 1;
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    std::printf("replay seed=%llu turns=%d keyframes=%d turn=%d pacman_score=%d monster_score=%d remaining_dots=%d "
+                "state_hash=%016llx seek_ms=%.3f\n",
+                static_cast<unsigned long long>(player.getMatchSeed()), player.getTurnCount(),
+                player.getKeyframeCount(), turn, gameState.getPacmanScore(), gameState.getMonsterScore(),
+                gameState.getRemainingDots(), static_cast<unsigned long long>(hashGameState(gameState)),
+                elapsed * 1000.0);
+    return 0;
+}
+
+// 堆分配统计：setup 为取地图和装配对局，其余按回合统计；
+// 历史记录的环形缓冲区等在前若干回合逐步预热，之后的回合应当不再分配内存
+struct AllocStats {
+    uint64_t setup;
+    uint64_t turns;
+    uint64_t turnAllocs;
+    uint64_t allocatingTurns; // 有分配的回合数
+    int lastAllocatingTurn;   // 最后一个有分配的回合（多局时取最大），之后的回合都没有分配
+    uint64_t maxTurnAllocs;   // 单回合的最多分配次数
+
+    AllocStats() : setup(0), turns(0), turnAllocs(0), allocatingTurns(0), lastAllocatingTurn(0), maxTurnAllocs(0) {}
+
+    // 在第 turn 回合结束时调用，lastCount 为上一回合结束时的计数
+    void addTurn(int turn, uint64_t &lastCount) {
+        uint64_t count = AllocCounter::allocationCount();
+        uint64_t allocs = count - lastCount;
+        lastCount = count;
+        turns++;
+        turnAllocs += allocs;
+        if (allocs > 0) {
+            allocatingTurns++;
+            lastAllocatingTurn = turn;
+            maxTurnAllocs = std::max(maxTurnAllocs, allocs);
+        }
+    }
+
+    void merge(const AllocStats &other) {
+        setup += other.setup;
+        turns += other.turns;
+        turnAllocs += other.turnAllocs;
+        allocatingTurns += other.allocatingTurns;
+        lastAllocatingTurn = std::max(lastAllocatingTurn, other.lastAllocatingTurn);
+        maxTurnAllocs = std::max(maxTurnAllocs, other.maxTurnAllocs);
+    }
+
+    void print() const {
+        std::printf("setup=%llu turns=%llu turn_allocs=%llu allocs_per_turn=%.4f allocating_turns=%llu "
+                    "last_allocating_turn=%d max_turn_allocs=%llu\n",
+                    static_cast<unsigned long long>(setup), static_cast<unsigned long long>(turns),
+                    static_cast<unsigned long long>(turnAllocs),
+                    turns > 0 ? static_cast<double>(turnAllocs) / static_cast<double>(turns) : 0.0,
+                    static_cast<unsigned long long>(allocatingTurns), lastAllocatingTurn,
+                    static_cast<unsigned long long>(maxTurnAllocs));
+    }
+};
+
+int runSequential(const SimOptions &options, const MapPack *pack) {
+    // 决策线程池在所有对局之间复用
+    std::unique_ptr<ThreadPool> decisionPool;
+    if (options.agentThreads >= 0) {
+        decisionPool = std::make_unique<ThreadPool>(options.agentThreads);
+    }
+
+    // 所有对局共用一个剖析器，输出的是汇总分布
+    TurnProfiler profiler;
+
+    long long totalTurns = 0;
+    int outcomeCounts[3] = {0, 0, 0};
+    AllocStats totalAllocs;
+    auto startTime = std::chrono::steady_clock::now();
+
+    for (int i = 0; i < options.matches; ++i) {
+        unsigned long long matchSeed = options.seed + static_cast<unsigned long long>(i);
+
+        uint64_t setupStart = AllocCounter::allocationCount();
+        MatchSeeds seeds = deriveMatchSeeds(matchSeed, 1 + options.match.monsterCount);
+        GameMap map = loadMatchMap(options.match, seeds, pack);
+        auto gameLoop = createMatch(map, options.match, seeds, defaultPacmanFactory(), defaultMonsterFactory());
+        if (!gameLoop) {
+            std::fprintf(stderr, "match %d (seed %llu): not enough empty cells for %d characters\n", i, matchSeed,
+                         1 + options.match.monsterCount);
+            return 1;
+        }
+        gameLoop->setDecisionPool(decisionPool.get());
+        if (!options.profileFile.empty()) {
+            gameLoop->setProfiler(&profiler);
+        }
+
+        ReplayRecorder recorder(matchSeed);
+        if (!options.recordPrefix.empty()) {
+            gameLoop->setReplayRecorder(&recorder);
+        }
+
+        AllocStats matchAllocs;
+        TurnCallback countTurn;
+        uint64_t lastCount = 0;
+        if (options.countAllocs) {
+            countTurn = [&matchAllocs, &lastCount](int turn) { matchAllocs.addTurn(turn, lastCount); };
+        }
+        lastCount = AllocCounter::allocationCount();
+        matchAllocs.setup = lastCount - setupStart;
+
+        MatchResult result = runMatch(*gameLoop, options.match.maxTurns, countTurn);
+        if (!options.recordPrefix.empty()) {
+            gameLoop->setReplayRecorder(nullptr);
+            std::string filename = options.recordPrefix + std::to_string(matchSeed) + ".replay";
+            if (!recorder.saveToFile(filename)) {
+                std::fprintf(stderr, "cannot write replay %s\n", filename.c_str());
+                return 1;
+            }
+        }
+        totalTurns += result.turns;
+        outcomeCounts[static_cast<int>(result.outcome)]++;
+        totalAllocs.merge(matchAllocs);
+
+        if (!options.quiet) {
+            std::printf("match=%d seed=%llu outcome=%s turns=%d pacman_score=%d monster_score=%d remaining_dots=%d "
+                        "state_hash=%016llx\n",
+                        i, matchSeed, matchOutcomeToString(result.outcome), result.turns, result.pacmanScore,
+                        result.monsterScore, result.remainingDots,
+                        static_cast<unsigned long long>(result.finalStateHash));
+            if (options.match.thinkTimeMs > 0) {
+                std::printf("think_overruns match=%d pacman_turns=%d monster_turns=%d\n", i,
+                            result.pacmanThinkOverruns, result.monsterThinkOverruns);
+            }
+            if (options.countAllocs) {
+                std::printf("allocs match=%d ", i);
+                matchAllocs.print();
+            }
+        }
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+    std::printf("summary matches=%d pacman_wins=%d monster_wins=%d draws=%d turns=%lld elapsed_sec=%.3f "
+                "turns_per_sec=%.0f\n",
+                options.matches, outcomeCounts[0], outcomeCounts[1], outcomeCounts[2], totalTurns, elapsed,
+                elapsed > 0.0 ? static_cast<double>(totalTurns) / elapsed : 0.0);
+    if (options.countAllocs) {
+        std::printf("allocs total ");
+        totalAllocs.print();
+    }
+
+    if (!options.profileFile.empty()) {
+        if (!profiler.writeFile(options.profileFile)) {
+            std::fprintf(stderr, "cannot write profile %s\n", options.profileFile.c_str());
+            return 1;
+        }
+        const LatencyHistogram &turn = profiler.getPhase(TurnProfiler::TURN);
+        std::printf("profile file=%s turns=%llu turn_p50_ns=%llu turn_p99_ns=%llu turn_max_ns=%llu\n",
+                    options.profileFile.c_str(), static_cast<unsigned long long>(turn.getCount()),
+                    static_cast<unsigned long long>(turn.percentile(0.5)),
+                    static_cast<unsigned long long>(turn.percentile(0.99)),
+                    static_cast<unsigned long long>(turn.getMax()));
+    }
+
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    SimOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    if (!options.replayFile.empty()) {
+        return runReplay(options);
+    }
+    if (!options.writeMapPack.empty()) {
+        return runWriteMapPack(options);
+    }
+
+    MapPack mapPack;
+    if (!options.mapPackFile.empty() && !mapPack.open(options.mapPackFile)) {
+        std::fprintf(stderr, "cannot open map pack %s\n", options.mapPackFile.c_str());
+        return 1;
+    }
+    const MapPack *pack = options.mapPackFile.empty() ? nullptr : &mapPack;
+
+    // 锦标赛模式不录制、不计分配、不做回合内并行决策，给了这些选项时直接报错而不是悄悄忽略
+    if (options.threads >= 0) {
+        const char *sequentialOnly = !options.recordPrefix.empty() ? "--record"
+                                     : options.countAllocs         ? "--count-allocs"
+                                     : options.agentThreads >= 0   ? "--agent-threads"
+                                                                   : nullptr;
+        if (sequentialOnly != nullptr) {
+            std::fprintf(stderr, "%s is only supported in sequential mode\n", sequentialOnly);
+            return 1;
+        }
+    }
+
+    if (!options.profileFile.empty()) {
+        if (!TurnProfiler::ENABLED) {
+            std::fprintf(stderr, "--profile needs a build configured with -DPACMAN_ENABLE_PROFILING=ON\n");
+            return 1;
+        }
+        if (options.threads >= 0) {
+            std::fprintf(stderr, "--profile is only supported in sequential mode\n");
+            return 1;
+        }
+    }
+
+    // 追踪器在所有对局（包括锦标赛的工作线程）结束后卸载并写出
+    std::unique_ptr<TraceRecorder> tracer;
+    if (!options.traceFile.empty()) {
+        tracer = std::make_unique<TraceRecorder>();
+        TraceRecorder::install(tracer.get());
+        tracer->setThreadName("main");
+    }
+
+    int status = options.threads >= 0 ? runTournament(options, pack) : runSequential(options, pack);
+
+    if (tracer) {
+        TraceRecorder::install(nullptr);
+        if (!tracer->writeFile(options.traceFile)) {
+            std::fprintf(stderr, "cannot write trace %s\n", options.traceFile.c_str());
+            return 1;
+        }
+        std::printf("trace file=%s events=%zu dropped=%zu\n", options.traceFile.c_str(), tracer->getEventCount(),
+                    tracer->getDroppedCount());
+    }
+    return status;
+}
@@ -0,0 +1,161 @@
+#include "../../include/binary_io.h"
+#include <fstream>
+
+void ByteWriter::writeU16(uint16_t value) {
+    buffer.push_back(static_cast<uint8_t>(value));
+    buffer.push_back(static_cast<uint8_t>(value >> 8));
+}
+
+void ByteWriter::writeU32(uint32_t value) {
+    for (int shift = 0; shift < 32; shift += 8) {
+        buffer.push_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+void ByteWriter::writeU64(uint64_t value) {
+    for (int shift = 0; shift < 64; shift += 8) {
+        buffer.push_back(static_cast<uint8_t>(value >> shift));
+    }
+}
+
+void ByteWriter::writeBytes(const void *data, size_t size) {
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    buffer.insert(buffer.end(), bytes, bytes + size);
+}
+
+void ByteWriter::patchU32(size_t offset, uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        buffer[offset + i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+ByteReader::ByteReader(const void *data, size_t size)
+    : begin(static_cast<const uint8_t *>(data)), length(size), position(0), valid(true) {}
+
+bool ByteReader::require(size_t count) {
+    if (!valid || count > length - position) {
+        valid = false;
+        return false;
+    }
+    return true;
+}
+
+uint8_t ByteReader::readU8() {
+    if (!require(1)) return 0;
+    return begin[position++];
+}
+
+uint16_t ByteReader::readU16() {
+    if (!require(2)) return 0;
+    uint16_t value = static_cast<uint16_t>(begin[position] | (begin[position + 1] << 8));
+    position += 2;
+    return value;
+}
+
+uint32_t ByteReader::readU32() {
+    if (!require(4)) return 0;
+    uint32_t value = 0;
+    for (int i = 0; i < 4; ++i) {
+        value |= static_cast<uint32_t>(begin[position + i]) << (8 * i);
+    }
+    position += 4;
+    return value;
+}
+
+uint64_t ByteReader::readU64() {
+    if (!require(8)) return 0;
+    uint64_t value = 0;
+    for (int i = 0; i < 8; ++i) {
+        value |= static_cast<uint64_t>(begin[position + i]) << (8 * i);
+    }
+    position += 8;
+    return value;
+}
+
+const uint8_t *ByteReader::readBytes(size_t count) {
+    if (count == 0 || !require(count)) return nullptr;
+    const uint8_t *data = begin + position;
+    position += count;
+    return data;
+}
+
+bool ByteReader::seek(size_t offset) {
+    if (!valid || offset > length) {
+        valid = false;
+        return false;
+    }
+    position = offset;
+    return true;
+}
+
+namespace {
+
+// 8 张查找表：table[k][b] 为字节 b 之后再跟 k 个零字节的 CRC，一次处理 8 个字节
+struct Crc32Tables {
+    uint32_t table[8][256];
+
+    Crc32Tables() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc >> 1) ^ ((crc & 1) ? 0xEDB88320u : 0);
+            }
+            table[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (int k = 1; k < 8; ++k) {
+                table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xFF];
+            }
+        }
+    }
+};
+
+const Crc32Tables &crc32Tables() {
+    static const Crc32Tables tables;
+    return tables;
+}
+
+} // namespace
+
+uint32_t crc32(const void *data, size_t size, uint32_t crc) {
+    const uint32_t(*table)[256] = crc32Tables().table;
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    crc = ~crc;
+
+    while (size >= 8) {
+        uint32_t low = crc ^ (static_cast<uint32_t>(bytes[0]) | static_cast<uint32_t>(bytes[1]) << 8 |
+                              static_cast<uint32_t>(bytes[2]) << 16 | static_cast<uint32_t>(bytes[3]) << 24);
+        crc = table[7][low & 0xFF] ^ table[6][(low >> 8) & 0xFF] ^ table[5][(low >> 16) & 0xFF] ^ table[4][low >> 24] ^
+              table[3][bytes[4]] ^ table[2][bytes[5]] ^ table[1][bytes[6]] ^ table[0][bytes[7]];
+        bytes += 8;
+        size -= 8;
+    }
+    while (size-- > 0) {
+        crc = (crc >> 8) ^ table[0][(crc ^ *bytes++) & 0xFF];
+    }
+    return ~crc;
+}
+
+bool writeFileBytes(const std::string &filename, const std::vector<uint8_t> &bytes) {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    file.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+    return static_cast<bool>(file);
+}
+
+bool readFileBytes(const std::string &filename, std::vector<uint8_t> &bytes) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    if (!file.is_open()) {
+        return false;
+    }
+    std::streamoff size = file.tellg();
+    if (size < 0) {
+        return false;
+    }
+    bytes.resize(static_cast<size_t>(size));
+    file.seekg(0);
+    file.read(reinterpret_cast<char *>(bytes.data()), size);
+    return static_cast<bool>(file) || size == 0;
+}
@@ -0,0 +1,108 @@
+#include "../../include/bit_ops.h"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define PACMAN_AVX2_PATH 1
+#include <immintrin.h>
+#if defined(__GNUC__) || defined(__clang__)
+#define PACMAN_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#include <intrin.h>
+#define PACMAN_TARGET_AVX2
+#endif
+#endif
+
+namespace {
+
+using PopcountFn = uint64_t (*)(const uint64_t *, size_t);
+
+#ifdef PACMAN_AVX2_PATH
+// 半字节查表法（vpshufb）：每字节的置位数先在 8 位计数器中累加，
+// 最多 31 轮后用 vpsadbw 横向求和到 64 位，避免计数器溢出
+PACMAN_TARGET_AVX2 uint64_t popcountAvx2Impl(const uint64_t *words, size_t count) {
+    const __m256i lookup = _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, 0, 1, 1, 2, 1, 2, 2, 3, 1,
+                                            2, 2, 3, 2, 3, 3, 4);
+    const __m256i lowNibble = _mm256_set1_epi8(0x0F);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i total = zero;
+
+    size_t i = 0;
+    while (i + 4 <= count) {
+        __m256i bytes = zero;
+        for (int round = 0; round < 31 && i + 4 <= count; ++round, i += 4) {
+            __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(words + i));
+            __m256i lo = _mm256_and_si256(v, lowNibble);
+            __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), lowNibble);
+            bytes = _mm256_add_epi8(bytes,
+                                    _mm256_add_epi8(_mm256_shuffle_epi8(lookup, lo), _mm256_shuffle_epi8(lookup, hi)));
+        }
+        total = _mm256_add_epi64(total, _mm256_sad_epu8(bytes, zero));
+    }
+
+    uint64_t result = static_cast<uint64_t>(_mm256_extract_epi64(total, 0)) +
+                      static_cast<uint64_t>(_mm256_extract_epi64(total, 1)) +
+                      static_cast<uint64_t>(_mm256_extract_epi64(total, 2)) +
+                      static_cast<uint64_t>(_mm256_extract_epi64(total, 3));
+    for (; i < count; ++i) {
+        result += BitOps::popcount64(words[i]);
+    }
+    return result;
+}
+
+bool detectAvx2() {
+#if defined(__GNUC__) || defined(__clang__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    // CPUID.1:ECX.OSXSAVE[27] 且 XCR0 开启 YMM 状态，再检查 CPUID.7:EBX.AVX2[5]
+    int info[4];
+    __cpuid(info, 1);
+    if ((info[2] & (1 << 27)) == 0) return false;
+    if ((_xgetbv(0) & 0x6) != 0x6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#endif
+}
+#endif
+
+PopcountFn selectPopcount() {
+#ifdef PACMAN_AVX2_PATH
+    if (detectAvx2()) return popcountAvx2Impl;
+#endif
+    return BitOps::popcountPortable;
+}
+
+PopcountFn activePopcount() {
+    static const PopcountFn fn = selectPopcount();
+    return fn;
+}
+
+} // namespace
+
+uint64_t BitOps::popcountPortable(const uint64_t *words, size_t count) {
+    uint64_t result = 0;
+    for (size_t i = 0; i < count; ++i) {
+        result += popcount64(words[i]);
+    }
+    return result;
+}
+
+uint64_t BitOps::popcountAvx2(const uint64_t *words, size_t count) {
+#ifdef PACMAN_AVX2_PATH
+    return popcountAvx2Impl(words, count);
+#else
+    return popcountPortable(words, count);
+#endif
+}
+
+uint64_t BitOps::popcount(const uint64_t *words, size_t count) { return activePopcount()(words, count); }
+
+bool BitOps::hasAvx2() {
+#ifdef PACMAN_AVX2_PATH
+    static const bool supported = detectAvx2();
+    return supported;
+#else
+    return false;
+#endif
+}
+
+const char *BitOps::activeImplementation() { return activePopcount() == popcountPortable ? "portable" : "avx2"; }
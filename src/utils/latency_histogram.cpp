@@ -0,0 +1,76 @@
+#include "../../include/latency_histogram.h"
+#include "../../include/bit_ops.h"
+#include <algorithm>
+#include <cmath>
+
+LatencyHistogram::LatencyHistogram()
+    : counts(BUCKET_COUNT, 0), totalCount(0), minValue(UINT64_MAX), maxValue(0), sum(0.0) {}
+
+int LatencyHistogram::bucketIndex(uint64_t value) {
+    value = std::min<uint64_t>(value, (1ULL << MAX_VALUE_BITS) - 1);
+    if (value < 2 * SUB_BUCKET_COUNT) {
+        return static_cast<int>(value);
+    }
+    // 最高位为 m 的值落在第 m - SUB_BUCKET_BITS + 1 段，段内按去掉低 shift 位后的值选子桶
+    int shift = BitOps::highestSetBit(value) - SUB_BUCKET_BITS;
+    return (shift + 1) * SUB_BUCKET_COUNT + static_cast<int>(value >> shift) - SUB_BUCKET_COUNT;
+}
+
+uint64_t LatencyHistogram::bucketLowerBound(int index) {
+    if (index < 2 * SUB_BUCKET_COUNT) {
+        return static_cast<uint64_t>(index);
+    }
+    int shift = index / SUB_BUCKET_COUNT - 1;
+    return static_cast<uint64_t>(index % SUB_BUCKET_COUNT + SUB_BUCKET_COUNT) << shift;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(int index) {
+    if (index < 2 * SUB_BUCKET_COUNT) {
+        return static_cast<uint64_t>(index);
+    }
+    int shift = index / SUB_BUCKET_COUNT - 1;
+    return bucketLowerBound(index) + (1ULL << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t nanos) {
+    counts[bucketIndex(nanos)]++;
+    totalCount++;
+    minValue = std::min(minValue, nanos);
+    maxValue = std::max(maxValue, nanos);
+    sum += static_cast<double>(nanos);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other) {
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        counts[i] += other.counts[i];
+    }
+    totalCount += other.totalCount;
+    minValue = std::min(minValue, other.minValue);
+    maxValue = std::max(maxValue, other.maxValue);
+    sum += other.sum;
+}
+
+void LatencyHistogram::reset() {
+    std::fill(counts.begin(), counts.end(), 0);
+    totalCount = 0;
+    minValue = UINT64_MAX;
+    maxValue = 0;
+    sum = 0.0;
+}
+
+uint64_t LatencyHistogram::percentile(double quantile) const {
+    if (totalCount == 0) {
+        return 0;
+    }
+    quantile = std::min(std::max(quantile, 0.0), 1.0);
+    uint64_t target =
+        std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(quantile * static_cast<double>(totalCount))));
+    uint64_t seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; ++i) {
+        seen += counts[i];
+        if (seen >= target) {
+            return std::min(std::max(bucketUpperBound(i), getMin()), maxValue);
+        }
+    }
+    return maxValue;
+}
@@ -0,0 +1,98 @@
+#include "../../include/mapped_file.h"
+#include "../../include/binary_io.h"
+
+#ifdef _WIN32
+// 只需要文件和映射 API：不引入 winsock 等无关头文件，也不定义与 std::min/max 冲突的宏
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile()
+    : mappedData(nullptr), mappedSize(0)
+#ifdef _WIN32
+      ,
+      fileHandle(nullptr), mappingHandle(nullptr)
+#endif
+{
+}
+
+MappedFile::~MappedFile() { close(); }
+
+bool MappedFile::open(const std::string &filename, Access access) {
+    close();
+
+#ifdef _WIN32
+    DWORD accessHint = access == Access::RANDOM ? FILE_FLAG_RANDOM_ACCESS : FILE_FLAG_SEQUENTIAL_SCAN;
+    HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | accessHint, nullptr);
+    if (file != INVALID_HANDLE_VALUE) {
+        LARGE_INTEGER fileSize;
+        HANDLE mapping = nullptr;
+        if (GetFileSizeEx(file, &fileSize) && fileSize.QuadPart > 0) {
+            mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        }
+        void *view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (view != nullptr) {
+            fileHandle = file;
+            mappingHandle = mapping;
+            mappedData = static_cast<const uint8_t *>(view);
+            mappedSize = static_cast<size_t>(fileSize.QuadPart);
+            return true;
+        }
+        if (mapping != nullptr) {
+            CloseHandle(mapping);
+        }
+        CloseHandle(file);
+    }
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd >= 0) {
+        struct stat info;
+        void *view = MAP_FAILED;
+        if (fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0) {
+            view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        }
+        ::close(fd); // 映射建立后不再需要文件描述符
+        if (view != MAP_FAILED) {
+            madvise(view, static_cast<size_t>(info.st_size), access == Access::RANDOM ? MADV_RANDOM : MADV_SEQUENTIAL);
+            mappedData = static_cast<const uint8_t *>(view);
+            mappedSize = static_cast<size_t>(info.st_size);
+            return true;
+        }
+    }
+#endif
+
+    // 退回普通读取；空文件视为打开失败
+    if (!readFileBytes(filename, fallback) || fallback.empty()) {
+        fallback.clear();
+        return false;
+    }
+    return true;
+}
+
+void MappedFile::close() {
+    if (mappedData != nullptr) {
+#ifdef _WIN32
+        UnmapViewOfFile(mappedData);
+        CloseHandle(static_cast<HANDLE>(mappingHandle));
+        CloseHandle(static_cast<HANDLE>(fileHandle));
+        mappingHandle = nullptr;
+        fileHandle = nullptr;
+#else
+        munmap(const_cast<uint8_t *>(mappedData), mappedSize);
+#endif
+        mappedData = nullptr;
+        mappedSize = 0;
+    }
+    fallback.clear();
+}
@@ -0,0 +1,44 @@
+#include "../../include/profile_clock.h"
+#include <chrono>
+
+namespace {
+
+#ifdef PACMAN_PROFILE_CLOCK_TSC
+// 忙等约 5 毫秒，用两种时钟的读数之比求出计数频率
+double calibrateNanosPerTick() {
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point wallStart = Clock::now();
+    uint64_t tickStart = __rdtsc();
+    Clock::time_point wallEnd = wallStart;
+    while (wallEnd - wallStart < std::chrono::milliseconds(5)) {
+        wallEnd = Clock::now();
+    }
+    uint64_t ticks = __rdtsc() - tickStart;
+    double nanos =
+        static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(wallEnd - wallStart).count());
+    return ticks > 0 ? nanos / static_cast<double>(ticks) : 1.0;
+}
+#endif
+
+} // namespace
+
+namespace ProfileClock {
+
+double nanosPerTick() {
+#ifdef PACMAN_PROFILE_CLOCK_TSC
+    static const double value = calibrateNanosPerTick();
+    return value;
+#else
+    return 1.0;
+#endif
+}
+
+const char *source() {
+#ifdef PACMAN_PROFILE_CLOCK_TSC
+    return "tsc";
+#else
+    return "steady_clock";
+#endif
+}
+
+} // namespace ProfileClock
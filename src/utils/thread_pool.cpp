@@ -0,0 +1,114 @@
+#include "../../include/thread_pool.h"
+
+namespace {
+thread_local int tlsWorkerIndex = -1;
+thread_local const ThreadPool *tlsWorkerPool = nullptr;
+} // namespace
+
+ThreadPool::ThreadPool(int threadCount) : queuedTasks(0), pendingTasks(0), nextQueue(0), stopping(false) {
+    if (threadCount <= 0) {
+        threadCount = hardwareThreadCount();
+    }
+
+    for (int i = 0; i < threadCount; ++i) {
+        queues.push_back(std::make_unique<WorkerQueue>());
+    }
+    for (int i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    waitIdle();
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wakeCondition.notify_all();
+
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(Task task) {
+    // 工作线程内提交的任务放入自己的队列，保持缓存局部性；外部提交轮流分配
+    int index = (tlsWorkerPool == this) ? tlsWorkerIndex
+                                        : static_cast<int>(nextQueue.fetch_add(1) % static_cast<unsigned>(queues.size()));
+
+    pendingTasks.fetch_add(1);
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    {
+        // 在 sleepMutex 下增加计数，避免工作线程错过唤醒
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        queuedTasks.fetch_add(1);
+    }
+    wakeCondition.notify_one();
+}
+
+void ThreadPool::waitIdle() {
+    std::unique_lock<std::mutex> lock(sleepMutex);
+    idleCondition.wait(lock, [this] { return pendingTasks.load() == 0; });
+}
+
+bool ThreadPool::popTask(int index, Task &task) {
+    // 先从自己队列尾部取（后进先出）
+    {
+        WorkerQueue &own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+
+    // 再从其他线程队列头部窃取（先进先出）
+    int count = static_cast<int>(queues.size());
+    for (int offset = 1; offset < count; ++offset) {
+        WorkerQueue &victim = *queues[(index + offset) % count];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::workerLoop(int index) {
+    tlsWorkerIndex = index;
+    tlsWorkerPool = this;
+
+    while (true) {
+        Task task;
+        if (popTask(index, task)) {
+            queuedTasks.fetch_sub(1);
+            task();
+
+            if (pendingTasks.fetch_sub(1) == 1) {
+                std::lock_guard<std::mutex> lock(sleepMutex);
+                idleCondition.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeCondition.wait(lock, [this] { return stopping || queuedTasks.load() > 0; });
+        if (stopping && queuedTasks.load() == 0) {
+            return;
+        }
+    }
+}
+
+int ThreadPool::currentWorkerIndex() { return tlsWorkerIndex; }
+
+int ThreadPool::hardwareThreadCount() {
+    unsigned int count = std::thread::hardware_concurrency();
+    return count == 0 ? 1 : static_cast<int>(count);
+}
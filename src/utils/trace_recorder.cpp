@@ -0,0 +1,140 @@
+#include "../../include/trace_recorder.h"
+#include "../../include/thread_pool.h"
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+std::atomic<uint64_t> g_nextRecorderId{1};
+
+// 当前线程最近使用的缓冲区及其所属追踪器
+struct LocalTraceCache {
+    uint64_t recorderId;
+    void *buffer;
+};
+thread_local LocalTraceCache tlsTraceCache = {0, nullptr};
+
+void appendEscaped(std::string &out, const std::string &text) {
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            out += ' ';
+        } else {
+            out += c;
+        }
+    }
+}
+
+} // namespace
+
+std::atomic<TraceRecorder *> TraceRecorder::activeRecorder{nullptr};
+
+TraceRecorder::TraceRecorder(size_t maxEventsPerThread)
+    : recorderId(g_nextRecorderId.fetch_add(1)), startTicks(ProfileClock::now()),
+      maxEventsPerThread(maxEventsPerThread) {}
+
+TraceRecorder::~TraceRecorder() {
+    TraceRecorder *self = this;
+    activeRecorder.compare_exchange_strong(self, nullptr);
+}
+
+TraceRecorder::ThreadBuffer &TraceRecorder::localBuffer() {
+    if (tlsTraceCache.recorderId == recorderId) {
+        return *static_cast<ThreadBuffer *>(tlsTraceCache.buffer);
+    }
+    std::lock_guard<std::mutex> lock(registryMutex);
+    buffers.push_back(std::make_unique<ThreadBuffer>());
+    ThreadBuffer &buffer = *buffers.back();
+    buffer.threadId = static_cast<int>(buffers.size());
+    int worker = ThreadPool::currentWorkerIndex();
+    buffer.threadName = worker >= 0 ? "worker " + std::to_string(worker) : "thread " + std::to_string(buffer.threadId);
+    tlsTraceCache.recorderId = recorderId;
+    tlsTraceCache.buffer = &buffer;
+    return buffer;
+}
+
+void TraceRecorder::record(const char *name, const char *category, const char *argName, long long arg,
+                           uint64_t start, uint64_t end) {
+    ThreadBuffer &buffer = localBuffer();
+    if (buffer.count >= maxEventsPerThread) {
+        buffer.dropped++;
+        return;
+    }
+    size_t offset = buffer.count % CHUNK_EVENTS;
+    if (offset == 0) {
+        buffer.chunks.push_back(std::make_unique<Event[]>(CHUNK_EVENTS));
+    }
+    buffer.chunks.back()[offset] = Event{name, category, argName, arg, start, end};
+    buffer.count++;
+}
+
+void TraceRecorder::setThreadName(const std::string &name) { localBuffer().threadName = name; }
+
+size_t TraceRecorder::getEventCount() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    size_t total = 0;
+    for (const auto &buffer : buffers) {
+        total += buffer->count;
+    }
+    return total;
+}
+
+size_t TraceRecorder::getDroppedCount() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    size_t total = 0;
+    for (const auto &buffer : buffers) {
+        total += buffer->dropped;
+    }
+    return total;
+}
+
+void TraceRecorder::writeJson(std::ostream &out) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    double microsPerTick = ProfileClock::nanosPerTick() / 1000.0;
+    out << "{\"displayTimeUnit\": \"ns\", \"traceEvents\": [\n";
+    bool first = true;
+    char text[320];
+    for (const auto &buffer : buffers) {
+        std::string threadName;
+        appendEscaped(threadName, buffer->threadName);
+        out << (first ? "" : ",\n") << "{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": "
+            << buffer->threadId << ", \"args\": {\"name\": \"" << threadName << "\"}}";
+        first = false;
+
+        for (size_t i = 0; i < buffer->count; ++i) {
+            const Event &event = buffer->chunks[i / CHUNK_EVENTS][i % CHUNK_EVENTS];
+            // 时间戳以追踪器创建时刻为零点，单位微秒
+            double ts = static_cast<double>(static_cast<long long>(event.start - startTicks)) * microsPerTick;
+            double dur = static_cast<double>(event.end - event.start) * microsPerTick;
+            std::snprintf(text, sizeof(text),
+                          ",\n{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, "
+                          "\"pid\": 1, \"tid\": %d",
+                          event.name, event.category, ts, dur, buffer->threadId);
+            out << text;
+            if (event.argName) {
+                std::snprintf(text, sizeof(text), ", \"args\": {\"%s\": %lld}", event.argName, event.arg);
+                out << text;
+            }
+            out << '}';
+        }
+    }
+    out << "\n]}\n";
+}
+
+std::string TraceRecorder::toJson() {
+    std::ostringstream out;
+    writeJson(out);
+    return out.str();
+}
+
+bool TraceRecorder::writeFile(const std::string &path) {
+    std::ofstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    writeJson(file);
+    return static_cast<bool>(file);
+}